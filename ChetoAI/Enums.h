@@ -9,4 +9,10 @@ enum class ObjectType {
     Spin = 5,
     White = 6,
     Unknown = 7
-};
\ No newline at end of file
+};
+
+inline const char* objectTypeName(ObjectType type) {
+    static const char* names[] = { "Ball", "Force", "Guideline", "Hole", "PlayArea", "Spin", "White", "Unknown" };
+    const int index = static_cast<int>(type);
+    return index >= 0 && index <= static_cast<int>(ObjectType::Unknown) ? names[index] : "Unknown";
+}
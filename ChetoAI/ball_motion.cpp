@@ -0,0 +1,269 @@
+#include "ball_motion.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double infinity = 1.0e30;
+constexpr double slipEpsilon = 1.0e-6;  // Slip / speed (units/s) treated as zero
+constexpr double spinEpsilon = 1.0e-6;  // rad/s
+constexpr double timeEpsilon = 1.0e-9;  // Ignore contacts at the very start of a segment
+
+double sign(double v) {
+    return v > 0.0 ? 1.0 : (v < 0.0 ? -1.0 : 0.0);
+}
+
+// Earliest cushion contact within the segment: the centre crosses the line one radius inside
+// the cushion while moving towards it, and the contact falls on the cushion, not a pocket mouth
+int firstCushion(const MotionSegment& s, const SimTable& table, const MotionParams& params, double& when) {
+    int best = -1;
+    const double radius = params.radius;
+    const double pocketR2 = static_cast<double>(params.pocketRadius) * params.pocketRadius;
+    for (int k = 0; k < table.cushionCount; ++k) {
+        const SimCushion& e = table.cushions[k];
+        const double c[3] = { e.nx * (s.start.x - e.x0) + e.ny * (s.start.y - e.y0) - radius,
+                              e.nx * s.start.vx + e.ny * s.start.vy,
+                              0.5 * (e.nx * s.ax + e.ny * s.ay) };
+        if (c[0] < -radius) continue; // Behind this cushion (e.g. the far side of a pocket mouth)
+        // Crossings while leaving (just after a bounce off this cushion) are skipped
+        const double hi = std::min(s.duration, when);
+        double t, lo = timeEpsilon;
+        BallState p;
+        bool found = false;
+        while (!found && smallestRoot(c, 2, lo, hi, t)) {
+            p = stateAt(s, t);
+            found = e.nx * p.vx + e.ny * p.vy < 0.0;
+            lo = t + timeEpsilon;
+        }
+        if (!found) continue;
+        const double ex = e.x1 - e.x0, ey = e.y1 - e.y0;
+        const double length2 = ex * ex + ey * ey;
+        if (length2 <= 0.0) continue;
+        const double along = ((p.x - e.x0) * ex + (p.y - e.y0) * ey) / length2;
+        const double slack = radius / std::sqrt(length2);
+        if (along < -slack || along > 1.0 + slack) continue;
+        bool inMouth = false;
+        for (int q = 0; q < table.pocketCount && !inMouth; ++q) {
+            const double qx = p.x - table.pocketX[q], qy = p.y - table.pocketY[q];
+            inMouth = qx * qx + qy * qy <= pocketR2;
+        }
+        if (inMouth) continue;
+        best = k;
+        when = t;
+    }
+    return best;
+}
+
+// Earliest time the centre enters a pocket's capture circle
+int firstPocket(const MotionSegment& s, const SimTable& table, const MotionParams& params, double& when) {
+    int best = -1;
+    const double r2 = static_cast<double>(params.pocketRadius) * params.pocketRadius;
+    for (int q = 0; q < table.pocketCount; ++q) {
+        // |d + v t + a t^2 / 2|^2 - r^2
+        const double dx = s.start.x - table.pocketX[q], dy = s.start.y - table.pocketY[q];
+        const double hx = 0.5 * s.ax, hy = 0.5 * s.ay;
+        const double c[5] = { dx * dx + dy * dy - r2,
+                              2.0 * (dx * s.start.vx + dy * s.start.vy),
+                              s.start.vx * s.start.vx + s.start.vy * s.start.vy + 4.0 * (dx * hx + dy * hy),
+                              4.0 * (s.start.vx * hx + s.start.vy * hy),
+                              4.0 * (hx * hx + hy * hy) };
+        double t;
+        if (c[0] <= 0.0) t = 0.0;
+        else if (!smallestRoot(c, 4, 0.0, std::min(s.duration, when), t)) continue;
+        if (t > when) continue;
+        best = q;
+        when = t;
+    }
+    return best;
+}
+
+} // namespace
+
+BallState strikeBall(double x, double y, double dirX, double dirY, double speed, double side, double follow,
+                     double radius) {
+    BallState s;
+    s.x = x;
+    s.y = y;
+    const double length = std::sqrt(dirX * dirX + dirY * dirY);
+    if (length <= 0.0 || radius <= 0.0) return s;
+    const double ux = dirX / length, uy = dirY / length;
+    side = std::min(0.5, std::max(-0.5, side));
+    follow = std::min(0.5, std::max(-0.5, follow));
+    s.vx = ux * speed;
+    s.vy = uy * speed;
+    // Tip offset b (fraction of R) gives spin 5 v b / 2R; rolling spin is z x v / R, so b = 0.4 rolls
+    const double roll = 2.5 * speed * follow / radius;
+    s.wx = -uy * roll;
+    s.wy = ux * roll;
+    s.wz = -2.5 * speed * side / radius;
+    return s;
+}
+
+MotionSegment freeSegment(const BallState& state, double t0, const MotionParams& params) {
+    MotionSegment s;
+    s.t0 = t0;
+    s.start = state;
+    const double radius = params.radius;
+    const double speed = std::sqrt(state.vx * state.vx + state.vy * state.vy);
+    const double slipX = state.vx - radius * state.wy, slipY = state.vy + radius * state.wx;
+    const double slip = std::sqrt(slipX * slipX + slipY * slipY);
+
+    double phaseTime;
+    if (slip > slipEpsilon) {
+        // Friction against the slip direction, torque about the contact point
+        const double ux = slipX / slip, uy = slipY / slip;
+        const double decel = params.slidingDecel;
+        s.phase = MotionPhase::Sliding;
+        s.ax = -decel * ux;
+        s.ay = -decel * uy;
+        s.awx = -2.5 * decel / radius * uy;
+        s.awy = 2.5 * decel / radius * ux;
+        phaseTime = slip / (3.5 * decel);
+    }
+    else if (speed > slipEpsilon) {
+        const double decel = params.rollingDecel;
+        s.phase = MotionPhase::Rolling;
+        s.ax = -decel * state.vx / speed;
+        s.ay = -decel * state.vy / speed;
+        s.awx = -s.ay / radius;
+        s.awy = s.ax / radius;
+        phaseTime = speed / decel;
+    }
+    else if (std::abs(state.wz) > spinEpsilon) {
+        s.phase = MotionPhase::Spinning;
+        phaseTime = std::abs(state.wz) / params.spinDecel;
+    }
+    else {
+        s.phase = MotionPhase::Stationary;
+        s.endsPhase = true;
+        return s;
+    }
+
+    const double spinTime = std::abs(state.wz) > spinEpsilon ? std::abs(state.wz) / params.spinDecel : infinity;
+    s.awz = std::abs(state.wz) > spinEpsilon ? -sign(state.wz) * params.spinDecel : 0.0;
+    s.duration = std::min(phaseTime, spinTime);
+    s.endsPhase = phaseTime <= spinTime;
+    s.endsSpin = spinTime <= phaseTime;
+    return s;
+}
+
+BallState stateAt(const MotionSegment& segment, double t) {
+    const BallState& s = segment.start;
+    BallState out;
+    out.x = s.x + (s.vx + 0.5 * segment.ax * t) * t;
+    out.y = s.y + (s.vy + 0.5 * segment.ay * t) * t;
+    out.vx = s.vx + segment.ax * t;
+    out.vy = s.vy + segment.ay * t;
+    out.wx = s.wx + segment.awx * t;
+    out.wy = s.wy + segment.awy * t;
+    out.wz = s.wz + segment.awz * t;
+    return out;
+}
+
+BallState segmentEnd(const MotionSegment& segment, const MotionParams& params) {
+    BallState end = stateAt(segment, segment.duration);
+    if (segment.endsSpin) end.wz = 0.0;
+    if (!segment.endsPhase) return end;
+    switch (segment.phase) {
+    case MotionPhase::Sliding:
+        // Slip is gone: lock the rolling spin to the velocity
+        end.wx = -end.vy / params.radius;
+        end.wy = end.vx / params.radius;
+        break;
+    case MotionPhase::Rolling:
+        end.vx = end.vy = 0.0;
+        end.wx = end.wy = 0.0;
+        break;
+    case MotionPhase::Spinning:
+        end.wz = 0.0;
+        break;
+    case MotionPhase::Stationary:
+        break;
+    }
+    return end;
+}
+
+BallState cushionBounce(const BallState& state, double nx, double ny, const MotionParams& params) {
+    BallState out = state;
+    const double radius = params.radius;
+    const double vn = state.vx * nx + state.vy * ny;
+    if (vn >= 0.0) return out;
+
+    // Tangent t = z x n. The contact point sits at -R n, so side spin adds -R wz to its speed along t
+    const double tx = -ny, ty = nx;
+    const double normal = -(1.0 + params.cushionRestitution) * vn;     // Normal impulse / mass
+    const double slip = state.vx * tx + state.vy * ty - radius * state.wz;
+    // Friction impulse / mass: enough to stop the slip (2/7 of it for a solid ball), capped by Coulomb
+    const double tangential = -sign(slip) * std::min(params.cushionFriction * normal, std::abs(slip) / 3.5);
+    out.vx += normal * nx + tangential * tx;
+    out.vy += normal * ny + tangential * ty;
+    out.wz -= 2.5 * tangential / radius;
+    return out;
+}
+
+BallState trajectoryAt(const Trajectory& trajectory, double t) {
+    if (trajectory.count == 0) return BallState();
+    int i = 0;
+    while (i + 1 < trajectory.count && trajectory.segments[i + 1].t0 <= t) ++i;
+    const MotionSegment& segment = trajectory.segments[i];
+    return stateAt(segment, std::min(std::max(t - segment.t0, 0.0), segment.duration));
+}
+
+void planTrajectory(const BallState& start, const SimTable& table, const MotionParams& params, Trajectory& out) {
+    CHETO_TRACE_SCOPE("trajectory");
+    out.count = 0;
+    out.cushionHits = 0;
+    out.pocket = -1;
+    out.truncated = false;
+    out.endTime = 0.0;
+
+    BallState state = start;
+    double now = 0.0;
+    for (;;) {
+        if (out.count == motionMaxSegments) {
+            out.truncated = true;
+            break;
+        }
+        MotionSegment segment = freeSegment(state, now, params);
+        if (segment.phase == MotionPhase::Stationary) {
+            out.segments[out.count++] = segment;
+            break;
+        }
+        if (now + segment.duration > params.maxTime) {
+            segment.duration = params.maxTime - now;
+            segment.endsPhase = segment.endsSpin = false;
+            out.truncated = true;
+        }
+
+        // Cut the segment at the first cushion or pocket on it
+        double when = segment.duration;
+        const int cushion = firstCushion(segment, table, params, when);
+        const int pocket = firstPocket(segment, table, params, when);
+        if (pocket >= 0) {
+            segment.duration = when;
+            segment.endsPhase = segment.endsSpin = false;
+            out.segments[out.count++] = segment;
+            out.pocket = pocket;
+            now += when;
+            break;
+        }
+        if (cushion >= 0) {
+            segment.duration = when;
+            segment.endsPhase = segment.endsSpin = false;
+            segment.cushion = cushion;
+            out.segments[out.count++] = segment;
+            const SimCushion& e = table.cushions[cushion];
+            state = cushionBounce(stateAt(segment, when), e.nx, e.ny, params);
+            ++out.cushionHits;
+            now += when;
+            continue;
+        }
+
+        out.segments[out.count++] = segment;
+        now += segment.duration;
+        if (out.truncated) break;
+        state = segmentEnd(segment, params);
+    }
+    out.endTime = now;
+}
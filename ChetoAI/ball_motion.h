@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include "simulation.h"
+
+// Single-ball motion with friction and spin as piecewise closed-form segments,
+// so a whole shot is a handful of segment evaluations instead of small-step
+// integration. Plain doubles, fixed capacity, no allocation.
+//
+// Phases (the usual billiard-ball model):
+//   sliding:  the contact point slips at u = v + w x r. Friction slidingDecel
+//             acts against u, whose direction stays fixed, so v changes
+//             linearly and the centre follows a parabola. It ends when u
+//             reaches 0, after 2|u0| / (7 slidingDecel).
+//   rolling:  v (and the spin locked to it) decays at rollingDecel along v and
+//             the path is straight until v = 0.
+//   spinning: only side spin (about the vertical) is left.
+// Side spin decays at spinDecel in every phase; a segment also ends where it
+// reaches zero. At a cushion the normal velocity reverses with restitution
+// and a friction impulse at the contact point (capped by cushionFriction)
+// trades tangential speed against side spin. That is the cushion "throw",
+// and the ball leaves the cushion sliding.
+
+constexpr int motionMaxSegments = 64;
+
+struct MotionParams {
+    float radius = 12.0f;
+    float slidingDecel = 800.0f;       // mu_s * g, units/s^2
+    float rollingDecel = 300.0f;       // mu_r * g, units/s^2 (same as SimParams::rollingDecel)
+    float spinDecel = 38.0f;           // Side-spin decay, rad/s^2 (5 mu_sp g / 2R for a real ball)
+    float cushionRestitution = 0.75f;
+    float cushionFriction = 0.2f;      // Tangential impulse <= this * normal impulse
+    float pocketRadius = 20.0f;        // Centre within this of a pocket centre = pocketed
+    double maxTime = 20.0;
+};
+
+// Centre position and velocity in table units; spin in rad/s about the table x / y axes and
+// the vertical (wz, side spin)
+struct BallState {
+    double x = 0.0, y = 0.0;
+    double vx = 0.0, vy = 0.0;
+    double wx = 0.0, wy = 0.0, wz = 0.0;
+};
+
+enum class MotionPhase : uint8_t { Sliding, Rolling, Spinning, Stationary };
+
+// `start` plus constant linear and angular acceleration, valid for `duration` seconds from t0
+struct MotionSegment {
+    MotionPhase phase = MotionPhase::Stationary;
+    double t0 = 0.0, duration = 0.0;
+    BallState start;
+    double ax = 0.0, ay = 0.0;
+    double awx = 0.0, awy = 0.0, awz = 0.0;
+    bool endsPhase = false;            // Runs to the phase change (slide -> roll, roll -> stop, ...)
+    bool endsSpin = false;             // Side spin reaches zero at the end
+    int cushion = -1;                  // Cushion hit at the end, -1 if none
+};
+
+struct Trajectory {
+    int count = 0;
+    MotionSegment segments[motionMaxSegments];
+    int cushionHits = 0;
+    int pocket = -1;                   // Pocket the ball ends in, -1 if none
+    bool truncated = false;            // Hit maxTime or the segment capacity
+    double endTime = 0.0;
+};
+
+// Cue strike at `speed` along (dirX, dirY). `side` / `follow` are the tip offset from centre as a
+// fraction of the radius (right english and top spin positive), clamped to +-0.5; follow = 0.4
+// rolls naturally from the start, 0 is a stun, negative is draw.
+BallState strikeBall(double x, double y, double dirX, double dirY, double speed, double side, double follow,
+                     double radius);
+
+// Segment of a free ball from `state` up to its next phase change or side-spin stop
+MotionSegment freeSegment(const BallState& state, double t0, const MotionParams& params);
+
+// Closed-form state `t` seconds into a segment (0 <= t <= duration)
+BallState stateAt(const MotionSegment& segment, double t);
+
+// State at the end of a free segment, with the finished phase snapped exactly (no slip after
+// sliding, no velocity after rolling, no side spin when it ran out)
+BallState segmentEnd(const MotionSegment& segment, const MotionParams& params);
+
+// Velocity and side spin after a cushion contact; (nx, ny) is the cushion normal into the table
+BallState cushionBounce(const BallState& state, double nx, double ny, const MotionParams& params);
+
+// Path of one ball on `table` through phase changes and cushion bounces, until it rests, drops
+// into a pocket or hits a limit. Other balls are not considered.
+void planTrajectory(const BallState& start, const SimTable& table, const MotionParams& params, Trajectory& out);
+
+// State at time `t` of a planned path (clamped to its start and end)
+BallState trajectoryAt(const Trajectory& trajectory, double t);
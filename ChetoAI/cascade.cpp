@@ -0,0 +1,137 @@
+#include "cascade.h"
+#include "latency_stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+CascadeDetector::CascadeDetector(DetectFn fast, DetectFn heavy, CascadeConfig config)
+    : fast(std::move(fast)),
+      heavy(std::move(heavy)),
+      config(config),
+      changeDetector(config.change) {
+}
+
+void CascadeDetector::reset() {
+    changeDetector.reset();
+    heavyDetections.clear();
+    hasHeavy = false;
+    framesSinceHeavy = 0;
+    ballMismatch = 0;
+    lastTrigger = CascadeTrigger::None;
+}
+
+std::vector<Detection> CascadeDetector::run(const cv::Mat& frame, const FrameChanges& changes) {
+    CHETO_TRACE_SCOPE("cascade");
+    auto t0 = std::chrono::steady_clock::now();
+    ++counters.frames;
+
+    const ChangeMap& changeMap = changeDetector.update(frame, changes);
+    if (dirty.tiles.size() != changeMap.tiles.size()) {
+        dirty = changeMap;
+    }
+    else {
+        for (size_t i = 0; i < dirty.tiles.size(); ++i) dirty.tiles[i] |= changeMap.tiles[i];
+    }
+    const int tileCount = changeMap.cols * changeMap.rows;
+
+    lastTrigger = CascadeTrigger::None;
+    if (!hasHeavy || frame.size() != heavySize)
+        lastTrigger = CascadeTrigger::First;
+    else if (config.heavyInterval > 0 && framesSinceHeavy >= config.heavyInterval)
+        lastTrigger = CascadeTrigger::Interval;
+    else if (tileCount > 0 && changeMap.changedTiles >= config.sceneChangeFraction * tileCount)
+        lastTrigger = CascadeTrigger::SceneChange;
+    else if (config.ballCountFrames > 0 && ballMismatch >= config.ballCountFrames)
+        lastTrigger = CascadeTrigger::BallCount;
+
+    auto t1 = std::chrono::steady_clock::now();
+    counters.cascadeUs += elapsedUs(t0, t1);
+
+    if (lastTrigger != CascadeTrigger::None) {
+        heavyDetections = heavy(frame);
+        counters.heavyUs += elapsedUs(t1, std::chrono::steady_clock::now());
+        ++counters.heavyRuns;
+        ++counters.triggers[static_cast<int>(lastTrigger)];
+        hasHeavy = true;
+        heavySize = frame.size();
+        framesSinceHeavy = 0;
+        heavyBalls = ballCount(heavyDetections);
+        ballMismatch = 0;
+        std::fill(dirty.tiles.begin(), dirty.tiles.end(), 0);
+        return heavyDetections;
+    }
+
+    const std::vector<Detection> fastDetections = fast(frame);
+    auto t2 = std::chrono::steady_clock::now();
+    counters.fastUs += elapsedUs(t1, t2);
+    ++counters.fastRuns;
+    ++framesSinceHeavy;
+    ballMismatch = ballCount(fastDetections) != heavyBalls ? ballMismatch + 1 : 0;
+
+    std::vector<Detection> merged;
+    merge(fastDetections, merged);
+    counters.cascadeUs += elapsedUs(t2, std::chrono::steady_clock::now());
+    return merged;
+}
+
+// Heavy non-fast classes, then this frame's fast classes, then heavy detections of keepClasses in
+// untouched areas that no fast detection of the same class overlaps
+void CascadeDetector::merge(const std::vector<Detection>& fastDetections, std::vector<Detection>& out) {
+    out.clear();
+    out.reserve(heavyDetections.size() + fastDetections.size());
+    for (const Detection& det : heavyDetections)
+        if (!isFastClass(det.type)) out.push_back(det);
+    for (const Detection& det : fastDetections)
+        if (isFastClass(det.type)) out.push_back(det);
+    for (const Detection& det : heavyDetections) {
+        if (!isFastClass(det.type) || !isKeptClass(det.type) || dirty.changedIn(det.box)) continue;
+        bool matched = false;
+        for (const Detection& f : fastDetections)
+            matched = matched || (f.type == det.type && boxIoU(f.box, det.box) >= config.matchIoU);
+        if (matched) continue;
+        out.push_back(det);
+        ++counters.keptDetections;
+    }
+}
+
+bool CascadeDetector::isFastClass(ObjectType type) const {
+    return std::find(config.fastClasses.begin(), config.fastClasses.end(), type) != config.fastClasses.end();
+}
+
+bool CascadeDetector::isKeptClass(ObjectType type) const {
+    return std::find(config.keepClasses.begin(), config.keepClasses.end(), type) != config.keepClasses.end();
+}
+
+int CascadeDetector::ballCount(const std::vector<Detection>& detections) const {
+    int count = 0;
+    for (const Detection& det : detections)
+        if (det.type == ObjectType::Ball || det.type == ObjectType::White) ++count;
+    return count;
+}
+
+const char* cascadeTriggerName(CascadeTrigger trigger) {
+    static const char* names[] = { "none", "first frame", "interval", "scene change", "ball count" };
+    const int index = static_cast<int>(trigger);
+    return index >= 0 && index < static_cast<int>(CascadeTrigger::Count) ? names[index] : "none";
+}
+
+bool parseObjectTypes(const char* text, std::vector<ObjectType>& types) {
+    types.clear();
+    while (*text) {
+        const char* end = std::strchr(text, ',');
+        const size_t length = end ? static_cast<size_t>(end - text) : std::strlen(text);
+        bool found = false;
+        for (int i = 0; i <= static_cast<int>(ObjectType::Unknown) && !found; ++i) {
+            const char* name = objectTypeName(static_cast<ObjectType>(i));
+            if (std::strlen(name) == length && std::strncmp(name, text, length) == 0) {
+                types.push_back(static_cast<ObjectType>(i));
+                found = true;
+            }
+        }
+        if (!found) return false;
+        text += length;
+        if (*text == ',') ++text;
+    }
+    return !types.empty();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "change_detector.h"
+#include "detection.h"
+#include "frame_source.h"
+
+struct CascadeConfig {
+    ChangeDetectorConfig change;
+    // Classes taken from the fast model on every frame; everything else comes from the last heavy run
+    std::vector<ObjectType> fastClasses = { ObjectType::White, ObjectType::Ball, ObjectType::Guideline };
+    // Fast classes whose heavy detections are kept while their area is unchanged and the fast model
+    // has no match there, so a ball the small model misses does not drop out between heavy runs
+    std::vector<ObjectType> keepClasses = { ObjectType::White, ObjectType::Ball };
+    int heavyInterval = 60;             // Heavy run at least every N frames; 0 = only on triggers
+    float sceneChangeFraction = 0.3f;   // Share of tiles changed in one frame that counts as a new scene
+    int ballCountFrames = 5;            // Consecutive frames the fast ball count must differ from the
+                                        // heavy one before a refresh (e.g. a ball was potted)
+    float matchIoU = 0.3f;              // Fast vs kept heavy detection of the same class
+};
+
+enum class CascadeTrigger { None, First, Interval, SceneChange, BallCount, Count };
+
+struct CascadeStats {
+    uint64_t frames = 0;
+    uint64_t heavyRuns = 0;
+    uint64_t fastRuns = 0;
+    uint64_t triggers[static_cast<int>(CascadeTrigger::Count)] = {};
+    uint64_t keptDetections = 0;        // Heavy detections carried over (see keepClasses)
+    double heavyUs = 0.0;               // Total time in each detector
+    double fastUs = 0.0;
+    double cascadeUs = 0.0;             // Total time deciding and merging
+
+    double meanFrameUs() const { return frames ? (heavyUs + fastUs + cascadeUs) / frames : 0.0; }
+};
+
+// Two-tier detector: a small, fast model finds the moving things (balls, guideline) on every frame,
+// and the full segmentation model runs only on the first frame, every `heavyInterval` frames, on a
+// scene change, or when the fast ball count disagrees with the heavy one for a while. Output merges
+// the fast classes from this frame with the rest (pockets, play area, ...) from the last heavy run,
+// in one detection list for processDetections. Heavy frames return the heavy result alone.
+class CascadeDetector {
+public:
+    using DetectFn = std::function<std::vector<Detection>(const cv::Mat& frame)>;
+
+    CascadeDetector(DetectFn fast, DetectFn heavy, CascadeConfig config = {});
+
+    std::vector<Detection> run(const cv::Mat& frame, const FrameChanges& changes = {});
+
+    bool lastHeavy() const { return lastTrigger != CascadeTrigger::None; }
+    CascadeTrigger lastReason() const { return lastTrigger; }
+    const CascadeStats& stats() const { return counters; }
+    void reset();
+
+private:
+    bool isFastClass(ObjectType type) const;
+    bool isKeptClass(ObjectType type) const;
+    int ballCount(const std::vector<Detection>& detections) const;
+    void merge(const std::vector<Detection>& fast, std::vector<Detection>& out);
+
+    DetectFn fast;
+    DetectFn heavy;
+    CascadeConfig config;
+    ChangeDetector changeDetector;
+    CascadeStats counters;
+
+    std::vector<Detection> heavyDetections;
+    cv::Size heavySize;
+    ChangeMap dirty;                    // Tiles changed since the last heavy run
+    int framesSinceHeavy = 0;
+    int heavyBalls = 0;
+    int ballMismatch = 0;
+    bool hasHeavy = false;
+    CascadeTrigger lastTrigger = CascadeTrigger::None;
+};
+
+const char* cascadeTriggerName(CascadeTrigger trigger);
+// "White,Ball,Guideline" -> ObjectTypes (names as in Enums.h); false on an unknown name
+bool parseObjectTypes(const char* text, std::vector<ObjectType>& types);
@@ -0,0 +1,187 @@
+#include "change_detector.h"
+#include "latency_stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+bool ChangeMap::changedIn(const cv::Rect& frameRect) const {
+    if (tilePixels <= 0 || frameRect.empty()) return false;
+    const int x0 = std::max(0, frameRect.x / tilePixels);
+    const int y0 = std::max(0, frameRect.y / tilePixels);
+    const int x1 = std::min(cols - 1, (frameRect.x + frameRect.width - 1) / tilePixels);
+    const int y1 = std::min(rows - 1, (frameRect.y + frameRect.height - 1) / tilePixels);
+    for (int ty = y0; ty <= y1; ++ty)
+        for (int tx = x0; tx <= x1; ++tx)
+            if (tiles[ty * cols + tx]) return true;
+    return false;
+}
+
+ChangeDetector::ChangeDetector(ChangeDetectorConfig config)
+    : config(config) {
+}
+
+void ChangeDetector::reset() {
+    reference.release();
+    frameSize = cv::Size();
+}
+
+void ChangeDetector::buildThumbnail(const cv::Mat& frame, cv::Mat& out) {
+    const int block = std::max(1, config.blockSize);
+    cv::resize(frame, scratch, cv::Size(frame.cols / block, frame.rows / block), 0, 0, cv::INTER_AREA);
+    if (scratch.channels() == 4) cv::cvtColor(scratch, out, cv::COLOR_BGRA2GRAY);
+    else if (scratch.channels() == 3) cv::cvtColor(scratch, out, cv::COLOR_BGR2GRAY);
+    else scratch.copyTo(out);
+}
+
+const ChangeMap& ChangeDetector::update(const cv::Mat& frame, const FrameChanges& hint, const cv::Rect& watch) {
+    CHETO_TRACE_SCOPE("changeDetect");
+    const int block = std::max(1, config.blockSize);
+    const int tile = std::max(1, config.tileSize);
+    const int thumbCols = frame.cols / block;
+    const int thumbRows = frame.rows / block;
+
+    map.tilePixels = tile * block;
+    map.cols = (thumbCols + tile - 1) / tile;
+    map.rows = (thumbRows + tile - 1) / tile;
+    map.tiles.assign(static_cast<size_t>(map.cols) * map.rows, 0);
+    map.changedTiles = 0;
+
+    const cv::Rect frameRect(0, 0, frame.cols, frame.rows);
+    const cv::Rect watchRect = watch.empty() ? frameRect : (watch & frameRect);
+
+    // First frame (or new resolution): everything is new
+    if (reference.empty() || frame.size() != frameSize) {
+        frameSize = frame.size();
+        buildThumbnail(frame, reference);
+        for (int ty = 0; ty < map.rows; ++ty) {
+            for (int tx = 0; tx < map.cols; ++tx) {
+                cv::Rect tileRect(tx * map.tilePixels, ty * map.tilePixels, map.tilePixels, map.tilePixels);
+                if ((tileRect & watchRect).empty()) continue;
+                map.tiles[ty * map.cols + tx] = 1;
+                ++map.changedTiles;
+            }
+        }
+        return map;
+    }
+
+    // The source vouches that everything outside its dirty rects is untouched
+    if (hint.known) {
+        bool relevant = false;
+        for (const cv::Rect& r : hint.regions) {
+            if (!(r & watchRect).empty()) {
+                relevant = true;
+                break;
+            }
+        }
+        if (!relevant) return map;
+    }
+
+    buildThumbnail(frame, current);
+
+    for (int ty = 0; ty < map.rows; ++ty) {
+        for (int tx = 0; tx < map.cols; ++tx) {
+            const cv::Rect tileRect(tx * map.tilePixels, ty * map.tilePixels, map.tilePixels, map.tilePixels);
+            if ((tileRect & watchRect).empty()) continue;
+            if (hint.known) {
+                bool dirty = false;
+                for (const cv::Rect& r : hint.regions) {
+                    if (!(r & tileRect).empty()) {
+                        dirty = true;
+                        break;
+                    }
+                }
+                if (!dirty) continue;
+            }
+
+            const int x0 = tx * tile;
+            const int y0 = ty * tile;
+            const int x1 = std::min(x0 + tile, thumbCols);
+            const int y1 = std::min(y0 + tile, thumbRows);
+            int changedPixels = 0;
+            for (int y = y0; y < y1 && changedPixels < config.minChangedPixels; ++y) {
+                const unsigned char* cur = current.ptr<unsigned char>(y);
+                const unsigned char* ref = reference.ptr<unsigned char>(y);
+                for (int x = x0; x < x1; ++x)
+                    if (std::abs(int(cur[x]) - int(ref[x])) > config.lumaThreshold) ++changedPixels;
+            }
+            if (changedPixels < config.minChangedPixels) continue;
+
+            map.tiles[ty * map.cols + tx] = 1;
+            ++map.changedTiles;
+            for (int y = y0; y < y1; ++y)
+                std::copy(current.ptr<unsigned char>(y) + x0, current.ptr<unsigned char>(y) + x1,
+                          reference.ptr<unsigned char>(y) + x0);
+        }
+    }
+    return map;
+}
+
+GatedDetector::GatedDetector(DetectFn detect, GateConfig config, RegionFn watchRegion)
+    : detect(std::move(detect)),
+      config(config),
+      watchRegion(std::move(watchRegion)),
+      changeDetector(config.change) {
+}
+
+void GatedDetector::reset() {
+    changeDetector.reset();
+    previous.clear();
+    hasPrevious = false;
+    reused = false;
+    reuseCount = 0;
+}
+
+std::vector<Detection> GatedDetector::run(const cv::Mat& frame, const FrameChanges& changes) {
+    auto t0 = std::chrono::steady_clock::now();
+    ++counters.frames;
+    reused = false;
+
+    // A moved watch region (e.g. table re-lock) invalidates what we have
+    const cv::Rect watch = watchRegion ? watchRegion() : cv::Rect();
+    const bool watchMoved = watch != previousWatch;
+    const bool resized = frame.size() != previousSize;
+    previousWatch = watch;
+    previousSize = frame.size();
+
+    const ChangeMap& changeMap = changeDetector.update(frame, changes, watch);
+    const bool mustRun = !hasPrevious || watchMoved || resized || changeMap.anyChanged()
+        || reuseCount >= config.maxReuseFrames;
+
+    auto t1 = std::chrono::steady_clock::now();
+    counters.gateUs += elapsedUs(t0, t1);
+
+    if (!mustRun) {
+        ++counters.skipped;
+        ++reuseCount;
+        reused = true;
+        return previous;
+    }
+
+    std::vector<Detection> detections = detect(frame);
+    counters.inferenceUs += elapsedUs(t1, std::chrono::steady_clock::now());
+    ++counters.inferred;
+    reuseCount = 0;
+
+    if (hasPrevious && !watchMoved && !resized) keepStableDetections(detections, changeMap);
+    previous = detections;
+    hasPrevious = true;
+    return detections;
+}
+
+void GatedDetector::keepStableDetections(std::vector<Detection>& detections, const ChangeMap& changeMap) const {
+    for (auto& det : detections) {
+        if (changeMap.changedIn(det.box)) continue;
+        const Detection* match = nullptr;
+        float bestIoU = config.stableIoU;
+        for (const auto& old : previous) {
+            if (old.type != det.type) continue;
+            float iou = boxIoU(old.box, det.box);
+            if (iou >= bestIoU) {
+                bestIoU = iou;
+                match = &old;
+            }
+        }
+        if (match) det = *match;
+    }
+}
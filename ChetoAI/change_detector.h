@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+#include "frame_source.h"
+
+struct ChangeDetectorConfig {
+    int blockSize = 4;          // Frame pixels per luma thumbnail pixel (area average)
+    int tileSize = 16;          // Thumbnail pixels per tile side (64x64 frame pixels by default)
+    int lumaThreshold = 10;     // Per thumbnail pixel, 0..255
+    int minChangedPixels = 2;   // Per tile; filters single-pixel noise (e.g. video compression)
+};
+
+// Which tiles of the frame changed since the previous update()
+struct ChangeMap {
+    int cols = 0;
+    int rows = 0;
+    int tilePixels = 0;         // Tile side in frame pixels
+    int changedTiles = 0;
+    std::vector<unsigned char> tiles; // 1 = changed, row-major cols x rows
+
+    bool anyChanged() const { return changedTiles > 0; }
+    bool changedIn(const cv::Rect& frameRect) const; // Any changed tile overlapping the rect
+};
+
+// Cheap frame-to-frame change detection on a block-averaged luma thumbnail.
+// When the capture source reports dirty rects, areas outside them are known to
+// be unchanged and the thumbnail is not even rebuilt if nothing relevant moved.
+class ChangeDetector {
+public:
+    explicit ChangeDetector(ChangeDetectorConfig config = {});
+
+    // watch: only changes overlapping this rect count (empty = whole frame)
+    const ChangeMap& update(const cv::Mat& frame, const FrameChanges& hint = {}, const cv::Rect& watch = cv::Rect());
+    void reset();
+
+private:
+    void buildThumbnail(const cv::Mat& frame, cv::Mat& out);
+
+    ChangeDetectorConfig config;
+    ChangeMap map;
+    cv::Size frameSize;
+    cv::Mat reference; // CV_8U luma thumbnail; a tile is refreshed only when it is reported changed,
+                       // so slow drifts still add up to a change
+    cv::Mat current;
+    cv::Mat scratch;
+};
+
+struct GateConfig {
+    ChangeDetectorConfig change;
+    int maxReuseFrames = 120;   // Force a real inference at least this often
+    float stableIoU = 0.5f;     // Same-class match to keep a previous detection in unchanged tiles
+};
+
+struct GateStats {
+    uint64_t frames = 0;
+    uint64_t inferred = 0;
+    uint64_t skipped = 0;       // Frames served from the previous detections
+    double inferenceUs = 0.0;   // Total time spent in the wrapped detector
+    double gateUs = 0.0;        // Total time spent deciding
+
+    double meanInferenceUs() const { return inferred ? inferenceUs / inferred : 0.0; }
+    // Skipped frames at the average inference cost, minus what the gate itself cost
+    double savedUs() const { return skipped * meanInferenceUs() - gateUs; }
+};
+
+// Puts a ChangeDetector in front of a detector. Inference only runs when the
+// watched region changed; otherwise the previous detections are returned.
+// After a real inference, detections lying entirely in unchanged tiles are
+// replaced by their previous match so static objects stay pixel-stable.
+class GatedDetector {
+public:
+    using DetectFn = std::function<std::vector<Detection>(const cv::Mat& frame)>;
+    using RegionFn = std::function<cv::Rect()>;
+
+    // watchRegion: e.g. the locked table ROI; empty rect / no function = whole frame
+    explicit GatedDetector(DetectFn detect, GateConfig config = {}, RegionFn watchRegion = {});
+
+    std::vector<Detection> run(const cv::Mat& frame, const FrameChanges& changes = {});
+
+    bool lastReused() const { return reused; }
+    const GateStats& stats() const { return counters; }
+    void reset();
+
+private:
+    void keepStableDetections(std::vector<Detection>& detections, const ChangeMap& changeMap) const;
+
+    DetectFn detect;
+    GateConfig config;
+    RegionFn watchRegion;
+    ChangeDetector changeDetector;
+    GateStats counters;
+
+    std::vector<Detection> previous;
+    cv::Rect previousWatch;
+    cv::Size previousSize;
+    bool hasPrevious = false;
+    bool reused = false;
+    int reuseCount = 0;
+};
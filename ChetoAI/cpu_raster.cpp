@@ -0,0 +1,135 @@
+#include "cpu_raster.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+constexpr int subpixelBits = 4;
+constexpr int64_t subpixel = 1 << subpixelBits;
+
+struct FixedPoint {
+    int64_t x, y;
+};
+
+FixedPoint snap(const DrawVertex& v) {
+    return { static_cast<int64_t>(std::lround(v.x * subpixel)), static_cast<int64_t>(std::lround(v.y * subpixel)) };
+}
+
+// > 0 when p is on the inner side of u -> v for a triangle with positive area (see fillTriangle)
+int64_t edge(FixedPoint u, FixedPoint v, int64_t px, int64_t py) {
+    return (v.x - u.x) * (py - u.y) - (v.y - u.y) * (px - u.x);
+}
+
+// Top edges (horizontal, interior below) and left edges own the pixels exactly on them
+bool topLeft(FixedPoint u, FixedPoint v) {
+    return (u.y == v.y && v.x > u.x) || v.y < u.y;
+}
+
+int toByte(float v) {
+    return static_cast<int>(std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255.0f));
+}
+
+// (a * b + 127) / 255 for 0..255 inputs, exact
+int mul255(int a, int b) {
+    const int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+} // namespace
+
+CpuRasterizer::CpuRasterizer(int width, int height)
+    : target(height, width, CV_8UC4, cv::Scalar(0, 0, 0, 0)) {
+}
+
+void CpuRasterizer::render(const DrawList& list) {
+    CHETO_TRACE_SCOPE("rasterize");
+    // Only what the last frame touched needs clearing: the overlay is mostly empty
+    if (dirtyX1 >= dirtyX0)
+        target(cv::Rect(dirtyX0, dirtyY0, dirtyX1 - dirtyX0 + 1, dirtyY1 - dirtyY0 + 1)).setTo(cv::Scalar(0, 0, 0, 0));
+    dirtyX0 = dirtyY0 = std::numeric_limits<int>::max();
+    dirtyX1 = dirtyY1 = -1;
+    const std::vector<DrawVertex>& v = list.triangles();
+    for (size_t i = 0; i + 2 < v.size(); i += 3) fillTriangle(v[i], v[i + 1], v[i + 2]);
+}
+
+void CpuRasterizer::fillTriangle(const DrawVertex& va, const DrawVertex& vb, const DrawVertex& vc) {
+    FixedPoint a = snap(va), b = snap(vb), c = snap(vc);
+    const int64_t area = edge(a, b, c.x, c.y);
+    if (area == 0) return;
+    if (area < 0) std::swap(b, c);
+
+    // Pixel centres (x + 0.5, y + 0.5) inside the bounding box, clipped to the target
+    const int x0 = std::max(0, static_cast<int>((std::min({ a.x, b.x, c.x }) >> subpixelBits) - 1));
+    const int y0 = std::max(0, static_cast<int>((std::min({ a.y, b.y, c.y }) >> subpixelBits) - 1));
+    const int x1 = std::min(target.cols - 1, static_cast<int>((std::max({ a.x, b.x, c.x }) >> subpixelBits) + 1));
+    const int y1 = std::min(target.rows - 1, static_cast<int>((std::max({ a.y, b.y, c.y }) >> subpixelBits) + 1));
+    if (x0 > x1 || y0 > y1) return;
+    dirtyX0 = std::min(dirtyX0, x0);
+    dirtyY0 = std::min(dirtyY0, y0);
+    dirtyX1 = std::max(dirtyX1, x1);
+    dirtyY1 = std::max(dirtyY1, y1);
+
+    const int64_t biasA = topLeft(b, c) ? 0 : -1;
+    const int64_t biasB = topLeft(c, a) ? 0 : -1;
+    const int64_t biasC = topLeft(a, b) ? 0 : -1;
+
+    const int alpha = toByte(va.color.a);
+    if (alpha == 0) return;
+    const int red = mul255(toByte(va.color.r), alpha);
+    const int green = mul255(toByte(va.color.g), alpha);
+    const int blue = mul255(toByte(va.color.b), alpha);
+    const int keep = 255 - alpha;
+
+    const FixedPoint edges[3][2] = { { b, c }, { c, a }, { a, b } };
+    const int64_t biases[3] = { biasA, biasB, biasC };
+    for (int y = y0; y <= y1; ++y) {
+        const int64_t py = y * subpixel + subpixel / 2;
+        // Each edge test is linear in px: narrow the row to the span where all three can pass (one
+        // pixel of slack for rounding), so a long diagonal line does not scan its whole bounding box
+        double spanMin = x0, spanMax = x1;
+        for (int e = 0; e < 3; ++e) {
+            const FixedPoint u = edges[e][0], v = edges[e][1];
+            const int64_t dy = v.y - u.y;
+            const int64_t limit = (v.x - u.x) * (py - u.y) + dy * u.x + biases[e]; // dy * px <= limit
+            if (dy == 0) {
+                if (limit < 0) spanMax = -1.0;
+                continue;
+            }
+            const double bound = (static_cast<double>(limit) / dy - subpixel / 2) / subpixel;
+            if (dy > 0) spanMax = std::min(spanMax, bound + 1.0);
+            else spanMin = std::max(spanMin, bound - 1.0);
+        }
+        if (spanMin > spanMax) continue;
+        unsigned char* row = target.ptr<unsigned char>(y);
+        const int xEnd = static_cast<int>(spanMax);
+        for (int x = static_cast<int>(std::ceil(spanMin)); x <= xEnd; ++x) {
+            const int64_t px = x * subpixel + subpixel / 2;
+            if (edge(b, c, px, py) + biasA < 0 || edge(c, a, px, py) + biasB < 0 || edge(a, b, px, py) + biasC < 0)
+                continue;
+            unsigned char* p = row + x * 4;
+            p[0] = static_cast<unsigned char>(blue + mul255(p[0], keep));
+            p[1] = static_cast<unsigned char>(green + mul255(p[1], keep));
+            p[2] = static_cast<unsigned char>(red + mul255(p[2], keep));
+            p[3] = static_cast<unsigned char>(alpha + mul255(p[3], keep));
+        }
+    }
+}
+
+void CpuRasterizer::composite(cv::Mat& frame) const {
+    if (frame.size() != target.size() || (frame.channels() != 3 && frame.channels() != 4)) return;
+    const int channels = frame.channels();
+    for (int y = 0; y < target.rows; ++y) {
+        const unsigned char* src = target.ptr<unsigned char>(y);
+        unsigned char* dst = frame.ptr<unsigned char>(y);
+        for (int x = 0; x < target.cols; ++x, src += 4, dst += channels) {
+            const int alpha = src[3];
+            if (alpha == 0) continue;
+            const int keep = 255 - alpha; // The target holds colour * alpha already
+            for (int k = 0; k < 3; ++k) dst[k] = static_cast<unsigned char>(std::min(255, src[k] + mul255(dst[k], keep)));
+            if (channels == 4) dst[3] = static_cast<unsigned char>(alpha + mul255(dst[3], keep));
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "draw_list.h"
+
+// Portable DrawBackend: rasterizes a DrawList into a BGRA cv::Mat. Vertices snap to 1/16 pixel and
+// coverage is tested at pixel centres with the top-left fill rule, as D3D does, so triangles that
+// share an edge (every quad, ring and cone here) cover each pixel exactly once. Integer edge
+// functions and 8-bit blending make the output bit-exact across compilers, which is what golden-image
+// checks need. No anti-aliasing; a triangle takes the colour of its first vertex.
+class CpuRasterizer : public DrawBackend {
+public:
+    CpuRasterizer(int width, int height);
+
+    void render(const DrawList& list) override;  // Clears to transparent black first
+    // CV_8UC4 BGRA. Colour is premultiplied by alpha, i.e. the overlay as composited over black,
+    // which is what the D3D11 backend's blend state leaves in its back buffer. That back buffer is
+    // colour-keyed rather than alpha-blended onto the desktop, so this image only matches the screen
+    // where alpha is 0 or 255
+    const cv::Mat& image() const { return target; }
+
+    // Source-over of the last frame onto a BGR or BGRA image of the same size (e.g. a replay frame)
+    void composite(cv::Mat& frame) const;
+
+private:
+    void fillTriangle(const DrawVertex& a, const DrawVertex& b, const DrawVertex& c);
+
+    cv::Mat target;
+    int dirtyX0 = 0, dirtyY0 = 0, dirtyX1 = -1, dirtyY1 = -1; // Pixels the last frame may have drawn
+};
@@ -0,0 +1,409 @@
+#include "cushions.h"
+#include "seg_mask.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr float infinity = 1.0e30f;
+
+inline int lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+float pointSegmentDistance2(float px, float py, float x0, float y0, float x1, float y1) {
+    const float ex = x1 - x0, ey = y1 - y0;
+    const float length2 = ex * ex + ey * ey;
+    float t = length2 > 0.0f ? ((px - x0) * ex + (py - y0) * ey) / length2 : 0.0f;
+    t = std::min(1.0f, std::max(0.0f, t));
+    const float dx = px - x0 - ex * t, dy = py - y0 - ey * t;
+    return dx * dx + dy * dy;
+}
+
+// Liang-Barsky: does the segment touch the box?
+bool segmentTouchesBox(float x0, float y0, float x1, float y1, float minX, float minY, float maxX, float maxY) {
+    const float dx = x1 - x0, dy = y1 - y0;
+    const float p[4] = { -dx, dx, -dy, dy };
+    const float q[4] = { x0 - minX, maxX - x0, y0 - minY, maxY - y0 };
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0f) {
+            if (q[i] < 0.0f) return false;
+            continue;
+        }
+        const float r = q[i] / p[i];
+        if (p[i] < 0.0f) t0 = std::max(t0, r);
+        else t1 = std::min(t1, r);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+float pointBoxDistance2(float px, float py, float minX, float minY, float maxX, float maxY) {
+    const float dx = std::max({ minX - px, 0.0f, px - maxX });
+    const float dy = std::max({ minY - py, 0.0f, py - maxY });
+    return dx * dx + dy * dy;
+}
+
+// Distance between a cushion and a grid cell is within `margin`
+bool segmentNearBox(const CushionEdge& e, float minX, float minY, float maxX, float maxY, float margin) {
+    if (segmentTouchesBox(e.x0, e.y0, e.x1, e.y1, minX, minY, maxX, maxY)) return true;
+    const float margin2 = margin * margin;
+    return pointBoxDistance2(e.x0, e.y0, minX, minY, maxX, maxY) <= margin2
+        || pointBoxDistance2(e.x1, e.y1, minX, minY, maxX, maxY) <= margin2
+        || pointSegmentDistance2(minX, minY, e.x0, e.y0, e.x1, e.y1) <= margin2
+        || pointSegmentDistance2(maxX, minY, e.x0, e.y0, e.x1, e.y1) <= margin2
+        || pointSegmentDistance2(minX, maxY, e.x0, e.y0, e.x1, e.y1) <= margin2
+        || pointSegmentDistance2(maxX, maxY, e.x0, e.y0, e.x1, e.y1) <= margin2;
+}
+
+// First t >= 0 at which (x, y) + (dx, dy) t is within `radius` of (cx, cy); `infinity` if never
+float rayCircle(float x, float y, float dx, float dy, float cx, float cy, float radius) {
+    const float ox = x - cx, oy = y - cy;
+    const float c = ox * ox + oy * oy - radius * radius;
+    if (c <= 0.0f) return 0.0f;
+    const float b = ox * dx + oy * dy;
+    if (b >= 0.0f) return infinity;
+    const float disc = b * b - c;
+    if (disc < 0.0f) return infinity;
+    return -b - std::sqrt(disc);
+}
+
+} // namespace
+
+void CushionTable::clear() {
+    edgeCount = 0;
+    pockets = 0;
+    builtFrom = CushionSource::None;
+    cachedSource = CushionSource::None;
+    cachedBounds = cv::Rect();
+    cachedPockets.clear();
+}
+
+bool CushionTable::moved(const Table& table, CushionSource available) const {
+    if (available != cachedSource) return true;
+    const float tol = config.moveTolerance;
+    if (std::abs(table.bounds.x - cachedBounds.x) > tol || std::abs(table.bounds.y - cachedBounds.y) > tol
+        || std::abs(table.bounds.br().x - cachedBounds.br().x) > tol
+        || std::abs(table.bounds.br().y - cachedBounds.br().y) > tol)
+        return true;
+    if (table.pockets.size() != cachedPockets.size()) return true;
+    // Detection order is not stable; match each pocket to any cached one
+    for (const auto& p : table.pockets) {
+        bool matched = false;
+        for (const auto& q : cachedPockets)
+            if (std::abs(p.x - q.x) <= tol && std::abs(p.y - q.y) <= tol) matched = true;
+        if (!matched) return true;
+    }
+    return false;
+}
+
+bool CushionTable::update(const Table& table, const std::vector<Detection>& detections, int screenWidth,
+                          int screenHeight) {
+    const Detection* playArea = nullptr;
+    for (const auto& det : detections)
+        if (det.type == ObjectType::PlayArea && (!playArea || det.confidence > playArea->confidence)) playArea = &det;
+
+    CushionSource available = CushionSource::None;
+    if (playArea && !playArea->mask.empty()) available = CushionSource::Mask;
+    else if (table.pockets.size() >= 3) available = CushionSource::Pockets;
+    else if (!table.bounds.empty()) available = CushionSource::Box;
+    if (available == CushionSource::None) {
+        const bool had = valid();
+        clear();
+        return had;
+    }
+    if (!moved(table, available)) return false;
+    const CushionSource requested = available;
+
+    CHETO_TRACE_SCOPE("cushions");
+    std::vector<cv::Point2f> outline;
+    if (available == CushionSource::Mask) {
+        // Largest outer contour of the mask, simplified until it fits the edge budget
+        const cv::Mat mask = upsampleMask(*playArea);
+        std::vector<std::vector<cv::Point>> contours;
+        if (!mask.empty()) cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        const std::vector<cv::Point>* largest = nullptr;
+        double largestArea = 0.0;
+        for (const auto& contour : contours) {
+            const double area = cv::contourArea(contour);
+            if (area > largestArea) {
+                largestArea = area;
+                largest = &contour;
+            }
+        }
+        if (largest) {
+            std::vector<cv::Point> simplified;
+            double epsilon = config.simplifyEpsilon * cv::arcLength(*largest, true);
+            do {
+                cv::approxPolyDP(*largest, simplified, epsilon, true);
+                epsilon *= 2.0;
+            } while (static_cast<int>(simplified.size()) > cushionMaxEdges / 2);
+            const float sx = 1920.0f / screenWidth, sy = 1080.0f / screenHeight;
+            for (const auto& p : simplified)
+                outline.push_back(cv::Point2f((playArea->box.x + p.x) * sx, (playArea->box.y + p.y) * sy));
+        }
+        if (outline.size() < 3) available = table.pockets.size() >= 3 ? CushionSource::Pockets : CushionSource::Box;
+    }
+    if (available == CushionSource::Pockets) {
+        outline.clear();
+        cv::convexHull(table.pockets, outline);
+        if (outline.size() < 3) available = CushionSource::Box;
+    }
+    if (available == CushionSource::Box) {
+        outline.clear();
+        if (!table.bounds.empty()) {
+            const cv::Rect& b = table.bounds;
+            outline = { cv::Point2f(static_cast<float>(b.x), static_cast<float>(b.y)),
+                        cv::Point2f(static_cast<float>(b.x + b.width), static_cast<float>(b.y)),
+                        cv::Point2f(static_cast<float>(b.x + b.width), static_cast<float>(b.y + b.height)),
+                        cv::Point2f(static_cast<float>(b.x), static_cast<float>(b.y + b.height)) };
+        }
+    }
+
+    float xs[cushionMaxEdges], ys[cushionMaxEdges];
+    const int count = std::min(static_cast<int>(outline.size()), cushionMaxEdges);
+    for (int i = 0; i < count; ++i) {
+        xs[i] = outline[i].x;
+        ys[i] = outline[i].y;
+    }
+    float pocketX[cushionMaxPockets], pocketY[cushionMaxPockets];
+    const int pocketCount = std::min(static_cast<int>(table.pockets.size()), cushionMaxPockets);
+    for (int i = 0; i < pocketCount; ++i) {
+        pocketX[i] = table.pockets[i].x;
+        pocketY[i] = table.pockets[i].y;
+    }
+    if (!build(xs, ys, count, pocketX, pocketY, pocketCount, available)) clear();
+    // Cache the inputs even on failure so a degenerate table is not retried every frame
+    cachedSource = requested;
+    cachedBounds = table.bounds;
+    cachedPockets = table.pockets;
+    return true;
+}
+
+bool CushionTable::build(const float* xs, const float* ys, int count, const float* pocketX, const float* pocketY,
+                         int pocketCount, CushionSource source) {
+    edgeCount = 0;
+    pockets = std::min(pocketCount, cushionMaxPockets);
+    for (int i = 0; i < pockets; ++i) {
+        pocketXs[i] = pocketX[i];
+        pocketYs[i] = pocketY[i];
+    }
+    if (count < 3) return false;
+
+    // Winding decides which side is inside: the normal is the left normal for positive signed area
+    float area2 = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        const int j = (i + 1) % count;
+        area2 += xs[i] * ys[j] - xs[j] * ys[i];
+    }
+    if (std::abs(area2) < 2.0f) return false;
+    const float side = area2 > 0.0f ? 1.0f : -1.0f;
+
+    for (int i = 0; i < count; ++i) {
+        const int j = (i + 1) % count;
+        const float ex = xs[j] - xs[i], ey = ys[j] - ys[i];
+        const float length = std::sqrt(ex * ex + ey * ey);
+        if (length < 1.0f) continue;
+        const float tx = ex / length, ty = ey / length;
+
+        // Pocket mouths along this side, as [from, to] distances from (xs[i], ys[i]), merged
+        float gapFrom[cushionMaxPockets], gapTo[cushionMaxPockets];
+        int gaps = 0;
+        for (int p = 0; p < pockets; ++p) {
+            if (pointSegmentDistance2(pocketXs[p], pocketYs[p], xs[i], ys[i], xs[j], ys[j])
+                > config.pocketReach * config.pocketReach)
+                continue;
+            const float along = (pocketXs[p] - xs[i]) * tx + (pocketYs[p] - ys[i]) * ty;
+            int k = gaps++;
+            for (; k > 0 && gapFrom[k - 1] > along - config.pocketMouth; --k) {
+                gapFrom[k] = gapFrom[k - 1];
+                gapTo[k] = gapTo[k - 1];
+            }
+            gapFrom[k] = along - config.pocketMouth;
+            gapTo[k] = along + config.pocketMouth;
+        }
+
+        float from = 0.0f;
+        for (int g = 0; g <= gaps && edgeCount < cushionMaxEdges; ++g) {
+            const float to = g < gaps ? std::min(gapFrom[g], length) : length;
+            if (to - from >= 1.0f) {
+                CushionEdge& e = edges[edgeCount++];
+                e.x0 = xs[i] + tx * from;
+                e.y0 = ys[i] + ty * from;
+                e.x1 = xs[i] + tx * to;
+                e.y1 = ys[i] + ty * to;
+                e.tx = tx;
+                e.ty = ty;
+                e.nx = -ty * side;
+                e.ny = tx * side;
+                e.length = to - from;
+            }
+            if (g < gaps) from = std::max(from, gapTo[g]);
+        }
+    }
+    if (edgeCount == 0) return false;
+
+    buildIndex();
+    builtFrom = source;
+    ++rebuildCount;
+    return true;
+}
+
+void CushionTable::buildIndex() {
+    float minX = infinity, minY = infinity, maxX = -infinity, maxY = -infinity;
+    for (int i = 0; i < edgeCount; ++i) {
+        minX = std::min({ minX, edges[i].x0, edges[i].x1 });
+        minY = std::min({ minY, edges[i].y0, edges[i].y1 });
+        maxX = std::max({ maxX, edges[i].x0, edges[i].x1 });
+        maxY = std::max({ maxY, edges[i].y0, edges[i].y1 });
+    }
+    const float margin = config.indexMargin;
+    gridX = minX - margin;
+    gridY = minY - margin;
+    cellW = std::max(1.0f, (maxX - minX + 2.0f * margin) / cushionGridSize);
+    cellH = std::max(1.0f, (maxY - minY + 2.0f * margin) / cushionGridSize);
+    for (int cy = 0; cy < cushionGridSize; ++cy) {
+        for (int cx = 0; cx < cushionGridSize; ++cx) {
+            const float x0 = gridX + cx * cellW, y0 = gridY + cy * cellH;
+            uint32_t mask = 0;
+            for (int i = 0; i < edgeCount; ++i)
+                if (segmentNearBox(edges[i], x0, y0, x0 + cellW, y0 + cellH, margin)) mask |= 1u << i;
+            cells[cy * cushionGridSize + cx] = mask;
+        }
+    }
+}
+
+int CushionTable::nearestEdgeIn(uint32_t candidates, float x, float y, float dx, float dy, float radius, float maxT,
+                                int skip, float& hitT) const {
+    int best = -1;
+    for (; candidates; candidates &= candidates - 1) {
+        const int i = lowestBit(candidates);
+        if (i == skip) continue;
+        const CushionEdge& e = edges[i];
+        // Ball centre reaches the line `radius` inside the cushion: n . (p + d t - a) = radius
+        const float approach = e.nx * dx + e.ny * dy;
+        if (approach >= 0.0f) continue;
+        const float t = (radius - (e.nx * (x - e.x0) + e.ny * (y - e.y0))) / approach;
+        if (t < 0.0f || t > maxT) continue;
+        const float along = (x + dx * t - e.x0) * e.tx + (y + dy * t - e.y0) * e.ty;
+        if (along < 0.0f || along > e.length) continue;
+        best = i;
+        maxT = t;
+    }
+    if (best >= 0) hitT = maxT;
+    return best;
+}
+
+int CushionTable::nearestEdge(float x, float y, float dx, float dy, float radius, float maxT, int skip,
+                              float& hitT) const {
+    const uint32_t all = edgeCount >= 32 ? ~0u : (1u << edgeCount) - 1;
+    int ix = static_cast<int>(std::floor((x - gridX) / cellW));
+    int iy = static_cast<int>(std::floor((y - gridY) / cellH));
+    if (!config.spatialIndex || edgeCount < cushionGridMinEdges || ix < 0 || iy < 0 || ix >= cushionGridSize || iy >= cushionGridSize)
+        return nearestEdgeIn(all, x, y, dx, dy, radius, maxT, skip, hitT);
+
+    // Walk the cells the ray crosses; stop once the best hit lies inside the cell being left
+    const int stepX = dx > 0.0f ? 1 : -1, stepY = dy > 0.0f ? 1 : -1;
+    const float deltaX = dx != 0.0f ? cellW / std::abs(dx) : infinity;
+    const float deltaY = dy != 0.0f ? cellH / std::abs(dy) : infinity;
+    float nextX = dx != 0.0f ? (gridX + (ix + (dx > 0.0f ? 1 : 0)) * cellW - x) / dx : infinity;
+    float nextY = dy != 0.0f ? (gridY + (iy + (dy > 0.0f ? 1 : 0)) * cellH - y) / dy : infinity;
+    uint32_t tested = 0;
+    int best = -1;
+    float bestT = maxT;
+    for (;;) {
+        const uint32_t candidates = cells[iy * cushionGridSize + ix] & ~tested;
+        if (candidates) {
+            float t;
+            const int e = nearestEdgeIn(candidates, x, y, dx, dy, radius, bestT, skip, t);
+            if (e >= 0) {
+                best = e;
+                bestT = t;
+            }
+            tested |= candidates;
+        }
+        const float exit = std::min(nextX, nextY);
+        if ((best >= 0 && bestT <= exit) || exit > maxT) break;
+        if (nextX < nextY) {
+            ix += stepX;
+            nextX += deltaX;
+        }
+        else {
+            iy += stepY;
+            nextY += deltaY;
+        }
+        if (ix < 0 || iy < 0 || ix >= cushionGridSize || iy >= cushionGridSize) break;
+    }
+    if (best >= 0) hitT = bestT;
+    return best;
+}
+
+void CushionTable::trace(float x, float y, float dx, float dy, float radius, int maxBounces, float maxLength,
+                         BankPath& out) const {
+    out.pointCount = 0;
+    out.bounces = 0;
+    out.pocket = -1;
+    auto addPoint = [&out](float px, float py, int edge) {
+        out.x[out.pointCount] = px;
+        out.y[out.pointCount] = py;
+        out.edge[out.pointCount] = edge;
+        ++out.pointCount;
+    };
+    addPoint(x, y, -1);
+    const float speed = std::sqrt(dx * dx + dy * dy);
+    if (speed <= 0.0f || maxLength <= 0.0f) return;
+    dx /= speed;
+    dy /= speed;
+    maxBounces = std::min(std::max(maxBounces, 0), cushionMaxBounces);
+
+    float remaining = maxLength;
+    int skip = -1;
+    for (;;) {
+        float edgeT = remaining;
+        const int edge = valid() ? nearestEdge(x, y, dx, dy, radius, remaining, skip, edgeT) : -1;
+
+        // A pocket in front of the cushion ends the path
+        int pocket = -1;
+        float pocketT = edgeT;
+        for (int p = 0; p < pockets; ++p) {
+            const float t = rayCircle(x, y, dx, dy, pocketXs[p], pocketYs[p], config.pocketRadius);
+            if (t <= pocketT) {
+                pocket = p;
+                pocketT = t;
+            }
+        }
+        if (pocket >= 0) {
+            addPoint(x + dx * pocketT, y + dy * pocketT, -1);
+            out.pocket = pocket;
+            return;
+        }
+        x += dx * edgeT;
+        y += dy * edgeT;
+        if (edge < 0) {
+            addPoint(x, y, -1);
+            return;
+        }
+        addPoint(x, y, edge);
+        if (out.bounces == maxBounces) return;
+
+        // Mirror the direction about the cushion
+        const CushionEdge& e = edges[edge];
+        const float dot = dx * e.nx + dy * e.ny;
+        dx -= 2.0f * dot * e.nx;
+        dy -= 2.0f * dot * e.ny;
+        remaining -= edgeT;
+        skip = edge;
+        ++out.bounces;
+    }
+}
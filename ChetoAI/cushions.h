@@ -0,0 +1,110 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+#include "detection.h"
+#include "physics.h"
+
+// Polygonal cushion model of the play area, in overlay space. The outline comes
+// from the PlayArea segmentation mask when there is one, otherwise from the
+// convex hull of the detected pockets, otherwise from the PlayArea box. Each
+// side becomes one or more cushion edges (with a gap at every pocket mouth),
+// stored with unit tangent and inward normal plus a coarse grid index, so a
+// ray only tests the edges near the cells it crosses.
+//
+// The geometry is rebuilt only when the table moves: update() compares the
+// PlayArea box and pockets against the cached ones and returns early otherwise.
+
+constexpr int cushionMaxEdges = 32;      // Fits a uint32 mask per grid cell
+constexpr int cushionMaxPockets = 6;
+constexpr int cushionMaxBounces = 8;
+constexpr int cushionGridSize = 4;       // Cells per side
+constexpr int cushionGridMinEdges = 20;  // Fewer edges: testing them all beats walking the grid
+
+struct CushionConfig {
+    float pocketMouth = 28.0f;       // Half-width of the cushion gap at each pocket
+    float pocketReach = 40.0f;       // A pocket opens every edge within this distance
+    float pocketRadius = 20.0f;      // Ball centre within this of a pocket centre = pocketed
+    float indexMargin = 24.0f;       // Edges are indexed this far out; >= any ball radius traced
+    float moveTolerance = 4.0f;      // Rebuild when the box or a pocket moves more than this
+    float simplifyEpsilon = 0.01f;   // Mask outline simplification, fraction of its perimeter
+    bool spatialIndex = true;        // false: test every edge (benchmarks)
+};
+
+// One straight cushion; the normal points into the table
+struct CushionEdge {
+    float x0, y0, x1, y1;
+    float tx, ty;                    // Unit direction from (x0, y0)
+    float nx, ny;
+    float length;
+};
+
+enum class CushionSource : uint8_t { None, Box, Pockets, Mask };
+
+// Centre line of a ball traced through up to maxBounces cushion reflections
+struct BankPath {
+    int pointCount = 0;              // Start, every bounce, end
+    float x[cushionMaxBounces + 2];
+    float y[cushionMaxBounces + 2];
+    int edge[cushionMaxBounces + 2]; // Cushion hit at each point, -1 for start and end
+    int bounces = 0;
+    int pocket = -1;                 // Pocket the path ends in, or -1
+};
+
+class CushionTable {
+public:
+    explicit CushionTable(const CushionConfig& config = CushionConfig()) : config(config) {}
+
+    // Refreshes the model from this frame's table (overlay space) and detections (frame pixels,
+    // for the PlayArea mask). Returns true when the geometry was rebuilt.
+    bool update(const Table& table, const std::vector<Detection>& detections, int screenWidth, int screenHeight);
+
+    // Builds from an outline (either winding) and pockets directly; false if the outline is degenerate
+    bool build(const float* xs, const float* ys, int count, const float* pocketX, const float* pocketY,
+               int pocketCount, CushionSource source);
+    void clear();
+
+    // Traces a ball of `radius` from (x, y) along (dx, dy) for at most `maxLength`, reflecting
+    // off up to `maxBounces` cushions. Ends in a pocket, at the cushion after the last allowed
+    // bounce, or after maxLength (e.g. out through a pocket mouth it missed). Edge ends are not rounded.
+    void trace(float x, float y, float dx, float dy, float radius, int maxBounces, float maxLength,
+               BankPath& out) const;
+
+    bool valid() const { return edgeCount > 0; }
+    CushionSource source() const { return builtFrom; }
+    int size() const { return edgeCount; }
+    const CushionEdge& edge(int i) const { return edges[i]; }
+    int pocketCount() const { return pockets; }
+    float pocketX(int i) const { return pocketXs[i]; }
+    float pocketY(int i) const { return pocketYs[i]; }
+    uint64_t rebuilds() const { return rebuildCount; }
+    const CushionConfig& settings() const { return config; }
+
+private:
+    bool moved(const Table& table, CushionSource available) const;
+    // Nearest cushion (offset inward by radius) hit along the ray within maxT, ignoring `skip`; -1 if none
+    int nearestEdge(float x, float y, float dx, float dy, float radius, float maxT, int skip, float& hitT) const;
+    int nearestEdgeIn(uint32_t candidates, float x, float y, float dx, float dy, float radius, float maxT,
+                      int skip, float& hitT) const;
+    void buildIndex();
+
+    CushionConfig config;
+    CushionSource builtFrom = CushionSource::None;
+    int edgeCount = 0;
+    CushionEdge edges[cushionMaxEdges];
+    int pockets = 0;
+    float pocketXs[cushionMaxPockets];
+    float pocketYs[cushionMaxPockets];
+
+    // Grid over the outline's bounds (+ indexMargin); bit i of a cell = edge i passes within the margin
+    float gridX = 0.0f, gridY = 0.0f, cellW = 1.0f, cellH = 1.0f;
+    uint32_t cells[cushionGridSize * cushionGridSize] = {};
+
+    // What the geometry was built from, for the moved() check. cachedSource is the best source
+    // that was available (the build may have fallen back to a lesser one)
+    CushionSource cachedSource = CushionSource::None;
+    cv::Rect cachedBounds;
+    std::vector<cv::Point2f> cachedPockets;
+    uint64_t rebuildCount = 0;
+};
@@ -0,0 +1,21 @@
+#include "debug_log.h"
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+void debugLog(const char* format, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+#ifdef _WIN32
+    OutputDebugStringA(buf);
+#else
+    std::fputs(buf, stderr);
+#endif
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// printf-style debug output: OutputDebugStringA on Windows, stderr elsewhere.
+// Keep it off per-frame paths.
+void debugLog(const char* format, ...);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "Enums.h"
+#include "physics.h"
+
+struct Detection {
+    cv::Rect box;
+    int class_id;
+    float confidence;
+    ObjectType type = ObjectType::Unknown;
+    BallType ball_type = BallType::Other;
+    int anchor = -1;    // Column in the raw model output this box came from
+    cv::Mat mask;       // Instance mask inside `box`, prototype resolution (see seg_mask.h)
+};
+
+// Intersection over union of two boxes; 0 when they do not overlap
+inline float boxIoU(const cv::Rect& a, const cv::Rect& b) {
+    const int inter = (a & b).area();
+    if (inter <= 0) return 0.0f;
+    return static_cast<float>(inter) / static_cast<float>(a.area() + b.area() - inter);
+}
@@ -0,0 +1,91 @@
+#include "draw_list.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float twoPi = 6.283185307179586f;
+
+// Chords for an arc of `radians` at `radius`, so each is about `chord` pixels
+int arcPieces(float radius, float radians, float chord) {
+    const float length = std::abs(radius * radians);
+    return std::max(1, std::min(256, static_cast<int>(std::ceil(length / std::max(chord, 0.5f)))));
+}
+
+} // namespace
+
+void DrawList::triangle(GuidePoint a, GuidePoint b, GuidePoint c, DrawColor color) {
+    vertices.push_back({ a.x, a.y, color });
+    vertices.push_back({ b.x, b.y, color });
+    vertices.push_back({ c.x, c.y, color });
+}
+
+void DrawList::line(GuidePoint a, GuidePoint b, DrawColor color, float width) {
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.0f) return;
+    const float nx = -dy / length * width * 0.5f, ny = dx / length * width * 0.5f;
+    const GuidePoint a0{ a.x + nx, a.y + ny }, a1{ a.x - nx, a.y - ny };
+    const GuidePoint b0{ b.x + nx, b.y + ny }, b1{ b.x - nx, b.y - ny };
+    triangle(a0, b0, b1, color);
+    triangle(a0, b1, a1, color);
+}
+
+void DrawList::polyline(const GuidePoint* points, int count, DrawColor color, float width, bool closed) {
+    for (int i = 0; i + 1 < count; ++i) line(points[i], points[i + 1], color, width);
+    if (closed && count > 2) line(points[count - 1], points[0], color, width);
+}
+
+void DrawList::segments(const GuideBuffer& guide, DrawColor color, float width) {
+    for (const GuideSegment& segment : guide) line(segment.start, segment.end, color, width);
+}
+
+// A ring of quads between radius -/+ width / 2, sharing corners so no pixel is covered twice
+void DrawList::circle(GuidePoint center, float radius, DrawColor color, float width) {
+    if (radius <= 0.0f) return;
+    const float inner = std::max(0.0f, radius - width * 0.5f), outer = radius + width * 0.5f;
+    const int pieces = std::max(8, arcPieces(radius, twoPi, circleChord));
+    GuidePoint inner0{ center.x + inner, center.y }, outer0{ center.x + outer, center.y };
+    for (int i = 1; i <= pieces; ++i) {
+        const float angle = twoPi * i / pieces;
+        const float c = std::cos(angle), s = std::sin(angle);
+        const GuidePoint inner1{ center.x + inner * c, center.y + inner * s };
+        const GuidePoint outer1{ center.x + outer * c, center.y + outer * s };
+        triangle(inner0, outer0, outer1, color);
+        triangle(inner0, outer1, inner1, color);
+        inner0 = inner1;
+        outer0 = outer1;
+    }
+}
+
+void DrawList::filledCone(GuidePoint apex, GuidePoint a, GuidePoint b, DrawColor color) {
+    const float ax = a.x - apex.x, ay = a.y - apex.y;
+    const float radius = std::sqrt(ax * ax + ay * ay);
+    if (radius <= 0.0f) return;
+    const float start = std::atan2(ay, ax);
+    float sweep = std::atan2(b.y - apex.y, b.x - apex.x) - start;
+    if (sweep > twoPi * 0.5f) sweep -= twoPi;
+    if (sweep < -twoPi * 0.5f) sweep += twoPi;
+    const int pieces = arcPieces(radius, sweep, circleChord);
+    GuidePoint from = a;
+    for (int i = 1; i <= pieces; ++i) {
+        const float angle = start + sweep * i / pieces;
+        const GuidePoint to{ apex.x + radius * std::cos(angle), apex.y + radius * std::sin(angle) };
+        triangle(apex, from, to, color);
+        from = to;
+    }
+}
+
+void DrawList::hatchedCone(GuidePoint apex, GuidePoint a, GuidePoint b, float spacing, DrawColor color, float width) {
+    const float ax = a.x - apex.x, ay = a.y - apex.y;
+    const float bx = b.x - apex.x, by = b.y - apex.y;
+    const float radius = std::sqrt(ax * ax + ay * ay), bLength = std::sqrt(bx * bx + by * by);
+    if (radius <= 0.0f || bLength <= 0.0f) return;
+    // Both edges out to the distance of `a`, as filledCone
+    const float bScale = radius / bLength;
+    const float step = std::max(spacing, width + 1.0f);
+    for (float r = step; r <= radius; r += step) {
+        const float t = r / radius;
+        line({ apex.x + ax * t, apex.y + ay * t }, { apex.x + bx * bScale * t, apex.y + by * bScale * t }, color, width);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "physics.h"
+
+// RGBA in 0..1, straight (not premultiplied) alpha
+struct DrawColor {
+    float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+};
+
+// One triangle corner, overlay pixels (y down)
+struct DrawVertex {
+    float x, y;
+    DrawColor color;
+};
+
+// Everything the overlay draws in one frame. Primitives are tessellated into triangles as they are
+// appended, all into one CPU buffer, so a backend uploads the frame once and draws it with a single
+// call. Lines become quads `width` pixels wide (no joins); circles and cone arcs are cut into chords
+// of about `circleChord` pixels. clear() keeps the capacity, so a warmed-up frame allocates nothing.
+class DrawList {
+public:
+    void clear() { vertices.clear(); }
+
+    void line(GuidePoint a, GuidePoint b, DrawColor color, float width = 2.0f);
+    void polyline(const GuidePoint* points, int count, DrawColor color, float width = 2.0f, bool closed = false);
+    void segments(const GuideBuffer& guide, DrawColor color, float width = 2.0f);
+    void circle(GuidePoint center, float radius, DrawColor color, float width = 2.0f);
+    // Filled wedge at `apex` from the direction of `a` to that of `b` (the shorter way round),
+    // out to the distance of `a`. The uncertainty cone's two edges share the apex.
+    void filledCone(GuidePoint apex, GuidePoint a, GuidePoint b, DrawColor color);
+    // The same wedge as rungs: a chord across it every `spacing` pixels from the apex, `width` wide.
+    // Keeps the cone see-through on an overlay that cannot blend (overlay.h)
+    void hatchedCone(GuidePoint apex, GuidePoint a, GuidePoint b, float spacing, DrawColor color, float width = 1.0f);
+    void triangle(GuidePoint a, GuidePoint b, GuidePoint c, DrawColor color);
+
+    const std::vector<DrawVertex>& triangles() const { return vertices; } // 3 per triangle
+    size_t triangleCount() const { return vertices.size() / 3; }
+    bool empty() const { return vertices.empty(); }
+
+    float circleChord = 6.0f;
+
+private:
+    std::vector<DrawVertex> vertices;
+};
+
+// Where a DrawList ends up: the D3D11 overlay window (overlay.h) or a cv::Mat (cpu_raster.h)
+class DrawBackend {
+public:
+    virtual ~DrawBackend() = default;
+    // Replaces the previous frame with `list`, drawn in order with source-over alpha blending (into
+    // the back buffer; see D3D11DrawBackend for what reaches the screen)
+    virtual void render(const DrawList& list) = 0;
+};
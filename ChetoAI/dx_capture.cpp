@@ -2,6 +2,7 @@
 #include <d3d11.h>
 #include <dxgi1_2.h>
 #include <wrl/client.h>
+#include <memory>
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -11,8 +12,57 @@ using Microsoft::WRL::ComPtr;
 static ComPtr<ID3D11Device> d3dDevice;
 static ComPtr<ID3D11DeviceContext> d3dContext;
 static ComPtr<IDXGIOutputDuplication> deskDupl;
+static FrameChanges dxChanges; // Dirty/move rects of the last captured frame
+static std::vector<unsigned char> metadataBuffer;
+
+// One staging texture per pool slot, created the first time the slot is used (or the desktop size
+// changes) and left mapped while its frame is leased
+struct StagingTexture {
+    ComPtr<ID3D11Texture2D> texture;
+    D3D11_TEXTURE2D_DESC desc = {};
+    bool mapped = false;
+};
+static std::unique_ptr<FramePool> framePool;
+static std::vector<StagingTexture> stagingTextures;
+
+// Move and dirty rects reported by desktop duplication for the acquired frame
+static void readFrameChanges(const DXGI_OUTDUPL_FRAME_INFO& frameInfo) {
+    dxChanges.known = false;
+    dxChanges.regions.clear();
+
+    if (frameInfo.TotalMetadataBufferSize == 0) {
+        // Pointer-only update: the desktop image itself did not change
+        dxChanges.known = frameInfo.LastPresentTime.QuadPart == 0;
+        return;
+    }
+
+    if (metadataBuffer.size() < frameInfo.TotalMetadataBufferSize)
+        metadataBuffer.resize(frameInfo.TotalMetadataBufferSize);
+
+    UINT moveBytes = 0;
+    auto* moves = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(metadataBuffer.data());
+    if (FAILED(deskDupl->GetFrameMoveRects(frameInfo.TotalMetadataBufferSize, moves, &moveBytes))) return;
+
+    UINT dirtyBytes = 0;
+    auto* dirty = reinterpret_cast<RECT*>(metadataBuffer.data() + moveBytes);
+    if (FAILED(deskDupl->GetFrameDirtyRects(frameInfo.TotalMetadataBufferSize - moveBytes, dirty, &dirtyBytes))) return;
+
+    for (UINT i = 0; i < moveBytes / sizeof(DXGI_OUTDUPL_MOVE_RECT); ++i) {
+        const RECT& d = moves[i].DestinationRect;
+        const int w = d.right - d.left;
+        const int h = d.bottom - d.top;
+        dxChanges.regions.emplace_back(d.left, d.top, w, h);
+        dxChanges.regions.emplace_back(moves[i].SourcePoint.x, moves[i].SourcePoint.y, w, h);
+    }
+    for (UINT i = 0; i < dirtyBytes / sizeof(RECT); ++i)
+        dxChanges.regions.emplace_back(dirty[i].left, dirty[i].top, dirty[i].right - dirty[i].left, dirty[i].bottom - dirty[i].top);
+    dxChanges.known = true;
+}
+
+bool initializeDxCapture(int frameBuffers) {
+    framePool = std::make_unique<FramePool>(frameBuffers);
+    stagingTextures.assign(framePool->size(), StagingTexture());
 
-bool initializeDxCapture() {
     ComPtr<IDXGIFactory1> dxgiFactory;
     if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&dxgiFactory))) return false;
 
@@ -35,48 +85,74 @@ bool initializeDxCapture() {
     return true;
 }
 
-cv::Mat captureDxFrame() {
+cv::Mat captureDxFrame(FrameLease& lease) {
+    lease.reset();
+    if (!framePool) return cv::Mat();
+    // Take a buffer before the desktop frame: with none free, duplication keeps accumulating
+    // dirty rects and the next AcquireNextFrame reports them
+    lease = framePool->acquire();
+    if (!lease) return cv::Mat();
+    // The previous holder of this slot is done with it; the texture can be written again
+    StagingTexture& staging = stagingTextures[lease.slot()];
+    if (staging.mapped) {
+        d3dContext->Unmap(staging.texture.Get(), 0);
+        staging.mapped = false;
+    }
+
     DXGI_OUTDUPL_FRAME_INFO frameInfo = {};
     ComPtr<IDXGIResource> desktopResource;
 
-    if (FAILED(deskDupl->AcquireNextFrame(500, &frameInfo, &desktopResource)))
+    if (FAILED(deskDupl->AcquireNextFrame(500, &frameInfo, &desktopResource))) {
+        lease.reset();
         return cv::Mat();  // Timeout or failure
+    }
 
-    ComPtr<ID3D11Texture2D> tex;
-    if (FAILED(desktopResource.As(&tex))) return cv::Mat();
+    readFrameChanges(frameInfo);
 
+    ComPtr<ID3D11Texture2D> tex;
     D3D11_TEXTURE2D_DESC desc;
-    tex->GetDesc(&desc);
-
-    D3D11_TEXTURE2D_DESC cpuDesc = desc;
-    cpuDesc.Usage = D3D11_USAGE_STAGING;
-    cpuDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    cpuDesc.BindFlags = 0;
-    cpuDesc.MiscFlags = 0;
-
-    ComPtr<ID3D11Texture2D> cpuTex;
-    if (FAILED(d3dDevice->CreateTexture2D(&cpuDesc, nullptr, &cpuTex))) return cv::Mat();
-
-    d3dContext->CopyResource(cpuTex.Get(), tex.Get());
+    bool copied = false;
+    if (SUCCEEDED(desktopResource.As(&tex))) {
+        tex->GetDesc(&desc);
+        if (!staging.texture || staging.desc.Width != desc.Width || staging.desc.Height != desc.Height ||
+            staging.desc.Format != desc.Format) {
+            D3D11_TEXTURE2D_DESC cpuDesc = desc;
+            cpuDesc.Usage = D3D11_USAGE_STAGING;
+            cpuDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            cpuDesc.BindFlags = 0;
+            cpuDesc.MiscFlags = 0;
+            staging.texture.Reset();
+            if (SUCCEEDED(d3dDevice->CreateTexture2D(&cpuDesc, nullptr, &staging.texture))) staging.desc = cpuDesc;
+        }
+        if (staging.texture) {
+            d3dContext->CopyResource(staging.texture.Get(), tex.Get());
+            copied = true;
+        }
+    }
 
     D3D11_MAPPED_SUBRESOURCE mapped;
-    if (FAILED(d3dContext->Map(cpuTex.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return cv::Mat();
-
-    cv::Mat img(desc.Height, desc.Width, CV_8UC4, mapped.pData, mapped.RowPitch);
-    cv::Mat bgr;
-    cv::cvtColor(img.clone(), bgr, cv::COLOR_BGRA2BGR);
-
-    d3dContext->Unmap(cpuTex.Get(), 0);
+    if (copied && SUCCEEDED(d3dContext->Map(staging.texture.Get(), 0, D3D11_MAP_READ, 0, &mapped)))
+        staging.mapped = true;
     deskDupl->ReleaseFrame();
+    if (!staging.mapped) {
+        lease.reset();
+        return cv::Mat();
+    }
 
-    return bgr;
+    // Keep BGRA; the inference preprocessor reads the mapped rows directly
+    cv::Mat& img = lease.image();
+    img = cv::Mat(desc.Height, desc.Width, CV_8UC4, mapped.pData, mapped.RowPitch);
+    return img;
 }
     
-cv::Mat captureDxWindow(const std::wstring& windowName) {
-    cv::Mat full = captureDxFrame(); // Fullscreen capture
+cv::Mat captureDxWindow(const std::wstring& windowName, FrameLease& lease, cv::Rect* cropRect) {
+    cv::Mat full = captureDxFrame(lease); // Fullscreen capture
 
     HWND hwnd = FindWindowW(nullptr, windowName.c_str());
-    if (!hwnd || full.empty()) return cv::Mat();
+    if (!hwnd || full.empty()) {
+        lease.reset();
+        return cv::Mat();
+    }
 
     RECT rc;
     GetClientRect(hwnd, &rc);
@@ -86,14 +162,51 @@ cv::Mat captureDxWindow(const std::wstring& windowName) {
     int height = rc.bottom - rc.top;
 
     // Bounds safety check
-    if (pt.x < 0 || pt.y < 0 || pt.x + width > full.cols || pt.y + height > full.rows)
+    if (pt.x < 0 || pt.y < 0 || pt.x + width > full.cols || pt.y + height > full.rows) {
+        lease.reset();
         return cv::Mat();
+    }
+
+    cv::Rect crop(pt.x, pt.y, width, height);
+    if (cropRect) *cropRect = crop;
+    return full(crop); // View of the window area, same lease
+}
+
+FrameChanges lastDxFrameChanges() {
+    return dxChanges;
+}
+
+FramePoolStats dxCaptureBufferStats() {
+    return framePool ? framePool->stats() : FramePoolStats();
+}
 
-    return full(cv::Rect(pt.x, pt.y, width, height)).clone(); // Crop to the window area
+CaptureStatus DxgiFrameSource::grab(cv::Mat& image) {
+    if (windowName.empty()) {
+        image = captureDxFrame(lease);
+        changes = lastDxFrameChanges();
+    }
+    else {
+        cv::Rect crop;
+        image = captureDxWindow(windowName, lease, &crop);
+        changes = lastDxFrameChanges();
+        // Desktop coordinates -> window-crop coordinates, dropping what lies outside
+        if (changes.known) {
+            std::vector<cv::Rect> inside;
+            for (const cv::Rect& r : changes.regions) {
+                cv::Rect clipped = r & crop;
+                if (!clipped.empty()) inside.emplace_back(clipped.x - crop.x, clipped.y - crop.y, clipped.width, clipped.height);
+            }
+            changes.regions.swap(inside);
+        }
+    }
+    return image.empty() ? CaptureStatus::NoFrame : CaptureStatus::Frame;
 }
 
 
 void releaseDxCapture() {
+    for (StagingTexture& staging : stagingTextures)
+        if (staging.mapped) d3dContext->Unmap(staging.texture.Get(), 0);
+    stagingTextures.clear(); // The pool itself stays: a source may still hold its last lease
     deskDupl.Reset();
     d3dContext.Reset();
     d3dDevice.Reset();
@@ -4,8 +4,33 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <string>
+#include "frame_source.h"
+#include "pipeline.h"
 
-bool initializeDxCapture();
-cv::Mat captureDxFrame();
-cv::Mat captureDxWindow(const std::wstring& windowName);
-void releaseDxCapture();
+// Frames are copied on the GPU into a ring of staging textures, one per FramePool slot, and stay
+// mapped while leased: the returned BGRA image is a view of the mapped texture, valid while
+// `lease` (or a copy of it) is held. Empty image and lease on timeout, or when every buffer is held.
+bool initializeDxCapture(int frameBuffers = pipelineFramesInFlight);
+cv::Mat captureDxFrame(FrameLease& lease); // BGRA
+cv::Mat captureDxWindow(const std::wstring& windowName, FrameLease& lease, cv::Rect* cropRect = nullptr);
+FrameChanges lastDxFrameChanges(); // Dirty + move rects of the last captureDxFrame, desktop pixels
+FramePoolStats dxCaptureBufferStats();
+void releaseDxCapture(); // After the pipeline has stopped: leased images are unreadable from here on
+
+// Live desktop capture as a FrameSource (call initializeDxCapture first).
+// With a window name, frames are cropped to that window's client area.
+class DxgiFrameSource : public FrameSource {
+public:
+    DxgiFrameSource() = default;
+    explicit DxgiFrameSource(const std::wstring& windowName) : windowName(windowName) {}
+    CaptureStatus grab(cv::Mat& image) override;
+    std::string describe() const override { return windowName.empty() ? "dxgi:desktop" : "dxgi:window"; }
+    FrameChanges lastChanges() const override { return changes; }
+    FrameLease lastLease() const override { return lease; }
+
+private:
+    std::wstring windowName;
+    FrameChanges changes;
+    FrameLease lease;
+};
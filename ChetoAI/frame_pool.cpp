@@ -0,0 +1,74 @@
+#include "frame_pool.h"
+
+FrameLease::FrameLease(const FrameLease& other) : pool(other.pool), index(other.index) {
+    if (pool) pool->retain(index);
+}
+
+FrameLease::FrameLease(FrameLease&& other) noexcept : pool(other.pool), index(other.index) {
+    other.pool = nullptr;
+    other.index = -1;
+}
+
+FrameLease& FrameLease::operator=(const FrameLease& other) {
+    if (this == &other) return *this;
+    if (other.pool) other.pool->retain(other.index);
+    reset();
+    pool = other.pool;
+    index = other.index;
+    return *this;
+}
+
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this == &other) return *this;
+    reset();
+    pool = other.pool;
+    index = other.index;
+    other.pool = nullptr;
+    other.index = -1;
+    return *this;
+}
+
+cv::Mat& FrameLease::image() const {
+    return pool->slots[index].image;
+}
+
+void FrameLease::reset() {
+    if (pool) pool->release(index);
+    pool = nullptr;
+    index = -1;
+}
+
+FramePool::FramePool(int slots) : slots(slots > 0 ? slots : 1) {}
+
+FrameLease FramePool::acquire() {
+    for (int i = 0; i < size(); ++i) {
+        int expected = 0;
+        // Acquire pairs with the last holder's release, so its reads are done before we overwrite
+        if (!slots[i].refs.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                                   std::memory_order_relaxed))
+            continue;
+        acquiredCount.fetch_add(1, std::memory_order_relaxed);
+        const int held = inUse();
+        int previous = peak.load(std::memory_order_relaxed);
+        while (held > previous && !peak.compare_exchange_weak(previous, held)) {
+        }
+        return FrameLease(this, i);
+    }
+    exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+    return FrameLease();
+}
+
+int FramePool::inUse() const {
+    int held = 0;
+    for (const Slot& slot : slots)
+        if (slot.refs.load(std::memory_order_relaxed) > 0) ++held;
+    return held;
+}
+
+FramePoolStats FramePool::stats() const {
+    FramePoolStats s;
+    s.acquired = acquiredCount.load();
+    s.exhausted = exhaustedCount.load();
+    s.peakInUse = peak.load();
+    return s;
+}
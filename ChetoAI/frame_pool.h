@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Fixed set of reusable frame buffers for the capture side. The producer fills a slot and hands
+// out views of it. A FrameLease keeps the slot alive through the pipeline: copies share it, and
+// the slot becomes free again when the last lease is gone, on whichever thread that happens.
+// Nothing is copied or allocated per frame once every slot has held a frame of the current size.
+//
+// acquire() takes the lowest free slot, so only as many slots get storage (or, for desktop
+// capture, a staging texture) as are actually in flight at once. When all are held the producer
+// gets an empty lease and should report NoFrame: that is the back-pressure.
+//
+// The pool must outlive every lease it handed out.
+
+class FramePool;
+
+class FrameLease {
+public:
+    FrameLease() = default;
+    FrameLease(const FrameLease& other);
+    FrameLease(FrameLease&& other) noexcept;
+    FrameLease& operator=(const FrameLease& other);
+    FrameLease& operator=(FrameLease&& other) noexcept;
+    ~FrameLease() { reset(); }
+
+    explicit operator bool() const { return pool != nullptr; }
+    int slot() const { return index; }
+    // Slot storage. Only the producer writes it, before the first copy of the lease is passed on
+    cv::Mat& image() const;
+    void reset();
+
+private:
+    friend class FramePool;
+    FrameLease(FramePool* pool, int index) : pool(pool), index(index) {}
+
+    FramePool* pool = nullptr;
+    int index = -1;
+};
+
+struct FramePoolStats {
+    uint64_t acquired = 0;
+    uint64_t exhausted = 0;          // acquire() calls that found every slot held
+    int peakInUse = 0;
+};
+
+class FramePool {
+public:
+    explicit FramePool(int slots = 4);
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // A free slot, held once; empty when all slots are held. Producer thread only
+    FrameLease acquire();
+
+    int size() const { return static_cast<int>(slots.size()); }
+    int inUse() const;
+    bool held(int slot) const { return slots[slot].refs.load(std::memory_order_acquire) > 0; }
+    FramePoolStats stats() const;
+
+private:
+    friend class FrameLease;
+
+    struct Slot {
+        std::atomic<int> refs{ 0 };
+        cv::Mat image;
+    };
+
+    void retain(int slot) { slots[slot].refs.fetch_add(1, std::memory_order_relaxed); }
+    void release(int slot) { slots[slot].refs.fetch_sub(1, std::memory_order_acq_rel); }
+
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> acquiredCount{ 0 };
+    std::atomic<uint64_t> exhaustedCount{ 0 };
+    std::atomic<int> peak{ 0 };
+};
@@ -0,0 +1,84 @@
+#include "frame_source.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace {
+
+bool isImageFile(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp";
+}
+
+} // namespace
+
+ImageDirectorySource::ImageDirectorySource(const std::string& directory, int loops)
+    : directory(directory), loops(loops) {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file() && isImageFile(entry.path()))
+            files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+}
+
+CaptureStatus ImageDirectorySource::grab(cv::Mat& image) {
+    if (files.empty()) return CaptureStatus::EndOfStream;
+    if (next >= files.size()) {
+        ++pass;
+        if (loops > 0 && pass >= loops) return CaptureStatus::EndOfStream;
+        next = 0;
+    }
+    image = cv::imread(files[next++], cv::IMREAD_COLOR);
+    return image.empty() ? CaptureStatus::NoFrame : CaptureStatus::Frame;
+}
+
+std::string ImageDirectorySource::describe() const {
+    return "images:" + directory + " (" + std::to_string(files.size()) + " frames)";
+}
+
+VideoFileSource::VideoFileSource(const std::string& path, int loops, int frameBuffers)
+    : path(path), capture(path), loops(loops), pool(frameBuffers) {
+}
+
+CaptureStatus VideoFileSource::grab(cv::Mat& image) {
+    image.release();
+    lease.reset();
+    if (!capture.isOpened()) return CaptureStatus::EndOfStream;
+    lease = pool.acquire();
+    if (!lease) return CaptureStatus::NoFrame;
+    // Decodes into the slot's buffer, which is reused once it has the frame size
+    cv::Mat& frame = lease.image();
+    if (!capture.read(frame) || frame.empty()) {
+        ++pass;
+        capture.release();
+        if ((loops > 0 && pass >= loops) || !capture.open(path) || !capture.read(frame) || frame.empty()) {
+            lease.reset();
+            return CaptureStatus::EndOfStream;
+        }
+    }
+    image = frame;
+    return CaptureStatus::Frame;
+}
+
+std::string VideoFileSource::describe() const {
+    return "video:" + path;
+}
+
+double VideoFileSource::frameInterval() const {
+    const double fps = capture.get(cv::CAP_PROP_FPS);
+    return fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+std::unique_ptr<FrameSource> openRecording(const std::string& path, int loops) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        auto source = std::make_unique<ImageDirectorySource>(path, loops);
+        if (source->frameCount() == 0) return nullptr;
+        return source;
+    }
+    auto video = std::make_unique<VideoFileSource>(path, loops);
+    if (!video->isOpen()) return nullptr;
+    return video;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "frame_pool.h"
+
+enum class CaptureStatus {
+    Frame,      // `image` holds a new frame
+    NoFrame,    // Nothing new yet (e.g. DXGI timeout); try again
+    EndOfStream // Source exhausted
+};
+
+// What a source knows about which parts of a frame differ from its previous frame.
+struct FrameChanges {
+    bool known = false;            // false: anything may have changed
+    std::vector<cv::Rect> regions; // Changed areas in frame pixels (only meaningful when known)
+
+    // Fold in the changes of a frame that was skipped before this one
+    void merge(const FrameChanges& skipped) {
+        if (!skipped.known) {
+            known = false;
+            regions.clear();
+        }
+        else if (known) {
+            regions.insert(regions.end(), skipped.regions.begin(), skipped.regions.end());
+        }
+    }
+};
+
+// Anything that produces frames for the pipeline: live capture or a recording.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    virtual CaptureStatus grab(cv::Mat& image) = 0;
+    virtual std::string describe() const = 0;
+    // Changes of the most recently grabbed frame; sources without that knowledge report unknown
+    virtual FrameChanges lastChanges() const { return {}; }
+    // Seconds between frames of a recording; 0 when unknown (image directories, live capture)
+    virtual double frameInterval() const { return 0.0; }
+    // Keeps the pooled buffer behind the last grabbed image alive past the next grab(); empty for
+    // sources whose images own their pixels. Without it the image is only valid until then
+    virtual FrameLease lastLease() const { return {}; }
+};
+
+// Replays every .png/.jpg/.bmp in a directory in filename order.
+class ImageDirectorySource : public FrameSource {
+public:
+    // loops: how many passes over the directory (<= 0 repeats forever)
+    explicit ImageDirectorySource(const std::string& directory, int loops = 1);
+    CaptureStatus grab(cv::Mat& image) override;
+    std::string describe() const override;
+    size_t frameCount() const { return files.size(); }
+
+private:
+    std::string directory;
+    std::vector<std::string> files;
+    size_t next = 0;
+    int loops;
+    int pass = 0;
+};
+
+// Replays a video file through cv::VideoCapture, decoding into a small pool of reused frames.
+// grab() reports NoFrame while every pooled frame is still leased downstream.
+class VideoFileSource : public FrameSource {
+public:
+    explicit VideoFileSource(const std::string& path, int loops = 1, int frameBuffers = 4);
+    CaptureStatus grab(cv::Mat& image) override;
+    std::string describe() const override;
+    double frameInterval() const override;
+    FrameLease lastLease() const override { return lease; }
+    bool isOpen() const { return capture.isOpened(); }
+    const FramePool& buffers() const { return pool; }
+
+private:
+    std::string path;
+    cv::VideoCapture capture;
+    int loops;
+    int pass = 0;
+    FramePool pool;
+    FrameLease lease;
+};
+
+// Picks ImageDirectorySource or VideoFileSource from the path; nullptr if neither opens.
+std::unique_ptr<FrameSource> openRecording(const std::string& path, int loops = 1);
@@ -0,0 +1,54 @@
+#include "latency_stats.h"
+#include <algorithm>
+#include <cmath>
+
+// Bucket 0 holds [0, 1); then `subBuckets` linear buckets per power of two
+LatencyHistogram::LatencyHistogram()
+    : buckets(1 + subBuckets * exponents, 0) {
+}
+
+void LatencyHistogram::add(double us) {
+    if (!(us >= 0.0)) us = 0.0;
+    size_t index = 0;
+    if (us >= 1.0) {
+        int exponent;
+        double mantissa = std::frexp(us, &exponent); // us = mantissa * 2^exponent, mantissa in [0.5, 1)
+        int e = std::min(exponent - 1, exponents - 1);
+        int sub = std::min(subBuckets - 1, static_cast<int>((mantissa * 2.0 - 1.0) * subBuckets));
+        index = 1 + static_cast<size_t>(e) * subBuckets + sub;
+    }
+    ++buckets[index];
+
+    if (total == 0 || us < minValue) minValue = us;
+    if (total == 0 || us > maxValue) maxValue = us;
+    ++total;
+    sum += us;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    total = 0;
+    sum = 0.0;
+    minValue = maxValue = 0.0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0.0;
+    const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * (total - 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (buckets[i] == 0 || static_cast<double>(seen) <= rank) continue;
+
+        // Bucket midpoint, clamped to the observed range
+        double value = 0.5;
+        if (i > 0) {
+            const size_t e = (i - 1) / subBuckets;
+            const size_t sub = (i - 1) % subBuckets;
+            const double base = std::ldexp(1.0, static_cast<int>(e));
+            value = base * (1.0 + (sub + 0.5) / subBuckets);
+        }
+        return std::clamp(value, minValue, maxValue);
+    }
+    return maxValue;
+}
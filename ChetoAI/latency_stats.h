@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+inline double elapsedUs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// Fixed-size log-linear latency histogram (microseconds). add() never allocates,
+// so it can sit on the frame path. Percentiles are accurate to ~1/16 of a power of two.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(double us);
+    void reset();
+
+    uint64_t count() const { return total; }
+    double mean() const { return total ? sum / total : 0.0; }
+    double min() const { return total ? minValue : 0.0; }
+    double max() const { return total ? maxValue : 0.0; }
+    double percentile(double p) const; // p in [0, 100]
+
+private:
+    static constexpr int subBuckets = 16;
+    static constexpr int exponents = 40;
+
+    std::vector<uint64_t> buckets;
+    uint64_t total = 0;
+    double sum = 0.0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+};
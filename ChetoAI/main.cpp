@@ -4,57 +4,21 @@
 #include "dx_capture.h"
 #include "onnx_inference.h"
 #include "physics.h"
-#include "enums.h"
-
-// Convert YOLO detections to Ball and Table structs
-void processDetections(const std::vector<Detection>& detections, Ball& cueBall, Ball& targetBall, Table& table, int screenWidth, int screenHeight) {
-    table.pockets.clear();
-    bool cueFound = false, targetFound = false;
-
-    for (const auto& det : detections) {
-        cv::Point2f center(det.box.x + det.box.width / 2.0f, det.box.y + det.box.height / 2.0f);
-        float radius = std::min(det.box.width, det.box.height) / 2.0f;
-
-        // Scale coordinates to overlay resolution
-        center.x = (center.x / screenWidth) * 1920.0f;
-        center.y = (center.y / screenHeight) * 1080.0f;
-        radius = (radius / screenWidth) * 1920.0f;
-
-        switch (static_cast<ObjectType>(det.class_id)) {
-        case ObjectType::White:
-            cueBall = { center, radius, BallType::Cue };
-            cueFound = true;
-            break;
-        case ObjectType::Ball:
-            if (!targetFound) {
-                targetBall = { center, radius, BallType::Target };
-                targetFound = true;
-            }
-            break;
-        case ObjectType::Hole:
-            table.pockets.push_back(center);
-            break;
-        case ObjectType::PlayArea:
-            table.bounds = cv::Rect(
-                static_cast<int>((det.box.x / static_cast<float>(screenWidth)) * 1920.0f),
-                static_cast<int>((det.box.y / static_cast<float>(screenHeight)) * 1080.0f),
-                static_cast<int>((det.box.width / static_cast<float>(screenWidth)) * 1920.0f),
-                static_cast<int>((det.box.height / static_cast<float>(screenHeight)) * 1080.0f)
-            );
-            break;
-        default:
-            break;
-        }
-    }
-
-    // Optional debug
-    if (!cueFound || !targetFound || table.pockets.empty()) {
-        OutputDebugStringA("Warning: Missing cue/target ball or pockets.\n");
-    }
-}
+#include "pipeline.h"
+#include "cascade.h"
+#include "change_detector.h"
+#include "cushions.h"
+#include "physics_cache.h"
+#include "scene.h"
+#include "table_roi.h"
+#include "tracker.h"
+#include "debug_log.h"
+#include "trace.h"
+#include "Enums.h"
+#include <memory>
 
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nCmdShow) {
-    OutputDebugStringA("Main Called\n");
+    debugLog("Main Called\n");
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
 
@@ -72,6 +36,19 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         MessageBoxA(nullptr, "Failed to load ONNX model!", "Error", MB_OK);
         return 1;
     }
+    // Optional detector cascade (cascade.h): a small model finds White/Ball/Guideline on every frame
+    // and the model above runs only on a schedule or a scene change. Empty: the model above only
+    const std::string fastModelPath = "";
+    const std::vector<ObjectType> fastModelClasses = {}; // Its class order if trained on a subset
+    std::unique_ptr<ONNXInference> fastDetector;
+    if (!fastModelPath.empty()) {
+        fastDetector = std::make_unique<ONNXInference>(fastModelPath);
+        if (!fastDetector->isSessionValid()) {
+            MessageBoxA(nullptr, "Failed to load the cascade's fast ONNX model!", "Error", MB_OK);
+            return 1;
+        }
+        fastDetector->setClassTypes(fastModelClasses);
+    }
 
     // Initialize DirectX Capture
     if (!initializeDxCapture()) {
@@ -79,63 +56,181 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         return 1;
     }
 
-    MSG msg = { 0 };
-    float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f }; // Line color
-
-    while (msg.message != WM_QUIT) {
-        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        }
-
-        // Capture the game frame (you can switch to nullptr for full screen)
-        cv::Mat frame = captureDxFrame();
-        //cv::Mat frame = captureDxWindow(L"image.jpg");
-        cv::imwrite("debug_frame.jpg", frame);
-        OutputDebugStringA("Saved debug_frame.jpg\n");
-        if (frame.empty()){
-            OutputDebugStringA("Frame is empty!\n"); // Add this line
-            continue;
+    const DrawColor red{ 1.0f, 0.0f, 0.0f, 1.0f }; // Line color
+
+    // Stage 1 (capture thread): grab the newest desktop frame, as a view of a pooled staging texture
+    DxgiFrameSource source;
+    //DxgiFrameSource source(L"image.jpg");
+    auto captureStage = [&source](cv::Mat& image, FrameChanges& changes, FrameLease& lease) {
+        CaptureStatus status = source.grab(image);
+        changes = source.lastChanges();
+        lease = source.lastLease();
+        return status;
+    };
+
+    // Stage 2 (inference thread): full frame until the table is found, then only the table crop.
+    // Frames where nothing on the table changed reuse the previous detections. With a fast model,
+    // the cascade decides per frame whether the main model runs at all.
+    TableRoiTracker tableRoi(detector);
+    std::unique_ptr<CascadeDetector> cascade;
+    if (fastDetector)
+        cascade = std::make_unique<CascadeDetector>(
+            [&tableRoi, &fastDetector](const cv::Mat& image) { return tableRoi.runOther(*fastDetector, image); },
+            [&tableRoi](const cv::Mat& image) { return tableRoi.run(image); });
+    const FrameChanges* frameChanges = nullptr; // Of the frame being detected, for the cascade
+    GatedDetector gate(
+        [&tableRoi, &cascade, &frameChanges](const cv::Mat& image) {
+            return cascade ? cascade->run(image, *frameChanges) : tableRoi.run(image);
+        },
+        GateConfig(),
+        [&tableRoi]() { return tableRoi.locked() ? tableRoi.roi() : cv::Rect(); });
+    auto inferenceStage = [&gate, &frameChanges](const FramePacket& frame, DetectionPacket& result) {
+        frameChanges = &frame.changes;
+        result.detections = gate.run(frame.image, frame.changes);
+        result.reused = gate.lastReused();
+    };
+
+    // Stage 3 (physics/render thread): the overlay's D3D context is only used here
+    // Balls are tracked across frames; physics sees them extrapolated to the moment of drawing.
+    // Between detections the overlay is redrawn at display refresh from the extrapolated balls.
+    DEVMODEA displayMode = {};
+    displayMode.dmSize = sizeof(displayMode);
+    const double displayHz = EnumDisplaySettingsA(nullptr, ENUM_CURRENT_SETTINGS, &displayMode)
+        && displayMode.dmDisplayFrequency > 1 ? displayMode.dmDisplayFrequency : 60.0;
+    bool overlayDrawn = false;
+    BallTracker tracker;
+    tracker.settings().latencyCompensation = 1.0 / displayHz; // Present + scan-out, about one refresh
+    std::vector<Detection> lastDetections; // Of the newest packet, redrawn on display ticks
+    int frameWidth = 0, frameHeight = 0;
+    std::vector<TrackedBall> trackedBalls;
+    std::vector<Ball> otherBalls;
+    int targetId = -1;
+    Simulator simulator;
+    ShotRanking ranking;
+    Table table;                 // Reused so the pocket list keeps its capacity
+    CushionTable cushions;       // Rebuilt only when the table moves
+    SimState layout;
+    GuideBuffer guide;
+    const GuideBuffer* lines = nullptr; // What the overlay draws: guide or a cache entry
+    ShotEnsemble ensemble;       // Pocketing probability and direction cone of the ranked shot
+    ShotUncertainty uncertainty;
+    GuideBuffer cone;
+    PhysicsCache physicsCache;   // Rollouts, guidelines and ensembles of layouts seen recently
+    DrawList drawList;           // One frame's primitives, uploaded and drawn in one call
+    D3D11DrawBackend overlayBackend(&overlayData);
+    auto drawFrame = [&](PipelineClock::time_point now) {
+        Ball cueBall{}, targetBall{};
+        {
+            CHETO_TRACE_SCOPE("processDetections");
+            tracker.predictAt(pipelineSeconds(now), trackedBalls);
+            processTrackedScene(lastDetections, trackedBalls, targetId, cueBall, targetBall, table,
+                frameWidth, frameHeight, &otherBalls, &ranking);
+            cushions.update(table, lastDetections, frameWidth, frameHeight);
         }
-        OutputDebugStringA("Frame captured!\n");
 
-        int frameWidth = frame.cols;
-        int frameHeight = frame.rows;
-
-        std::vector<Detection> detections = detector.runInference(frame);
-        if (detections.empty()) {
-            OutputDebugStringA("No detections found.\n");
-        }
-        else {
-            OutputDebugStringA("Detections found.\n");
+        {
+            CHETO_TRACE_SCOPE("physics");
+            // Aim at the ranked shot's ghost ball when the target has one. Full-table rollout when the
+            // play area is known; plain guideline otherwise. Nothing here allocates, and an unchanged
+            // layout is answered from the cache
+            const GuideBall cueGuide = toGuideBall(cueBall), targetGuide = toGuideBall(targetBall);
+            const GuideTable tableGuide = toGuideTable(table, &cushions);
+            const RankedShot* shot = ranking.findBall(targetId);
+            lines = nullptr;
+            if (cueBall.radius > 0.0f && targetId >= 0) {
+                toSimLayout(cueBall, targetBall, otherBalls, layout);
+                const GuidePoint aim = shot ? GuidePoint{ shot->ghostX, shot->ghostY }
+                                            : Physics::computeGhostBall(cueGuide, targetGuide);
+                const CachedRollout& rollout = physicsCache.rollout(layout, cueBall.radius, tableGuide, aim,
+                    simulatedShotSpeed, simulator);
+                if (rollout.valid && rollout.path.count > 0) lines = &rollout.path;
+            }
+            if (!lines) {
+                if (shot) {
+                    rankedShotGuideline(cueGuide, targetGuide, *shot, tableGuide, guide);
+                    lines = &guide;
+                }
+                else {
+                    lines = &physicsCache.guideline(cueGuide, targetGuide, tableGuide);
+                }
+            }
+            cone.clear();
+            if (shot && cueBall.radius > 0.0f && shot->pocket < tableGuide.pocketCount) {
+                uncertainty = physicsCache.uncertainty(ensemble, toEnsembleShot(lastDetections, cueBall, targetBall,
+                    *shot, table, frameWidth, frameHeight, ensemble.settings()));
+                uncertaintyConeGuideline(targetGuide, tableGuide.pockets[shot->pocket], uncertainty, cone);
+            }
         }
 
-        Ball cueBall, targetBall;
-        Table table;
-        processDetections(detections, cueBall, targetBall, table, frameWidth, frameHeight);
-
-        ClearOverlay(&overlayData);
-        OutputDebugStringA("Cleared overlay.\n");
-
-        overlayData.deviceContext->OMSetRenderTargets(1, &overlayData.renderTargetView, nullptr);
-
-        OutputDebugStringA("Manually Drawing Test Line\n");
-        //Test
-        DrawLine(100, 100, 600, 600, red, &overlayData);
-
-        std::vector<LineSegment> guide = calculateGuideline(cueBall, targetBall, table);
-        for (const auto& segment : guide) {
-            DrawLine(segment.start.x, segment.start.y, segment.end.x, segment.end.y, red, &overlayData);
-            OutputDebugStringA("Guideline segment drawn.\n");
+        CHETO_TRACE_SCOPE("overlay");
+        drawList.clear();
+        drawList.segments(*lines, red);
+        // Opaque colours only: the overlay window is colour-keyed, not blended (overlay.h). The cone's
+        // rungs close up as the shot gets more likely to drop
+        const DrawColor coneColor{ 1.0f, 0.85f, 0.0f, 1.0f };
+        if (cone.count == 2)
+            drawList.hatchedCone(cone.segments[0].start, cone.segments[0].end, cone.segments[1].end,
+                40.0f - 28.0f * uncertainty.pocketProbability, coneColor);
+        drawList.segments(cone, coneColor);
+        overlayBackend.render(drawList);
+    };
+    auto renderStage = [&](const DetectionPacket& packet) {
+        tracker.update(packet.detections, pipelineSeconds(packet.captureTime));
+        // Same detections and nothing in motion: physics and overlay are up to date
+        if (packet.reused && overlayDrawn && !tracker.anyMoving()) return;
+        overlayDrawn = true;
+        lastDetections = packet.detections;
+        frameWidth = packet.frameWidth;
+        frameHeight = packet.frameHeight;
+        drawFrame(PipelineClock::now());
+    };
+    // Only moving balls change the picture between packets
+    auto displayTick = [&](PipelineClock::time_point now) {
+        if (overlayDrawn && tracker.anyMoving()) drawFrame(now);
+    };
+
+    PipelineConfig pipelineConfig;
+    pipelineConfig.displayHz = displayHz;
+    FramePipeline pipeline(captureStage, inferenceStage, renderStage, pipelineConfig);
+    pipeline.setDisplayTick(displayTick);
+    pipeline.start();
+
+    // Main thread only pumps window messages and watches the exit key
+    MSG msg = { 0 };
+    bool running = true;
+    while (running) {
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) running = false;
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
         }
-        PresentOverlay(&overlayData);
-
-        if (GetAsyncKeyState(VK_END) & 1) break;
-
-        Sleep(16); // ~60 FPS
+        if (GetAsyncKeyState(VK_END) & 1) running = false;
+        if (running) MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_ALLINPUT);
     }
 
-	OutputDebugStringA("Exiting...\n");
+    pipeline.stop();
+    PipelineStats stats = pipeline.stats();
+    debugLog("[Pipeline] captured %llu, rendered %llu (+%llu display ticks at %.0f Hz), dropped %llu/%llu,"
+        " latency mean %.1f ms max %.1f ms\n", stats.captured, stats.rendered, stats.displayTicks, displayHz,
+        stats.droppedBeforeInference, stats.droppedBeforeRender,
+        stats.meanLatencyUs / 1000.0, stats.maxLatencyUs / 1000.0);
+    const FramePoolStats bufferStats = dxCaptureBufferStats();
+    debugLog("[Capture] %llu frames through %d staging buffers at peak, %llu grabs with none free\n",
+        bufferStats.acquired, bufferStats.peakInUse, bufferStats.exhausted);
+    const TableRoiStats& roiStats = tableRoi.stats();
+    debugLog("[TableROI] full-frame %llu, roi %llu, locks %llu, lost %llu\n",
+        roiStats.fullFrames, roiStats.roiFrames, roiStats.locks, roiStats.lostLocks);
+    const CacheStats cacheStats = physicsCache.totals();
+    debugLog("[PhysicsCache] hit rate %.2f (rollout %.2f, guideline %.2f, ensemble %.2f), %llu evictions\n",
+        cacheStats.hitRate(), physicsCache.rolloutStats().hitRate(), physicsCache.guideStats().hitRate(),
+        physicsCache.ensembleStats().hitRate(), cacheStats.evictions);
+    const GateStats& gateStats = gate.stats();
+    debugLog("[Gate] inferred %llu, skipped %llu of %llu frames, ~%.1f ms CPU saved\n",
+        gateStats.inferred, gateStats.skipped, gateStats.frames, gateStats.savedUs() / 1000.0);
+    if (traceEnabled() && traceWriteChromeJson("cheto_trace.json"))
+        debugLog("[Trace] Wrote cheto_trace.json\n");
+
+	debugLog("Exiting...\n");
     releaseDxCapture();
     CleanupOverlay(&overlayData);
     return 0;
@@ -1,182 +1,463 @@
 #include "onnx_inference.h"
-#include <Windows.h>
 #include <iostream>
 #include <string>
 #include <algorithm>
-#include "enums.h"
+#include <cmath>
+#include <filesystem>
+#include "Enums.h"
+#include "debug_log.h"
+#include "latency_stats.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace {
+
+std::basic_string<ORTCHAR_T> ortPath(const std::string& path) {
+    return std::basic_string<ORTCHAR_T>(path.begin(), path.end());
+}
+
+std::string defaultOptimizedPath(const std::string& modelPath) {
+    std::filesystem::path path(modelPath);
+    path.replace_extension(".optimized.onnx");
+    return path.string();
+}
+
+// The saved graph is only trusted when it is at least as new as the model it was made from
+bool optimizedModelFresh(const std::string& optimizedPath, const std::string& modelPath) {
+    std::error_code ec;
+    const auto optimizedTime = std::filesystem::last_write_time(optimizedPath, ec);
+    if (ec) return false;
+    const auto modelTime = std::filesystem::last_write_time(modelPath, ec);
+    return !ec && optimizedTime >= modelTime;
+}
+
+// YOLO strides go down to 32 pixels
+bool validDynamicSize(cv::Size size) {
+    return size.width >= 32 && size.height >= 32 && size.width % 32 == 0 && size.height % 32 == 0;
+}
+
+bool isFloatTensor(const Ort::TypeInfo& info) {
+    return info.GetTensorTypeAndShapeInfo().GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+}
+
+} // namespace
+
+const char* modelPrecisionName(ModelPrecision precision) {
+    switch (precision) {
+    case ModelPrecision::Fp16: return "FP16";
+    case ModelPrecision::Int8: return "INT8";
+    default: return "FP32";
+    }
+}
+
+std::string modelResolutionPath(const std::string& modelPath, cv::Size inputSize) {
+    std::filesystem::path path(modelPath);
+    path.replace_extension("." + std::to_string(inputSize.width) + "x" + std::to_string(inputSize.height) + ".onnx");
+    return path.string();
+}
+
+std::string modelVariantPath(const std::string& modelPath, ModelPrecision precision) {
+    if (precision == ModelPrecision::Fp32) return modelPath;
+    std::filesystem::path path(modelPath);
+    path.replace_extension(precision == ModelPrecision::Fp16 ? ".fp16.onnx" : ".int8.onnx");
+    return path.string();
+}
 
-ONNXInference::ONNXInference(const std::string& modelPath)
+ONNXInference::ONNXInference(const std::string& modelPath, const InferenceConfig& config)
     : env(ORT_LOGGING_LEVEL_WARNING, "ChetoAI") {
     try {
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-
-        // Load model
-        std::wstring modelPathW(modelPath.begin(), modelPath.end());
-        session = std::make_unique<Ort::Session>(env, modelPathW.c_str(), sessionOptions);
+        loadedPath = modelVariantPath(modelPath, config.precision);
+        loadedPrecision = config.precision;
+        std::error_code ec;
+        if (loadedPrecision != ModelPrecision::Fp32 && !std::filesystem::exists(loadedPath, ec)) {
+            debugLog("[Model] No %s variant at %s, loading the FP32 model\n", modelPrecisionName(loadedPrecision),
+                loadedPath.c_str());
+            loadedPath = modelPath;
+            loadedPrecision = ModelPrecision::Fp32;
+        }
+        configureSession(config);
+        startup.cachePath = config.optimizedModelPath.empty() ? defaultOptimizedPath(loadedPath)
+                                                              : config.optimizedModelPath;
+        sessions.push_back(createSession(loadedPath, startup.cachePath, config));
+        Ort::Session* session = sessions[0].get();
         valid = true;
 
-        // Get input/output names
+        // Converted variants must keep float32 I/O (keep_io_types), which is all the buffers below handle
+        bool floatIo = isFloatTensor(session->GetInputTypeInfo(0));
+        for (size_t i = 0; i < session->GetOutputCount(); ++i)
+            floatIo = floatIo && isFloatTensor(session->GetOutputTypeInfo(i));
+        if (!floatIo) throw std::runtime_error(loadedPath + ": model input and outputs must be float32");
+
+        // Get input/output names. Copied out: the AllocatedStringPtr owning each name frees it
         Ort::AllocatorWithDefaultOptions allocator;
-        Ort::AllocatedStringPtr inputName = session->GetInputNameAllocated(0, allocator);
-        Ort::AllocatedStringPtr outputName = session->GetOutputNameAllocated(0, allocator);
-        inputNames.push_back(inputName.get());
-        outputNames.push_back(outputName.get());
+        inputNamesStr.push_back(session->GetInputNameAllocated(0, allocator).get());
+
+        // All outputs: boxes, plus mask prototypes for -seg models
+        for (size_t i = 0; i < session->GetOutputCount(); ++i)
+            outputNamesStr.push_back(session->GetOutputNameAllocated(i, allocator).get());
 
         // Output model shape for debugging
         Ort::TypeInfo inputTypeInfo = session->GetInputTypeInfo(0);
         auto inputShape = inputTypeInfo.GetTensorTypeAndShapeInfo().GetShape();
+        if (inputShape.size() != 4) throw std::runtime_error(loadedPath + ": expected a [1,3,H,W] input");
+        dynamicInput = inputShape[2] <= 0 || inputShape[3] <= 0;
         Ort::TypeInfo outputTypeInfo = session->GetOutputTypeInfo(0);
         auto outputShape = outputTypeInfo.GetTensorTypeAndShapeInfo().GetShape();
 
-        char buf[256];
-
-        sprintf_s(buf, "[Model] Input shape: %lldx%lldx%lldx%lld\n",
-            inputShape[0], inputShape[1], inputShape[2], inputShape[3]);
-        OutputDebugStringA(buf);
-
-        sprintf_s(buf, "[Model] Output shape total elements: %lld\n",
-            outputTypeInfo.GetTensorTypeAndShapeInfo().GetElementCount());
-        OutputDebugStringA(buf);
+        debugLog("[Model] Input shape: %lldx%lldx%lldx%lld%s\n",
+            (long long)inputShape[0], (long long)inputShape[1], (long long)inputShape[2], (long long)inputShape[3],
+            dynamicInput ? " (dynamic)" : "");
+        debugLog("[Model] Output shape total elements: %lld\n",
+            (long long)outputTypeInfo.GetTensorTypeAndShapeInfo().GetElementCount());
 
         size_t outputs = session->GetOutputCount();
-        sprintf_s(buf, "[Model] Number of outputs: %zu\n", outputs);
-        OutputDebugStringA(buf);
+        debugLog("[Model] Number of outputs: %zu\n", outputs);
 
         for (size_t i = 0; i < outputs; ++i) {
             Ort::TypeInfo outInfo = session->GetOutputTypeInfo(i);
             auto shape = outInfo.GetTensorTypeAndShapeInfo().GetShape();
-            sprintf_s(buf, "Output %zu shape: ", i);
-            OutputDebugStringA(buf);
-            for (auto dim : shape) {
-                sprintf_s(buf, "%lld ", dim);
-                OutputDebugStringA(buf);
-            }
-            OutputDebugStringA("\n");
-        };
+            std::string dims;
+            for (auto dim : shape) dims += std::to_string(dim) + " ";
+            debugLog("Output %zu shape: %s\n", i, dims.c_str());
+        }
 
+        // The model's own resolution first; a dynamic model starts at the first requested size
+        if (!dynamicInput)
+            addResolution(*session, static_cast<int>(inputShape[3]), static_cast<int>(inputShape[2]));
+        else if (!config.inputSizes.empty() && validDynamicSize(config.inputSizes[0]))
+            addResolution(*session, config.inputSizes[0].width, config.inputSizes[0].height);
+        else
+            addResolution(*session, 640, 640);
+        for (const cv::Size& size : config.inputSizes) {
+            bool loaded = false;
+            for (const auto& r : resolutions) loaded = loaded || (r->width == size.width && r->height == size.height);
+            if (loaded) continue;
+            if (!dynamicInput) addExport(modelPath, size, config);
+            else if (validDynamicSize(size)) addResolution(*session, size.width, size.height);
+        }
+        active = resolutions[0].get();
+
+        for (const auto& r : resolutions) warmUp(*r, config.warmupRuns);
+        debugLog("[Model] %s %s start: session %.1f ms%s, warm-up %d runs x %zu sizes %.1f ms (first %.1f ms)\n",
+            modelPrecisionName(loadedPrecision), startup.fromCache ? "warm" : "cold", startup.sessionMs,
+            startup.fromCache ? " from the optimized model" : startup.cacheWritten ? ", optimized model saved" : "",
+            config.warmupRuns, resolutions.size(), startup.warmupMs, startup.firstRunMs);
     }
-    catch (const Ort::Exception& e) {
+    catch (const std::exception& e) { // Ort::Exception, or unusable model I/O
         valid = false;
+#ifdef _WIN32
         MessageBoxA(nullptr, e.what(), "ONNX Load Error", MB_OK | MB_ICONERROR);
+#else
+        std::cerr << "[ONNX Load Error] " << e.what() << std::endl;
+#endif
+    }
+}
+
+std::vector<cv::Size> ONNXInference::inputSizes() const {
+    std::vector<cv::Size> sizes;
+    for (const auto& r : resolutions) sizes.emplace_back(r->width, r->height);
+    return sizes;
+}
+
+bool ONNXInference::setInputSize(cv::Size size) {
+    for (const auto& r : resolutions) {
+        if (r->width != size.width || r->height != size.height) continue;
+        active = r.get();
+        return true;
+    }
+    if (!valid || !dynamicInput || !validDynamicSize(size)) return false;
+    try {
+        addResolution(*sessions[0], size.width, size.height);
+    }
+    catch (const Ort::Exception& e) {
+        std::cerr << "[ONNX Runtime ERROR] " << e.what() << std::endl;
+        return false;
     }
+    active = resolutions.back().get();
+    return true;
+}
+
+cv::Size ONNXInference::closestInputSize(cv::Size frame) const {
+    if (resolutions.empty() || frame.width <= 0 || frame.height <= 0) return inputSize();
+    const double frameAspect = std::log(static_cast<double>(frame.width) / frame.height);
+    const Resolution* best = nullptr;
+    double bestError = 0.0;
+    for (const auto& r : resolutions) {
+        const double error = std::abs(std::log(static_cast<double>(r->width) / r->height) - frameAspect);
+        const bool tie = best && std::abs(error - bestError) < 1e-6;
+        if (!best || (!tie && error < bestError) || (tie && r->width * r->height > best->width * best->height)) {
+            best = r.get();
+            bestError = error;
+        }
+    }
+    return cv::Size(best->width, best->height);
 }
 
 std::vector<Detection> ONNXInference::runInference(const cv::Mat& frame) {
     std::vector<Detection> detections;
+    runInference(frame, detections);
+    return detections;
+}
+
+void ONNXInference::runInference(const cv::Mat& frame, std::vector<Detection>& detections) {
+    detections.clear();
 
     if (!valid) {
         std::cerr << "[ERROR] ONNX model session is not valid." << std::endl;
-        return detections;
+        return;
     }
 
     if (frame.empty()) {
         std::cerr << "[ERROR] Input frame is empty." << std::endl;
-        return detections;
+        return;
     }
 
-    // Preprocess image
-    cv::Mat resized;
-    cv::resize(frame, resized, cv::Size(inputWidth, inputHeight));
-    cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
-    resized.convertTo(resized, CV_32F, 1.0 / 255.0);
-
-    std::vector<float> inputTensorValues(inputWidth * inputHeight * 3);
-    for (int c = 0; c < 3; ++c)
-        for (int h = 0; h < inputHeight; ++h)
-            for (int w = 0; w < inputWidth; ++w)
-                inputTensorValues[c * inputWidth * inputHeight + h * inputWidth + w] =
-                resized.at<cv::Vec3f>(h, w)[c];
+    auto t0 = std::chrono::steady_clock::now();
+    Resolution& r = *active;
 
-    auto memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
-    std::vector<int64_t> inputShape = { 1, 3, inputHeight, inputWidth };
+    // Preprocess image (fused resize + RGB + scale + CHW into the persistent buffer)
+    {
+        CHETO_TRACE_SCOPE("preprocess");
+        if (!preprocessor.run(frame, r.input.data(), r.width, r.height)) {
+            std::cerr << "[ERROR] Unsupported frame format for preprocessing." << std::endl;
+            return;
+        }
+    }
 
-    Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-        memoryInfo, inputTensorValues.data(), inputTensorValues.size(),
-        inputShape.data(), inputShape.size());
+    auto t1 = std::chrono::steady_clock::now();
 
-    std::vector<Ort::Value> outputTensors;
     try {
-        outputTensors = session->Run(
-            Ort::RunOptions{ nullptr }, inputNames.data(), &inputTensor, 1,
-            outputNames.data(), outputNames.size());
+        CHETO_TRACE_SCOPE("session.Run");
+        runSession(r);
     }
     catch (const Ort::Exception& e) {
         std::cerr << "[ONNX Runtime ERROR] " << e.what() << std::endl;
-        return detections;
+        return;
     }
 
-    // === Output 0: Bounding Boxes ===
-    float* output = outputTensors[0].GetTensorMutableData<float>();
-    auto shape = outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
+    auto t2 = std::chrono::steady_clock::now();
+
+    // === Output 0: Bounding Boxes [1, 4 + classes + maskCoeffs, anchors] ===
+    float* output = r.outputTensors[0].GetTensorMutableData<float>();
+    const std::vector<int64_t>& shape = r.outputShapes[0];
     const int numChannels = (int)shape[1];
     const int numBoxes = (int)shape[2];
-    const int numClasses = numChannels - 4;
-
-    char buf[256];
-    for (int i = 0; i < numBoxes; ++i) {
-        float x = output[0 * numBoxes + i];
-        float y = output[1 * numBoxes + i];
-        float w = output[2 * numBoxes + i];
-        float h = output[3 * numBoxes + i];
-
-        int bestClass = -1;
-        float bestScore = 0.0f;
-        for (int c = 4; c < numChannels; ++c) {
-            float score = output[c * numBoxes + i];
-            if (score > bestScore) {
-                bestScore = score;
-                bestClass = c - 4;
-            }
-        }
 
-        if (bestScore > 0.5f) {
-            Detection det;
-            det.box = cv::Rect(
-                static_cast<int>(x - w / 2.0f),
-                static_cast<int>(y - h / 2.0f),
-                static_cast<int>(w),
-                static_cast<int>(h));
-            det.confidence = bestScore;
-            det.class_id = bestClass;
-            detections.push_back(det);
-
-            sprintf_s(buf, "[Box] Class %d | Conf %.2f | x=%.1f y=%.1f w=%.1f h=%.1f\n",
-                bestClass, bestScore, x, y, w, h);
-            OutputDebugStringA(buf);
-        }
+    // Seg models append one coefficient per prototype channel after the class scores
+    int numMaskCoeffs = 0;
+    if (r.outputTensors.size() > 1)
+        numMaskCoeffs = (int)r.outputShapes[1][1];
+
+    DecodeParams params = decodeParams;
+    params.numClasses = numChannels - 4 - numMaskCoeffs;
+    params.numMaskCoeffs = numMaskCoeffs;
+    params.scaleX = static_cast<float>(frame.cols) / r.width;  // Boxes come back in frame pixels
+    params.scaleY = static_cast<float>(frame.rows) / r.height;
+    {
+        CHETO_TRACE_SCOPE("decode");
+        decoder.decode(output, numChannels, numBoxes, params, detections);
+        if (!classTypes.empty())
+            for (Detection& det : detections)
+                det.type = det.class_id >= 0 && det.class_id < static_cast<int>(classTypes.size())
+                    ? classTypes[det.class_id] : ObjectType::Unknown;
     }
 
-    sprintf_s(buf, "[Detection] Total boxes: %zu\n", detections.size());
-    OutputDebugStringA(buf);
+    auto t3 = std::chrono::steady_clock::now();
 
-    // === Output 1: Segmentation Map [1, 32, 160, 160] ===
-    float* segData = outputTensors[1].GetTensorMutableData<float>();
-    auto segShape = outputTensors[1].GetTensorTypeAndShapeInfo().GetShape(); // [1, 32, 160, 160]
-    int segChannels = (int)segShape[1]; // 32
-    int segH = (int)segShape[2];
-    int segW = (int)segShape[3];
+    // === Output 1: Mask prototypes [1, 32, 160, 160], only for requested classes ===
+    if (!maskClasses.empty() && numMaskCoeffs > 0)
+        assembleMasks(output, numBoxes, 4 + params.numClasses, r.outputTensors[1], r.outputShapes[1], detections);
 
-    // Debug dump guideline mask (class 6)
-    int guidelineClass = 6; // 'Guideline'
-    cv::Mat mask(segH, segW, CV_32FC1);
-    for (int y = 0; y < segH; ++y) {
-        for (int x = 0; x < segW; ++x) {
-            int idx = guidelineClass * segH * segW + y * segW + x;
-            mask.at<float>(y, x) = segData[idx];
-        }
+    auto t4 = std::chrono::steady_clock::now();
+    timings.preprocessUs = elapsedUs(t0, t1);
+    timings.runUs = elapsedUs(t1, t2);
+    timings.decodeUs = elapsedUs(t2, t3);
+    timings.maskUs = elapsedUs(t3, t4);
+    if (startup.firstFrameMs == 0.0) startup.firstFrameMs = elapsedUs(t0, t4) / 1000.0;
+}
+
+void ONNXInference::configureSession(const InferenceConfig& config) {
+    if (config.intraOpThreads > 0) sessionOptions.SetIntraOpNumThreads(config.intraOpThreads);
+    if (config.parallelExecution) {
+        sessionOptions.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+        if (config.interOpThreads > 0) sessionOptions.SetInterOpNumThreads(config.interOpThreads);
+    }
+    else {
+        sessionOptions.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
     }
+    sessionOptions.AddConfigEntry("session.intra_op.allow_spinning", config.spinWait ? "1" : "0");
+    if (!config.threadAffinity.empty())
+        sessionOptions.AddConfigEntry("session.intra_op_thread_affinities", config.threadAffinity.c_str());
+}
 
-    // Apply threshold and convert to visual format
-    cv::Mat binaryMask;
-    cv::threshold(mask, binaryMask, 0.5, 1.0, cv::THRESH_BINARY);
-    binaryMask.convertTo(binaryMask, CV_8U, 255);
+// Warm start: load the graph saved by an earlier launch with optimizations off, which skips the
+// whole optimization pass. Cold start: optimize the source model and save the result for next time.
+// A saved graph that fails to load (e.g. written by another ONNX Runtime version) is rebuilt.
+std::unique_ptr<Ort::Session> ONNXInference::createSession(const std::string& modelPath, const std::string& cachePath,
+                                                           const InferenceConfig& config) {
+    const bool useCache = config.cacheOptimizedModel && config.optimization != GraphOptimizationLevel::ORT_DISABLE_ALL;
+    const std::basic_string<ORTCHAR_T> cachePathT = ortPath(cachePath);
+    auto t0 = std::chrono::steady_clock::now();
+    std::unique_ptr<Ort::Session> session;
+    bool fromCache = false;
+
+    if (useCache && optimizedModelFresh(cachePath, modelPath)) {
+        try {
+            sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            sessionOptions.SetOptimizedModelFilePath(ortPath("").c_str());
+            session = std::make_unique<Ort::Session>(env, cachePathT.c_str(), sessionOptions);
+            fromCache = true;
+        }
+        catch (const Ort::Exception& e) {
+            debugLog("[Model] Rebuilding optimized model %s: %s\n", cachePath.c_str(), e.what());
+        }
+    }
+    if (!session) {
+        sessionOptions.SetGraphOptimizationLevel(config.optimization);
+        const std::basic_string<ORTCHAR_T> modelPathT = ortPath(modelPath);
+        if (useCache) {
+            try {
+                sessionOptions.SetOptimizedModelFilePath(cachePathT.c_str());
+                session = std::make_unique<Ort::Session>(env, modelPathT.c_str(), sessionOptions);
+                startup.cacheWritten = true;
+            }
+            catch (const Ort::Exception& e) {
+                // Most likely an unwritable model directory: run without the cache
+                debugLog("[Model] Cannot save optimized model %s: %s\n", cachePath.c_str(), e.what());
+            }
+            sessionOptions.SetOptimizedModelFilePath(ortPath("").c_str());
+        }
+        if (!session) session = std::make_unique<Ort::Session>(env, modelPathT.c_str(), sessionOptions);
+    }
+    startup.fromCache = fromCache && (sessions.empty() || startup.fromCache);
+    startup.sessionMs += elapsedUs(t0, std::chrono::steady_clock::now()) / 1000.0;
+    return session;
+}
 
-    // Optional: save for debug
-    cv::imwrite("guideline_mask.jpg", binaryMask);
+// Another fixed-shape export of the same network. It must share the main model's input and output
+// names (same export pipeline), or the resolution is skipped
+void ONNXInference::addExport(const std::string& modelPath, cv::Size size, const InferenceConfig& config) {
+    const std::string path = modelVariantPath(modelResolutionPath(modelPath, size), loadedPrecision);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        debugLog("[Model] No %dx%d export at %s\n", size.width, size.height, path.c_str());
+        return;
+    }
+    std::unique_ptr<Ort::Session> session = createSession(path, defaultOptimizedPath(path), config);
+    const auto shape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    Ort::AllocatorWithDefaultOptions allocator;
+    bool matches = shape.size() == 4 && shape[2] == size.height && shape[3] == size.width
+        && session->GetOutputCount() == outputNamesStr.size()
+        && inputNamesStr[0] == session->GetInputNameAllocated(0, allocator).get();
+    for (size_t i = 0; matches && i < outputNamesStr.size(); ++i)
+        matches = outputNamesStr[i] == session->GetOutputNameAllocated(i, allocator).get();
+    if (!matches) {
+        debugLog("[Model] %s is not a %dx%d export of the main model, skipped\n", path.c_str(), size.width,
+            size.height);
+        return;
+    }
+    sessions.push_back(std::move(session));
+    addResolution(*sessions.back(), size.width, size.height);
+}
 
-    OutputDebugStringA("[Segmentation] Guideline mask saved.\n");
+// Input and outputs are allocated once and bound by name, so Run writes straight into them. Output
+// shapes a dynamic-shape model leaves open are bound after the first Run (see runSession).
+void ONNXInference::addResolution(Ort::Session& session, int width, int height) {
+    auto r = std::make_unique<Resolution>();
+    r->session = &session;
+    r->width = width;
+    r->height = height;
+    const std::vector<int64_t> inputShape = { 1, 3, height, width };
+    r->input.assign(static_cast<size_t>(width) * height * 3, 0.0f);
+    r->inputTensor = Ort::Value::CreateTensor<float>(memoryInfo, r->input.data(), r->input.size(),
+        inputShape.data(), inputShape.size());
+    r->binding = Ort::IoBinding(session);
+    r->binding.BindInput(inputNamesStr[0].c_str(), r->inputTensor);
+
+    const size_t outputs = outputNamesStr.size();
+    r->outputShapes.resize(outputs);
+    r->outputBuffers.resize(outputs);
+    std::vector<size_t> elements(outputs, 1);
+    for (size_t i = 0; i < outputs; ++i) {
+        r->outputShapes[i] = session.GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+        for (int64_t dim : r->outputShapes[i]) elements[i] = dim > 0 ? elements[i] * static_cast<size_t>(dim) : 0;
+        if (elements[i] == 0) r->dynamicOutputs = true;
+    }
+    for (size_t i = 0; i < outputs; ++i) {
+        if (r->dynamicOutputs) {
+            r->binding.BindOutput(outputNamesStr[i].c_str(), memoryInfo);
+            continue;
+        }
+        r->outputBuffers[i].assign(elements[i], 0.0f);
+        r->outputTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo, r->outputBuffers[i].data(),
+            r->outputBuffers[i].size(), r->outputShapes[i].data(), r->outputShapes[i].size()));
+        r->binding.BindOutput(outputNamesStr[i].c_str(), r->outputTensors.back());
+    }
+    resolutions.push_back(std::move(r));
+}
 
-    return detections;
+// Runs on a blank input: the first Run allocates the arena and picks kernels, which would
+// otherwise land on the first captured frame
+void ONNXInference::warmUp(Resolution& resolution, int runs) {
+    std::fill(resolution.input.begin(), resolution.input.end(), 0.0f);
+    for (int i = 0; i < runs; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        runSession(resolution);
+        const double ms = elapsedUs(t0, std::chrono::steady_clock::now()) / 1000.0;
+        if (startup.firstRunMs == 0.0) startup.firstRunMs = ms;
+        startup.warmupMs += ms;
+    }
 }
 
+// session->Run on the bound buffers; throws Ort::Exception. After the first Run of a dynamic-shape
+// size the output shapes are known (a YOLO head's depend on the input size only), so the outputs
+// get persistent buffers too and later runs allocate nothing.
+void ONNXInference::runSession(Resolution& r) {
+    r.session->Run(runOptions, r.binding);
+    if (!r.dynamicOutputs) return;
+    std::vector<Ort::Value> produced = r.binding.GetOutputValues();
+    r.binding.ClearBoundOutputs();
+    r.outputTensors.clear();
+    for (size_t i = 0; i < produced.size(); ++i) {
+        const Ort::TensorTypeAndShapeInfo info = produced[i].GetTensorTypeAndShapeInfo();
+        const float* data = produced[i].GetTensorData<float>();
+        r.outputShapes[i] = info.GetShape();
+        r.outputBuffers[i].assign(data, data + info.GetElementCount());
+        r.outputTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo, r.outputBuffers[i].data(),
+            r.outputBuffers[i].size(), r.outputShapes[i].data(), r.outputShapes[i].size()));
+        r.binding.BindOutput(outputNamesStr[i].c_str(), r.outputTensors.back());
+    }
+    r.dynamicOutputs = false;
+}
 
+void ONNXInference::assembleMasks(const float* output, int numAnchors, int coeffChannel, Ort::Value& protoTensor,
+                                  const std::vector<int64_t>& protoShape, std::vector<Detection>& detections) {
+    CHETO_TRACE_SCOPE("masks");
+    MaskPrototypes protos;
+    protos.data = protoTensor.GetTensorMutableData<float>();
+    protos.channels = (int)protoShape[1];
+    protos.height = (int)protoShape[2];
+    protos.width = (int)protoShape[3];
+
+    // Kept boxes are in model input pixels, same order as `detections`
+    const std::vector<DecodedBox>& boxes = decoder.keptBoxes();
+    const float toProtoX = static_cast<float>(protos.width) / active->width;
+    const float toProtoY = static_cast<float>(protos.height) / active->height;
+    maskCoeffs.resize(protos.channels);
+
+    for (size_t i = 0; i < detections.size() && i < boxes.size(); ++i) {
+        Detection& det = detections[i];
+        if (std::find(maskClasses.begin(), maskClasses.end(), det.type) == maskClasses.end()) continue;
+
+        const DecodedBox& b = boxes[i];
+        for (int k = 0; k < protos.channels; ++k)
+            maskCoeffs[k] = output[(coeffChannel + k) * numAnchors + b.anchor];
+
+        cv::Rect2f boxProto(b.x1 * toProtoX, b.y1 * toProtoY, (b.x2 - b.x1) * toProtoX, (b.y2 - b.y1) * toProtoY);
+        cv::Rect protoRect;
+        maskAssembler.assemble(protos, maskCoeffs.data(), boxProto, det.mask, protoRect);
+    }
+}
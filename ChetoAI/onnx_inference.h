@@ -3,39 +3,158 @@
 #include <string>
 #include <vector>
 #include <opencv2/opencv.hpp>
-#include <C:/onnxruntime/include/cpu_provider_factory.h>
-#include <C:/onnxruntime/include/onnxruntime_cxx_api.h>
-#include <C:/onnxruntime/include/onnxruntime_c_api.h>
-#include "enums.h"
+#include <cpu_provider_factory.h>
+#include <onnxruntime_cxx_api.h>
+#include <onnxruntime_c_api.h>
+#include "Enums.h"
 #include "physics.h"
+#include "detection.h"
+#include "preprocess.h"
+#include "seg_mask.h"
+#include "yolo_decode.h"
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 #include <locale>
 #include <codecvt>
 
-struct Detection {
-    cv::Rect box;
-    int class_id;
-    float confidence;
-    ObjectType type = ObjectType::Unknown;
-    BallType ball_type = BallType::Other;
+// Stage timings of the most recent runInference call, in microseconds
+struct InferenceTimings {
+    double preprocessUs = 0.0;
+    double runUs = 0.0;     // session->Run
+    double decodeUs = 0.0;  // Box decode + NMS
+    double maskUs = 0.0;    // Mask assembly (0 when no mask classes are requested)
+};
+
+// Model weights to run. Fp16 / Int8 load a converted copy next to the FP32 model
+// (<model>.fp16.onnx / <model>.int8.onnx, see tools/quantize_model.py) with float32 input and
+// outputs, so nothing past session.Run changes. A missing variant falls back to FP32.
+enum class ModelPrecision { Fp32, Fp16, Int8 };
+
+const char* modelPrecisionName(ModelPrecision precision);
+std::string modelVariantPath(const std::string& modelPath, ModelPrecision precision);
+
+// Fixed-shape export of the same model at another input size: <model>.<W>x<H>.onnx
+std::string modelResolutionPath(const std::string& modelPath, cv::Size inputSize);
+
+// Session setup. Thread counts of 0 leave the choice to ONNX Runtime (intra-op: one per physical core).
+struct InferenceConfig {
+    int intraOpThreads = 0;
+    int interOpThreads = 0;          // Only used with parallelExecution
+    bool parallelExecution = false;  // ORT_PARALLEL; a YOLO graph is one long chain, so this rarely pays
+    bool spinWait = true;            // Intra-op workers spin between ops instead of sleeping
+    std::string threadAffinity;      // session.intra_op_thread_affinities: one group per worker after the
+                                     // calling thread, 1-based logical processors, e.g. "3;4;5-6".
+                                     // Needs intraOpThreads set to the group count + 1
+    ModelPrecision precision = ModelPrecision::Fp32;
+    std::vector<cv::Size> inputSizes; // Extra selectable resolutions (e.g. 320x320, 480x480, 640x320). A
+                                      // dynamic-shape model runs them directly (multiples of 32; the
+                                      // first is the default, else 640x640). Otherwise each one is a
+                                      // separate export at modelResolutionPath(), skipped if missing
+    GraphOptimizationLevel optimization = ORT_ENABLE_ALL;
+    bool cacheOptimizedModel = true; // Save the optimized graph on the first launch, load it on later ones
+    std::string optimizedModelPath;  // Default: <loaded model>.optimized.onnx next to it (main model only)
+    int warmupRuns = 2;              // Blank-input runs per resolution at load, so the first real frame
+                                     // is not the slow one
+};
+
+// Load-time cost, in milliseconds. Cold start = no usable optimized graph on disk yet.
+struct InferenceStartup {
+    bool fromCache = false;          // Loaded the saved optimized graph (warm start), for every session
+    bool cacheWritten = false;       // Optimized a source model and saved the result
+    std::string cachePath;           // Of the main model
+    double sessionMs = 0.0;          // Session creation, including graph optimization on a cold start
+    double warmupMs = 0.0;           // All warm-up runs, every resolution
+    double firstRunMs = 0.0;         // First warm-up run alone (allocations, kernel selection)
+    double firstFrameMs = 0.0;       // First runInference call end to end; 0 until it happens
 };
 
 class ONNXInference {
 public:
-    ONNXInference(const std::string& modelPath);
+    explicit ONNXInference(const std::string& modelPath, const InferenceConfig& config = InferenceConfig());
+    // frame: BGR or BGRA (e.g. straight from captureDxFrame)
     std::vector<Detection> runInference(const cv::Mat& frame);
+    // Same, into caller-owned storage: no heap allocation per frame once `detections` has grown
+    // (mask classes aside, whose cv::Mats are per detection)
+    void runInference(const cv::Mat& frame, std::vector<Detection>& detections);
     bool isSessionValid() const { return valid; }
+    // What was actually loaded: differs from InferenceConfig::precision when the variant is missing
+    ModelPrecision precision() const { return loadedPrecision; }
+    const std::string& modelFile() const { return loadedPath; }
+
+    // Confidence / IoU thresholds etc.; class and mask counts are taken from the model
+    DecodeParams& decodeSettings() { return decodeParams; }
+
+    // Classes that get an instance mask (Detection::mask). Empty = no mask work at all.
+    void setMaskClasses(const std::vector<ObjectType>& classes) { maskClasses = classes; }
+    // Model class index -> ObjectType, for models trained on a subset of the classes (e.g. a fast
+    // White/Ball/Guideline detector). Empty = class index is the ObjectType, as for the main model.
+    void setClassTypes(const std::vector<ObjectType>& types) { classTypes = types; }
+
+    const InferenceTimings& lastTimings() const { return timings; }
+    const InferenceStartup& startupTimings() const { return startup; }
+
+    // Network input resolution in use (e.g. 640x640, or smaller for a table-ROI model). Decode and
+    // the mapping back to frame pixels follow it.
+    cv::Size inputSize() const { return active ? cv::Size(active->width, active->height) : cv::Size(); }
+    // Every loaded resolution, the model's own first
+    std::vector<cv::Size> inputSizes() const;
+    // Resolution for the following frames. A dynamic-shape model takes any multiple of 32 (a size
+    // not bound yet allocates its buffers once, here); fixed-shape models switch between the loaded
+    // exports. Returns false and changes nothing when the size is not available.
+    bool setInputSize(cv::Size size);
+    // Loaded resolution whose aspect ratio is closest to `frame`; the larger one on a tie
+    cv::Size closestInputSize(cv::Size frame) const;
+
+    // [1,3,H,W] tensor the last runInference fed the model (e.g. for INT8 calibration data)
+    const std::vector<float>& lastInput() const { return active->input; }
 
 private:
+    // One input resolution: the session that runs it (shared by all sizes of a dynamic-shape model)
+    // and its persistent input / output buffers, bound by name
+    struct Resolution {
+        Ort::Session* session = nullptr;
+        int width = 0;
+        int height = 0;
+        std::vector<float> input;                       // [1,3,H,W], bound as the input
+        Ort::Value inputTensor{ nullptr };
+        Ort::IoBinding binding{ nullptr };
+        std::vector<std::vector<float>> outputBuffers;  // One per output
+        std::vector<Ort::Value> outputTensors;          // Views of outputBuffers, bound as the outputs
+        std::vector<std::vector<int64_t>> outputShapes;
+        bool dynamicOutputs = false;                    // Shapes unknown until the first Run
+    };
+
+    void configureSession(const InferenceConfig& config);
+    std::unique_ptr<Ort::Session> createSession(const std::string& modelPath, const std::string& cachePath,
+                                                const InferenceConfig& config);
+    void addResolution(Ort::Session& session, int width, int height);
+    void addExport(const std::string& modelPath, cv::Size size, const InferenceConfig& config);
+    void warmUp(Resolution& resolution, int runs);
+    void runSession(Resolution& resolution);
+    void assembleMasks(const float* output, int numAnchors, int coeffChannel, Ort::Value& protoTensor,
+                       const std::vector<int64_t>& protoShape, std::vector<Detection>& detections);
+
     Ort::Env env;
-    std::unique_ptr<Ort::Session> session;
+    std::vector<std::unique_ptr<Ort::Session>> sessions; // Main model first, then other exports
     Ort::SessionOptions sessionOptions;
-    std::vector<const char*> inputNames;
-    std::vector<const char*> outputNames;
+    Ort::RunOptions runOptions;
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
     bool valid = false;
+    ModelPrecision loadedPrecision = ModelPrecision::Fp32;
+    std::string loadedPath;
     std::vector<std::string> inputNamesStr; // Stores input names as strings
     std::vector<std::string> outputNamesStr; // Stores output names as strings
-    const int inputWidth = 640;
-    const int inputHeight = 640;
+    bool dynamicInput = false;   // Input height / width are free: any resolution runs on sessions[0]
+    std::vector<std::unique_ptr<Resolution>> resolutions;
+    Resolution* active = nullptr;
+    FramePreprocessor preprocessor;
+    YoloDecoder decoder;
+    DecodeParams decodeParams;
+    std::vector<ObjectType> maskClasses;
+    std::vector<ObjectType> classTypes;
+    MaskAssembler maskAssembler;
+    std::vector<float> maskCoeffs;
+    InferenceTimings timings;
+    InferenceStartup startup;
 };
\ No newline at end of file
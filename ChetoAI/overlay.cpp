@@ -177,9 +177,29 @@ bool InitDirectX(HWND hwnd, int width, int height, OverlayData* pOverlayData) {
         return false;
     }
 
+    // Source-over, as the CPU rasterizer (cpu_raster.h) draws. Only overlapping shapes see it: the
+    // colour key below the swap chain makes any non-black result opaque (D3D11DrawBackend)
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    hr = pOverlayData->device->CreateBlendState(&blendDesc, &pOverlayData->blendState);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to create blend state!\n");
+        MessageBoxA(nullptr, "Failed to create blend state!", "DirectX Error", MB_OK);
+        return false;
+    }
+
     // --- Add Viewport Setup ---
     D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
     pOverlayData->deviceContext->RSSetViewports(1, &viewport);
+    pOverlayData->width = width;
+    pOverlayData->height = height;
     // --- End Viewport Setup ---
 
 
@@ -207,9 +227,6 @@ bool CompileShader(const char* source, const char* entryPoint, const char* targe
     return true; // Indicate success
 }
 
-// Keep ClearOverlay, PresentOverlay, DrawLine, DrawCircle, CleanupOverlay as they were,
-// but ensure the CreateBuffer checks added in the previous step are still there.
-
 void ClearOverlay(OverlayData* pOverlayData) {
     float clearColor[4] = { 0, 0, 0, 0 };
     pOverlayData->deviceContext->OMSetRenderTargets(1, &pOverlayData->renderTargetView, nullptr);
@@ -225,93 +242,57 @@ struct Vertex {
     float r, g, b, a;
 };
 
-void DrawLine(float x1, float y1, float x2, float y2, float color[4], OverlayData* pOverlayData) {
-    //OutputDebugStringA("Line drawing\n");
-    float screenWidth = (float)GetSystemMetrics(SM_CXSCREEN);
-    float screenHeight = (float)GetSystemMetrics(SM_CYSCREEN);
-
-    float sx1 = (x1 / screenWidth) * 2.0f - 1.0f;
-    float sy1 = 1.0f - (y1 / screenHeight) * 2.0f;
-    float sx2 = (x2 / screenWidth) * 2.0f - 1.0f;
-    float sy2 = 1.0f - (y2 / screenHeight) * 2.0f;
-
-    Vertex vertices[2] = {
-        { sx1, sy1, color[0], color[1], color[2], color[3] },
-        { sx2, sy2, color[0], color[1], color[2], color[3] }
-    };
-
-    pOverlayData->deviceContext->OMSetRenderTargets(1, &pOverlayData->renderTargetView, nullptr); // REQUIRED
-
-    D3D11_BUFFER_DESC bd = { sizeof(vertices), D3D11_USAGE_DYNAMIC, D3D11_BIND_VERTEX_BUFFER, D3D11_CPU_ACCESS_WRITE };
-    D3D11_SUBRESOURCE_DATA initData = { vertices, 0, 0 };
-    ID3D11Buffer* vertexBuffer;
-    HRESULT hr_buffer = pOverlayData->device->CreateBuffer(&bd, &initData, &vertexBuffer); // This line
-    if (FAILED(hr_buffer)) { // Add from here
-        // Log an error or show a message box here
-        OutputDebugStringA("Failed to create vertex buffer in DrawLine!\n");
-        // Depending on how you want to handle the error, you might want to return or do something else.
-        // For now, adding the log helps diagnose.
-        return; // Exit the function if buffer creation fails
-    } // To here
-    pOverlayData->device->CreateBuffer(&bd, &initData, &vertexBuffer);
-
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    pOverlayData->deviceContext->IASetInputLayout(pOverlayData->inputLayout);
-    pOverlayData->deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    pOverlayData->deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-    pOverlayData->deviceContext->VSSetShader(pOverlayData->vertexShader, nullptr, 0);
-    pOverlayData->deviceContext->PSSetShader(pOverlayData->pixelShader, nullptr, 0);
-    pOverlayData->deviceContext->Draw(2, 0);
-
-    vertexBuffer->Release();
-    OutputDebugStringA("Line drawing\n");
-}
-
-void DrawCircle(float cx, float cy, float radius, float color[4], OverlayData* pOverlayData) {
-    OutputDebugStringA("Circle drawing\n");
-    const int segments = 64;
-    std::vector<Vertex> vertices;
-
-    float screenWidth = (float)GetSystemMetrics(SM_CXSCREEN);
-    float screenHeight = (float)GetSystemMetrics(SM_CYSCREEN);
-
-    for (int i = 0; i <= segments; ++i) {
-        float theta = (float)i / segments * 2.0f * 3.14159265f;
-        float x = cx + radius * cosf(theta);
-        float y = cy + radius * sinf(theta);
-
-        float sx = (x / screenWidth) * 2.0f - 1.0f;
-        float sy = 1.0f - (y / screenHeight) * 2.0f;
-
-        vertices.push_back({ sx, sy, color[0], color[1], color[2], color[3] });
+void SubmitDrawList(const DrawList& list, OverlayData* pOverlayData) {
+    const std::vector<DrawVertex>& triangles = list.triangles();
+    if (triangles.empty()) return;
+    const UINT count = (UINT)triangles.size();
+
+    // Grow to the next power of two so a busier frame does not reallocate every time
+    if (count > pOverlayData->vertexCapacity) {
+        if (pOverlayData->vertexBuffer) pOverlayData->vertexBuffer->Release();
+        pOverlayData->vertexBuffer = nullptr;
+        pOverlayData->vertexCapacity = 0;
+        UINT capacity = 1024;
+        while (capacity < count) capacity *= 2;
+        D3D11_BUFFER_DESC bd = { capacity * (UINT)sizeof(Vertex), D3D11_USAGE_DYNAMIC, D3D11_BIND_VERTEX_BUFFER,
+                                 D3D11_CPU_ACCESS_WRITE };
+        if (FAILED(pOverlayData->device->CreateBuffer(&bd, nullptr, &pOverlayData->vertexBuffer))) {
+            OutputDebugStringA("Failed to create vertex buffer in SubmitDrawList!\n");
+            return;
+        }
+        pOverlayData->vertexCapacity = capacity;
     }
 
-    pOverlayData->deviceContext->OMSetRenderTargets(1, &pOverlayData->renderTargetView, nullptr); // REQUIRED
-
-    D3D11_BUFFER_DESC bd = { UINT(vertices.size() * sizeof(Vertex)), D3D11_USAGE_DYNAMIC, D3D11_BIND_VERTEX_BUFFER, D3D11_CPU_ACCESS_WRITE };
-    D3D11_SUBRESOURCE_DATA initData = { vertices.data(), 0, 0 };
-    ID3D11Buffer* vertexBuffer;
-    HRESULT hr_buffer = pOverlayData->device->CreateBuffer(&bd, &initData, &vertexBuffer); // This line
-    if (FAILED(hr_buffer)) { // Add from here
-        // Log an error or show a message box here
-        OutputDebugStringA("Failed to create vertex buffer in DrawCircle!\n");
-        // Depending on how you want to handle the error, you might want to return or do something else.
-        // For now, adding the log helps diagnose.
-        return; // Exit the function if buffer creation fails
-    } // To here
-    pOverlayData->device->CreateBuffer(&bd, &initData, &vertexBuffer);
+    // Overlay pixels -> clip space while copying into the mapped buffer
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(pOverlayData->deviceContext->Map(pOverlayData->vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        OutputDebugStringA("Failed to map vertex buffer in SubmitDrawList!\n");
+        return;
+    }
+    const float toClipX = 2.0f / (float)pOverlayData->width, toClipY = 2.0f / (float)pOverlayData->height;
+    Vertex* out = (Vertex*)mapped.pData;
+    for (const DrawVertex& v : triangles) {
+        *out++ = { v.x * toClipX - 1.0f, 1.0f - v.y * toClipY, v.color.r, v.color.g, v.color.b, v.color.a };
+    }
+    pOverlayData->deviceContext->Unmap(pOverlayData->vertexBuffer, 0);
 
     UINT stride = sizeof(Vertex);
     UINT offset = 0;
+    const float blendFactor[4] = { 0, 0, 0, 0 };
+    pOverlayData->deviceContext->OMSetRenderTargets(1, &pOverlayData->renderTargetView, nullptr);
+    pOverlayData->deviceContext->OMSetBlendState(pOverlayData->blendState, blendFactor, 0xffffffff);
     pOverlayData->deviceContext->IASetInputLayout(pOverlayData->inputLayout);
-    pOverlayData->deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    pOverlayData->deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
+    pOverlayData->deviceContext->IASetVertexBuffers(0, 1, &pOverlayData->vertexBuffer, &stride, &offset);
+    pOverlayData->deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     pOverlayData->deviceContext->VSSetShader(pOverlayData->vertexShader, nullptr, 0);
     pOverlayData->deviceContext->PSSetShader(pOverlayData->pixelShader, nullptr, 0);
-    pOverlayData->deviceContext->Draw((UINT)vertices.size(), 0);
+    pOverlayData->deviceContext->Draw(count, 0);
+}
 
-    vertexBuffer->Release();
+void D3D11DrawBackend::render(const DrawList& list) {
+    ClearOverlay(overlay);
+    SubmitDrawList(list, overlay);
+    PresentOverlay(overlay);
 }
 
 void CleanupOverlay(OverlayData* pOverlayData) {
@@ -319,6 +300,7 @@ void CleanupOverlay(OverlayData* pOverlayData) {
     if (pOverlayData->inputLayout) pOverlayData->inputLayout->Release();
     if (pOverlayData->vertexShader) pOverlayData->vertexShader->Release();
     if (pOverlayData->pixelShader) pOverlayData->pixelShader->Release();
+    if (pOverlayData->blendState) pOverlayData->blendState->Release();
     if (pOverlayData->renderTargetView) pOverlayData->renderTargetView->Release();
     if (pOverlayData->swapChain) pOverlayData->swapChain->Release();
     if (pOverlayData->deviceContext) pOverlayData->deviceContext->Release();
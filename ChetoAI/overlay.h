@@ -2,27 +2,45 @@
 
 #include <Windows.h>
 #include <d3d11.h>
+#include "draw_list.h"
 #include "physics.h" // Include for LineSegment struct
 
 // Structure to hold DirectX data
 struct OverlayData {
-    HWND hwnd;
-    ID3D11Device* device;
-    ID3D11DeviceContext* deviceContext;
-    IDXGISwapChain* swapChain;
-    ID3D11RenderTargetView* renderTargetView;
-    ID3D11InputLayout* inputLayout;
-    ID3D11VertexShader* vertexShader;
-    ID3D11PixelShader* pixelShader;
-    ID3D11Buffer* vertexBuffer;
+    HWND hwnd = nullptr;
+    ID3D11Device* device = nullptr;
+    ID3D11DeviceContext* deviceContext = nullptr;
+    IDXGISwapChain* swapChain = nullptr;
+    ID3D11RenderTargetView* renderTargetView = nullptr;
+    ID3D11InputLayout* inputLayout = nullptr;
+    ID3D11VertexShader* vertexShader = nullptr;
+    ID3D11PixelShader* pixelShader = nullptr;
+    ID3D11BlendState* blendState = nullptr;
+    ID3D11Buffer* vertexBuffer = nullptr;  // Dynamic, reused every frame; grows when a frame needs more
+    UINT vertexCapacity = 0;
+    int width = 0;
+    int height = 0;
 };
 
 // Function declarations
 HWND InitializeOverlay(HINSTANCE hInstance, OverlayData* pOverlayData);
-void DrawLine(float startX, float startY, float endX, float endY, float color[4], OverlayData* pOverlayData);
-void DrawCircle(float centerX, float centerY, float radius, float color[4], OverlayData* pOverlayData); // New
 void ClearOverlay(OverlayData* pOverlayData);
+// Whole list in one Map(WRITE_DISCARD) of the persistent vertex buffer and one Draw call
+void SubmitDrawList(const DrawList& list, OverlayData* pOverlayData);
 void PresentOverlay(OverlayData* pOverlayData);
 void CleanupOverlay(OverlayData* pOverlayData);
 bool InitDirectX(HWND hwnd, int width, int height, OverlayData* pOverlayData);
-bool CompileShader(const char* source, const char* entryPoint, const char* target, ID3DBlob** blob);
\ No newline at end of file
+bool CompileShader(const char* source, const char* entryPoint, const char* target, ID3DBlob** blob);
+
+// DrawBackend for the overlay window: clear, submit, present. The window is colour-keyed on black
+// (LWA_COLORKEY), not composited with per-pixel alpha: black pixels are see-through and every other
+// pixel is fully opaque on screen, so a translucent colour shows as a darker solid one. Draw with
+// opaque, non-black colours; see-through shapes need gaps (DrawList::hatchedCone)
+class D3D11DrawBackend : public DrawBackend {
+public:
+    explicit D3D11DrawBackend(OverlayData* overlay) : overlay(overlay) {}
+    void render(const DrawList& list) override;
+
+private:
+    OverlayData* overlay;
+};
@@ -1,9 +1,14 @@
 #include "physics.h"
+#include "ball_motion.h"
+#include "cushions.h"
+#include "shot_ensemble.h"
+#include <algorithm>
 #include <cmath>
 
 // Helper: Calculate distance between two points
-float Physics::distance(const cv::Point2f& p1, const cv::Point2f& p2) {
-    return static_cast<float>(std::sqrt(std::pow(p2.x - p1.x, 2) + std::pow(p2.y - p1.y, 2)));
+float Physics::distance(GuidePoint p1, GuidePoint p2) {
+    const float dx = p2.x - p1.x, dy = p2.y - p1.y;
+    return std::sqrt(dx * dx + dy * dy);
 }
 
 // Helper: Normalize a vector
@@ -19,99 +24,279 @@ cv::Point2f Physics::reflectVector(const cv::Point2f& incident, const cv::Point2
     return cv::Point2f(incident.x - 2 * dot * normal.x, incident.y - 2 * dot * normal.y);
 }
 
-// Helper: Check if a line intersects a rectangle (table bounds)
-bool Physics::lineIntersectsRect(const cv::Point2f& start, const cv::Point2f& end, const cv::Rect& rect, cv::Point2f& intersection) {
-    std::vector<cv::Point2f> sides[4] = {
-        { {cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y)), cv::Point2f(static_cast<float>(rect.x + rect.width), static_cast<float>(rect.y))} }, // Top
-        { {cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y + rect.height)), cv::Point2f(static_cast<float>(rect.x + rect.width), static_cast<float>(rect.y + rect.height))} }, // Bottom
-        { {cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y)), cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y + rect.height))} }, // Left
-        { {cv::Point2f(static_cast<float>(rect.x + rect.width), static_cast<float>(rect.y)), cv::Point2f(static_cast<float>(rect.x + rect.width), static_cast<float>(rect.y + rect.height))} }  // Right
+// Helper: Check if a line intersects a rectangle (table bounds). Sides are tested top, bottom,
+// left, right and the first crossing wins.
+bool Physics::lineIntersectsRect(GuidePoint start, GuidePoint end, const GuideTable& table, GuidePoint& intersection) {
+    if (!table.hasBounds) return false;
+    const GuideSegment sides[4] = {
+        { { table.minX, table.minY }, { table.maxX, table.minY } }, // Top
+        { { table.minX, table.maxY }, { table.maxX, table.maxY } }, // Bottom
+        { { table.minX, table.minY }, { table.minX, table.maxY } }, // Left
+        { { table.maxX, table.minY }, { table.maxX, table.maxY } }  // Right
     };
 
+    const float dx = end.x - start.x, dy = end.y - start.y;
     for (const auto& side : sides) {
-        float denom = (end.x - start.x) * (side[1].y - side[0].y) - (end.y - start.y) * (side[1].x - side[0].x);
+        const float sx = side.end.x - side.start.x, sy = side.end.y - side.start.y;
+        float denom = dx * sy - dy * sx;
         if (denom == 0) continue;
 
-        float t = ((start.y - side[0].y) * (side[1].x - side[0].x) - (start.x - side[0].x) * (side[1].y - side[0].y)) / denom;
-        float u = ((start.y - side[0].y) * (end.x - start.x) - (start.x - side[0].x) * (end.y - start.y)) / denom;
+        const float ox = start.x - side.start.x, oy = start.y - side.start.y;
+        float t = (oy * sx - ox * sy) / denom;
+        float u = (oy * dx - ox * dy) / denom;
 
         if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
-            intersection = cv::Point2f(start.x + t * (end.x - start.x), start.y + t * (end.y - start.y));
+            intersection = { start.x + t * dx, start.y + t * dy };
             return true;
         }
     }
     return false;
 }
 
+GuideBall toGuideBall(const Ball& ball) {
+    return { ball.center.x, ball.center.y, ball.radius };
+}
+
+GuideTable toGuideTable(const Table& table, const CushionTable* cushions) {
+    GuideTable out;
+    out.cushions = cushions && cushions->valid() ? cushions : nullptr;
+    out.hasBounds = !table.bounds.empty();
+    out.minX = static_cast<float>(table.bounds.x);
+    out.minY = static_cast<float>(table.bounds.y);
+    out.maxX = static_cast<float>(table.bounds.x + table.bounds.width);
+    out.maxY = static_cast<float>(table.bounds.y + table.bounds.height);
+    out.pocketCount = std::min(static_cast<int>(table.pockets.size()), simMaxPockets);
+    for (int i = 0; i < out.pocketCount; ++i) out.pockets[i] = { table.pockets[i].x, table.pockets[i].y };
+    return out;
+}
+
+namespace {
+
+// Vector form of a buffer, for the OpenCV-typed wrappers
+std::vector<LineSegment> toLineSegments(const GuideBuffer& buffer) {
+    std::vector<LineSegment> segments;
+    segments.reserve(buffer.count);
+    for (const GuideSegment& s : buffer)
+        segments.push_back({ cv::Point2f(s.start.x, s.start.y), cv::Point2f(s.end.x, s.end.y) });
+    return segments;
+}
+
+} // namespace
+
 // Compute ghost ball position (where cue ball should hit target ball)
 cv::Point2f Physics::computeGhostBall(const Ball& cue, const Ball& target) {
-    cv::Point2f direction = normalize(target.center - cue.center);
+    const GuidePoint ghost = computeGhostBall(toGuideBall(cue), toGuideBall(target));
+    return cv::Point2f(ghost.x, ghost.y);
+}
+
+GuidePoint Physics::computeGhostBall(const GuideBall& cue, const GuideBall& target) {
+    float dx = target.x - cue.x, dy = target.y - cue.y;
+    const float mag = std::sqrt(dx * dx + dy * dy);
+    if (mag > 0) {
+        dx /= mag;
+        dy /= mag;
+    }
     float combinedRadius = cue.radius + target.radius;
-    if (combinedRadius == 0) return target.center;
-    return target.center - direction * combinedRadius;
+    if (combinedRadius == 0) return { target.x, target.y };
+    return { target.x - dx * combinedRadius, target.y - dy * combinedRadius };
 }
 
 // Main function: Predict shot path and extend to boundary or pocket
 std::vector<LineSegment> calculateGuideline(const Ball& cueBall, const Ball& targetBall, const Table& table) {
-    std::vector<LineSegment> guideline;
+    GuideBuffer guideline;
+    calculateGuideline(toGuideBall(cueBall), toGuideBall(targetBall), toGuideTable(table), guideline);
+    return toLineSegments(guideline);
+}
 
-    // Compute the direction vector from the cue ball to the target ball
-    cv::Point2f direction = targetBall.center - cueBall.center;
-    cv::Point2f normalizedDirection = Physics::normalize(direction);
+void calculateGuideline(const GuideBall& cueBall, const GuideBall& targetBall, const GuideTable& table, GuideBuffer& out) {
+    out.clear();
+    const GuidePoint cue = { cueBall.x, cueBall.y };
+    const GuidePoint target = { targetBall.x, targetBall.y };
 
     // Extend the line from the cue ball to the target ball
-    LineSegment cueToTarget;
-    cueToTarget.start = cueBall.center;
-    cueToTarget.end = targetBall.center;
-    guideline.push_back(cueToTarget);
-
-    // Compute the ghost ball position
-    cv::Point2f ghostBall = Physics::computeGhostBall(cueBall, targetBall);
+    out.add(cue, target);
 
     // Extend the line from the target ball to the ghost ball
-    LineSegment targetToGhost;
-    targetToGhost.start = targetBall.center;
-    targetToGhost.end = ghostBall;
-    guideline.push_back(targetToGhost);
+    out.add(target, Physics::computeGhostBall(cueBall, targetBall));
 
     // Optionally, extend the line to the table boundary or pocket
-    for (const auto& pocket : table.pockets) {
-        LineSegment toPocket;
-        toPocket.start = targetBall.center;
-        toPocket.end = pocket;
-        guideline.push_back(toPocket);
-    }
-
-    return guideline;
+    for (int i = 0; i < table.pocketCount; ++i) out.add(target, table.pockets[i]);
 }
 
 std::vector<LineSegment> Physics::predictShotPath(const Ball& cue, const Ball& target, const Table& table) {
-    std::vector<LineSegment> segments;
+    GuideBuffer segments;
+    predictShotPath(toGuideBall(cue), toGuideBall(target), toGuideTable(table), segments);
+    return toLineSegments(segments);
+}
+
+void Physics::predictShotPath(const GuideBall& cue, const GuideBall& target, const GuideTable& table, GuideBuffer& out,
+                              int bounces) {
+    out.clear();
+    const GuidePoint targetCenter = { target.x, target.y };
 
     // Segment 1: Cue ball to ghost ball
-    cv::Point2f ghostBall = computeGhostBall(cue, target);
-    segments.push_back({ cue.center, ghostBall });
+    const GuidePoint ghostBall = computeGhostBall(cue, target);
+    out.add({ cue.x, cue.y }, ghostBall);
 
     // Segment 2: Target ball to pocket/boundary
-    cv::Point2f direction = normalize(target.center - ghostBall);
-    cv::Point2f extendedEnd = target.center + direction * 1000;
-    cv::Point2f intersection;
+    float dx = target.x - ghostBall.x, dy = target.y - ghostBall.y;
+    const float mag = std::sqrt(dx * dx + dy * dy);
+    if (mag > 0) {
+        dx /= mag;
+        dy /= mag;
+    }
+    GuidePoint extendedEnd = { target.x + dx * 1000, target.y + dy * 1000 };
+    GuidePoint intersection;
 
     bool pocketHit = false;
-    for (const auto& pocket : table.pockets) {
-        float dist = distance(target.center, pocket);
-        if (dist < 20.0f) {
-            extendedEnd = pocket;
+    for (int i = 0; i < table.pocketCount; ++i) {
+        if (distance(targetCenter, table.pockets[i]) < 20.0f) {
+            extendedEnd = table.pockets[i];
             pocketHit = true;
             break;
         }
     }
 
-    if (!pocketHit && lineIntersectsRect(target.center, extendedEnd, table.bounds, intersection)) {
+    // Polygonal cushions: follow the object ball through its bank shots
+    if (!pocketHit && table.cushions && mag > 0) {
+        BankPath bank;
+        table.cushions->trace(target.x, target.y, dx, dy, target.radius, bounces, 1000.0f * (bounces + 1), bank);
+        for (int k = 1; k < bank.pointCount; ++k) out.add({ bank.x[k - 1], bank.y[k - 1] }, { bank.x[k], bank.y[k] });
+        return;
+    }
+
+    if (!pocketHit && lineIntersectsRect(targetCenter, extendedEnd, table, intersection)) {
         extendedEnd = intersection;
     }
 
-    segments.push_back({ target.center, extendedEnd });
+    out.add(targetCenter, extendedEnd);
+}
 
-    return segments;
-}
\ No newline at end of file
+bool toSimTable(const Table& table, SimTable& out) {
+    return toSimTable(toGuideTable(table), out);
+}
+
+bool toSimTable(const GuideTable& table, SimTable& out) {
+    if (!table.hasBounds && !table.cushions) return false;
+    float pocketX[simMaxPockets], pocketY[simMaxPockets];
+    for (int i = 0; i < table.pocketCount; ++i) {
+        pocketX[i] = table.pockets[i].x;
+        pocketY[i] = table.pockets[i].y;
+    }
+    out = SimTable::rectangle(table.minX, table.minY, table.maxX, table.maxY, pocketX, pocketY, table.pocketCount);
+    if (table.cushions) {
+        out.cushionCount = std::min(table.cushions->size(), simMaxCushions);
+        for (int i = 0; i < out.cushionCount; ++i) {
+            const CushionEdge& e = table.cushions->edge(i);
+            out.cushions[i] = { e.x0, e.y0, e.x1, e.y1, e.nx, e.ny };
+        }
+    }
+    return true;
+}
+
+void toSimLayout(const Ball& cueBall, const Ball& targetBall, const std::vector<Ball>& others, SimState& out) {
+    out.count = 0;
+    out.add(cueBall.center.x, cueBall.center.y);
+    out.add(targetBall.center.x, targetBall.center.y);
+    for (const auto& ball : others) out.add(ball.center.x, ball.center.y);
+}
+
+std::vector<LineSegment> simulateShot(const Ball& cueBall, const Ball& targetBall, const std::vector<Ball>& others,
+                                      const Table& table, float speed, Simulator& simulator, SimResult& result,
+                                      const cv::Point2f* aimPoint) {
+    GuideBuffer segments;
+    SimState layout;
+    toSimLayout(cueBall, targetBall, others, layout);
+    const GuidePoint aim = aimPoint ? GuidePoint{ aimPoint->x, aimPoint->y }
+                                    : Physics::computeGhostBall(toGuideBall(cueBall), toGuideBall(targetBall));
+    if (!simulateShot(layout, cueBall.radius, toGuideTable(table), aim, speed, simulator, result, segments)) return {};
+    return toLineSegments(segments);
+}
+
+bool simulateShot(const SimState& layout, float ballRadius, const GuideTable& table, GuidePoint aimPoint, float speed,
+                  Simulator& simulator, SimResult& result, GuideBuffer& out) {
+    out.clear();
+    SimTable simTable;
+    if (layout.count == 0 || !toSimTable(table, simTable)) return false;
+    if (ballRadius > 0.0f) simulator.settings().ballRadius = ballRadius;
+
+    float ax = aimPoint.x - static_cast<float>(layout.x[0]), ay = aimPoint.y - static_cast<float>(layout.y[0]);
+    const float mag = std::sqrt(ax * ax + ay * ay);
+    if (mag > 0.0f) {
+        ax /= mag;
+        ay /= mag;
+    }
+    SimState state = layout;
+    state.vx[0] = ax * speed;
+    state.vy[0] = ay * speed;
+    state.status[0] = SimBallStatus::Moving;
+
+    simulator.run(state, simTable, result);
+
+    for (int i = 0; i < result.ballCount; ++i) {
+        const SimBallResult& ball = result.balls[i];
+        for (int k = 1; k < ball.pathCount; ++k)
+            out.add({ ball.path[k - 1].x, ball.path[k - 1].y }, { ball.path[k].x, ball.path[k].y });
+    }
+    return true;
+}
+
+std::vector<LineSegment> rankedShotGuideline(const Ball& cueBall, const Ball& targetBall, const RankedShot& shot,
+                                             const Table& table) {
+    GuideBuffer guideline;
+    rankedShotGuideline(toGuideBall(cueBall), toGuideBall(targetBall), shot, toGuideTable(table), guideline);
+    return toLineSegments(guideline);
+}
+
+void rankedShotGuideline(const GuideBall& cueBall, const GuideBall& targetBall, const RankedShot& shot,
+                         const GuideTable& table, GuideBuffer& out) {
+    out.clear();
+    out.add({ cueBall.x, cueBall.y }, { shot.ghostX, shot.ghostY });
+    if (shot.pocket >= 0 && shot.pocket < table.pocketCount)
+        out.add({ targetBall.x, targetBall.y }, table.pockets[shot.pocket]);
+}
+
+void uncertaintyConeGuideline(const GuideBall& targetBall, GuidePoint pocket, const ShotUncertainty& uncertainty,
+                              GuideBuffer& out) {
+    out.clear();
+    if (uncertainty.hitProbability <= 0.0f) return;
+    const float lx = pocket.x - targetBall.x, ly = pocket.y - targetBall.y;
+    for (float degrees : { uncertainty.coneLowDegrees, uncertainty.coneHighDegrees }) {
+        const float a = degrees * 0.017453292519943295f;
+        const float c = std::cos(a), s = std::sin(a);
+        out.add({ targetBall.x, targetBall.y }, { targetBall.x + lx * c - ly * s, targetBall.y + lx * s + ly * c });
+    }
+}
+
+bool cueBallTrajectory(const GuideBall& cueBall, GuidePoint aimPoint, float speed, float side, float follow,
+                       const GuideTable& table, const MotionParams& params, Trajectory& trajectory,
+                       GuideBuffer& out, float chord) {
+    out.clear();
+    SimTable simTable;
+    if (!toSimTable(table, simTable)) return false;
+    MotionParams ball = params;
+    if (cueBall.radius > 0.0f) ball.radius = cueBall.radius;
+    const BallState start = strikeBall(cueBall.x, cueBall.y, aimPoint.x - cueBall.x, aimPoint.y - cueBall.y, speed,
+        side, follow, ball.radius);
+    planTrajectory(start, simTable, ball, trajectory);
+
+    for (int i = 0; i < trajectory.count; ++i) {
+        const MotionSegment& segment = trajectory.segments[i];
+        if (segment.phase == MotionPhase::Stationary || segment.phase == MotionPhase::Spinning) continue;
+        // Rolling is straight; a sliding parabola is cut into chords by the distance it covers
+        int pieces = 1;
+        if (segment.phase == MotionPhase::Sliding && chord > 0.0f) {
+            const BallState end = stateAt(segment, segment.duration);
+            const double length = std::hypot(end.x - segment.start.x, end.y - segment.start.y);
+            pieces = std::max(1, std::min(16, static_cast<int>(length / chord)));
+        }
+        GuidePoint from{ static_cast<float>(segment.start.x), static_cast<float>(segment.start.y) };
+        for (int k = 1; k <= pieces; ++k) {
+            const BallState p = stateAt(segment, segment.duration * k / pieces);
+            const GuidePoint to{ static_cast<float>(p.x), static_cast<float>(p.y) };
+            out.add(from, to);
+            from = to;
+        }
+    }
+    return true;
+}
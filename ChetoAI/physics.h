@@ -2,6 +2,13 @@
 
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include "shot_ranking.h"
+#include "simulation.h"
+
+class CushionTable;
+struct MotionParams;
+struct ShotUncertainty;
+struct Trajectory;
 
 // Enum for ball types
 enum class BallType {
@@ -26,13 +33,60 @@ struct LineSegment {
     cv::Point2f end;
 };
 
+// Allocation-free geometry: plain floats in, caller-owned fixed-capacity buffers out. Convert the
+// OpenCV-typed Ball/Table once per frame with toGuideBall/toGuideTable and keep the GuideBuffers
+// across frames. The std::vector-returning functions below are thin wrappers over these.
+struct GuidePoint {
+    float x = 0.0f, y = 0.0f;
+};
+
+struct GuideBall {
+    float x = 0.0f, y = 0.0f;
+    float radius = 0.0f;
+};
+
+struct GuideTable {
+    bool hasBounds = false;
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+    int pocketCount = 0;             // Extra pockets beyond simMaxPockets are dropped
+    GuidePoint pockets[simMaxPockets];
+    const CushionTable* cushions = nullptr; // Polygonal cushions (cushions.h); replace the box when set
+};
+
+constexpr int guideMaxSegments = simMaxBalls * (simMaxPathPoints - 1); // Enough for a full rollout
+
+struct GuideSegment {
+    GuidePoint start, end;
+};
+
+struct GuideBuffer {
+    int count = 0;
+    bool overflow = false;           // A segment was dropped for lack of room
+    GuideSegment segments[guideMaxSegments];
+
+    void clear() { count = 0; overflow = false; }
+    void add(GuidePoint start, GuidePoint end) {
+        if (count < guideMaxSegments) segments[count++] = { start, end };
+        else overflow = true;
+    }
+    const GuideSegment* begin() const { return segments; }
+    const GuideSegment* end() const { return segments + count; }
+};
+
+GuideBall toGuideBall(const Ball& ball);
+GuideTable toGuideTable(const Table& table, const CushionTable* cushions = nullptr);
+
 class Physics {
 public:
     // Predict the shot path from cue to target, extending to boundary or pocket
     static std::vector<LineSegment> predictShotPath(const Ball& cue, const Ball& target, const Table& table);
+    // With table.cushions the object ball is traced off up to `bounces` cushions (bank shots)
+    static void predictShotPath(const GuideBall& cue, const GuideBall& target, const GuideTable& table, GuideBuffer& out,
+                                int bounces = 0);
 
     // Compute ghost ball position for visualization
     static cv::Point2f computeGhostBall(const Ball& cue, const Ball& target);
+    static GuidePoint computeGhostBall(const GuideBall& cue, const GuideBall& target);
 
     // Make normalize public to allow external access
     static cv::Point2f normalize(const cv::Point2f& vec);
@@ -40,9 +94,49 @@ public:
 private:
     // Helper functions adapted from repo
     static cv::Point2f reflectVector(const cv::Point2f& incident, const cv::Point2f& normal);
-    static bool lineIntersectsRect(const cv::Point2f& start, const cv::Point2f& end, const cv::Rect& rect, cv::Point2f& intersection);
-    static float distance(const cv::Point2f& p1, const cv::Point2f& p2);
+    static bool lineIntersectsRect(GuidePoint start, GuidePoint end, const GuideTable& table, GuidePoint& intersection);
+    static float distance(GuidePoint p1, GuidePoint p2);
 };
 
 // Declaration of calculateGuideline
 std::vector<LineSegment> calculateGuideline(const Ball& cueBall, const Ball& targetBall, const Table& table);
+void calculateGuideline(const GuideBall& cueBall, const GuideBall& targetBall, const GuideTable& table, GuideBuffer& out);
+
+// Table (overlay space) as simulator cushions + pockets: the polygonal cushions when set, else
+// the bounds rectangle; false with neither
+bool toSimTable(const Table& table, SimTable& out);
+bool toSimTable(const GuideTable& table, SimTable& out);
+
+// Resting layout for the simulator: cue ball first, then the target, then `others`
+void toSimLayout(const Ball& cueBall, const Ball& targetBall, const std::vector<Ball>& others, SimState& out);
+
+constexpr float simulatedShotSpeed = 1500.0f; // Overlay pixels/s, a medium-strength shot
+
+// Full-table rollout: the cue ball is struck toward `aimPoint` (default: the straight-on ghost ball
+// of `targetBall`) at `speed` (overlay pixels/s) and every ball in `others` takes part. Needs table.bounds.
+// Returns each ball's path that moved, as line segments; `result` keeps the details.
+std::vector<LineSegment> simulateShot(const Ball& cueBall, const Ball& targetBall, const std::vector<Ball>& others,
+                                      const Table& table, float speed, Simulator& simulator, SimResult& result,
+                                      const cv::Point2f* aimPoint = nullptr);
+// Same rollout from a prepared layout (cue ball first, see toSimLayout), aimed at `aimPoint`.
+// ballRadius <= 0 keeps the simulator's setting. False without table bounds.
+bool simulateShot(const SimState& layout, float ballRadius, const GuideTable& table, GuidePoint aimPoint, float speed,
+                  Simulator& simulator, SimResult& result, GuideBuffer& out);
+
+// Cue -> ghost ball -> object ball -> pocket for one ranked shot
+std::vector<LineSegment> rankedShotGuideline(const Ball& cueBall, const Ball& targetBall, const RankedShot& shot,
+                                             const Table& table);
+void rankedShotGuideline(const GuideBall& cueBall, const GuideBall& targetBall, const RankedShot& shot,
+                         const GuideTable& table, GuideBuffer& out);
+
+// Two lines from the object ball towards `pocket` bounding the ensemble's direction cone, each as
+// long as the object ball -> pocket leg. Nothing when the cone is empty (no sample hit).
+void uncertaintyConeGuideline(const GuideBall& targetBall, GuidePoint pocket, const ShotUncertainty& uncertainty,
+                              GuideBuffer& out);
+
+// Cue ball alone struck toward `aimPoint` at `speed` with tip offset `side` / `follow` (see strikeBall),
+// followed through slide, roll and cushion throw with the closed-form motion model. Sliding curves
+// come out as chords of about `chord` pixels. Other balls are ignored. False without a table.
+bool cueBallTrajectory(const GuideBall& cueBall, GuidePoint aimPoint, float speed, float side, float follow,
+                       const GuideTable& table, const MotionParams& params, Trajectory& trajectory,
+                       GuideBuffer& out, float chord = 20.0f);
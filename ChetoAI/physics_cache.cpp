@@ -0,0 +1,199 @@
+#include "physics_cache.h"
+#include "cushions.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Result kinds, hashed first so equal inputs to different functions never share a key
+enum KeyKind : uint32_t { GuidelineKey = 0, ShotPathKey, RolloutKey, EnsembleKey, SweepKey, KeyKindCount };
+
+uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// Exact bit pattern, for settings that must match rather than round
+uint64_t floatBits(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+StateKey::StateKey(float quantum, uint32_t kind, float* anchors)
+    : quantum(quantum), inverse(quantum > 0.0f ? 1.0f / quantum : 1.0f), h(fmix64(0x9e3779b97f4a7c15ULL + kind)),
+      anchors(anchors) {}
+
+StateKey& StateKey::add(float v) {
+    // Cell k covers [(k - 0.5) q, (k + 0.5) q)
+    double cell = std::floor(static_cast<double>(v) * inverse + 0.5);
+    if (anchors && slot < cacheAnchorSlots) {
+        float& held = anchors[slot++];
+        // Keep the held cell up to half a cell past its borders; also replaces the initial NaN
+        if (std::abs(static_cast<double>(v) * inverse - held) < 1.0) cell = held;
+        else held = static_cast<float>(cell);
+    }
+    // Non-finite or huge values (padding far away) hash as one bucket each
+    const uint64_t bits = std::abs(cell) < 9.0e18 ? static_cast<uint64_t>(static_cast<int64_t>(cell))
+                                                  : (cell > 0.0 ? 0x7ff0000000000000ULL : 0xfff0000000000000ULL);
+    return addExact(bits);
+}
+
+StateKey& StateKey::addExact(uint64_t v) {
+    h ^= fmix64(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return *this;
+}
+
+StateKey& StateKey::addBall(const GuideBall& ball) {
+    return add(ball.x).add(ball.y).add(ball.radius);
+}
+
+StateKey& StateKey::addTable(const GuideTable& table) {
+    addExact(table.hasBounds);
+    if (table.hasBounds) add(table.minX).add(table.minY).add(table.maxX).add(table.maxY);
+    addExact(static_cast<uint64_t>(table.pocketCount));
+    for (int p = 0; p < table.pocketCount; ++p) add(table.pockets[p].x).add(table.pockets[p].y);
+    const CushionTable* cushions = table.cushions && table.cushions->valid() ? table.cushions : nullptr;
+    addExact(cushions ? static_cast<uint64_t>(cushions->size()) : 0);
+    if (cushions)
+        for (int i = 0; i < cushions->size(); ++i) {
+            const CushionEdge& e = cushions->edge(i);
+            add(e.x0).add(e.y0).add(e.x1).add(e.y1);
+        }
+    return *this;
+}
+
+StateKey& StateKey::addTable(const SimTable& table) {
+    addExact(static_cast<uint64_t>(table.cushionCount));
+    for (int i = 0; i < table.cushionCount; ++i) {
+        const SimCushion& e = table.cushions[i];
+        add(e.x0).add(e.y0).add(e.x1).add(e.y1);
+    }
+    addExact(static_cast<uint64_t>(table.pocketCount));
+    for (int p = 0; p < table.pocketCount; ++p) add(table.pocketX[p]).add(table.pocketY[p]);
+    return *this;
+}
+
+StateKey& StateKey::addLayout(const SimState& layout) {
+    addExact(static_cast<uint64_t>(layout.count));
+    for (int i = 0; i < layout.count; ++i) {
+        add(static_cast<float>(layout.x[i])).add(static_cast<float>(layout.y[i]));
+        addExact(static_cast<uint64_t>(layout.status[i]));
+    }
+    return *this;
+}
+
+uint64_t StateKey::value() const {
+    return fmix64(h);
+}
+
+PhysicsCache::PhysicsCache(const PhysicsCacheConfig& config)
+    : config(config),
+      guides(config.guideEntries),
+      rollouts(config.rolloutEntries),
+      ensembles(config.ensembleEntries),
+      sweeps(config.sweepEntries),
+      anchors(static_cast<size_t>(KeyKindCount) * cacheAnchorSlots, std::nanf("")) {}
+
+const GuideBuffer& PhysicsCache::guideline(const GuideBall& cueBall, const GuideBall& targetBall,
+                                           const GuideTable& table) {
+    const uint64_t key = StateKey(config.quantum, GuidelineKey, anchorsFor(GuidelineKey))
+        .addBall(cueBall).addBall(targetBall).addTable(table).value();
+    const GuideBuffer* cached = guides.find(key);
+    hitLast = cached != nullptr;
+    if (cached) return *cached;
+    GuideBuffer& out = guides.insert(key);
+    calculateGuideline(cueBall, targetBall, table, out);
+    return out;
+}
+
+const GuideBuffer& PhysicsCache::shotPath(const GuideBall& cueBall, const GuideBall& targetBall,
+                                          const GuideTable& table, int bounces) {
+    const uint64_t key = StateKey(config.quantum, ShotPathKey, anchorsFor(ShotPathKey))
+        .addBall(cueBall).addBall(targetBall).addTable(table).addExact(static_cast<uint64_t>(bounces)).value();
+    const GuideBuffer* cached = guides.find(key);
+    hitLast = cached != nullptr;
+    if (cached) return *cached;
+    GuideBuffer& out = guides.insert(key);
+    Physics::predictShotPath(cueBall, targetBall, table, out, bounces);
+    return out;
+}
+
+const CachedRollout& PhysicsCache::rollout(const SimState& layout, float ballRadius, const GuideTable& table,
+                                           GuidePoint aimPoint, float speed, Simulator& simulator) {
+    const uint64_t key = StateKey(config.quantum, RolloutKey, anchorsFor(RolloutKey))
+        .addLayout(layout).add(ballRadius).addTable(table).add(aimPoint.x).add(aimPoint.y).add(speed).value();
+    const CachedRollout* cached = rollouts.find(key);
+    hitLast = cached != nullptr;
+    if (cached) return *cached;
+    CHETO_TRACE_SCOPE("rollout (cache miss)");
+    CachedRollout& out = rollouts.insert(key);
+    out.valid = simulateShot(layout, ballRadius, table, aimPoint, speed, simulator, out.result, out.path);
+    return out;
+}
+
+const ShotUncertainty& PhysicsCache::uncertainty(ShotEnsemble& ensemble, const EnsembleShot& shot) {
+    // The noise sigmas are keyed at a finer step: they are small and scale the whole ensemble
+    StateKey key(config.quantum, EnsembleKey, anchorsFor(EnsembleKey));
+    key.add(shot.cueX).add(shot.cueY).add(shot.cueRadius).add(shot.objectX).add(shot.objectY).add(shot.objectRadius);
+    key.add(shot.aimX).add(shot.aimY).add(shot.pocketX).add(shot.pocketY);
+    StateKey noise(config.quantum * 0.1f, EnsembleKey);
+    noise.add(shot.cueNoise.position).add(shot.cueNoise.radius).add(shot.objectNoise.position).add(shot.objectNoise.radius);
+    const uint64_t value = key.addExact(noise.value()).value();
+    const ShotUncertainty* cached = ensembles.find(value);
+    hitLast = cached != nullptr;
+    if (cached) return *cached;
+    ShotUncertainty& out = ensembles.insert(value);
+    ensemble.evaluate(shot, out);
+    return out;
+}
+
+const std::vector<SweepOutcome>& PhysicsCache::sweep(ShotSweeper& sweeper, const SimState& layout,
+                                                     const SimTable& table, const SweepConfig& sweepConfig) {
+    StateKey key(config.quantum, SweepKey, anchorsFor(SweepKey));
+    key.addLayout(layout).addTable(table);
+    key.addExact(floatBits(sweepConfig.startDegrees)).addExact(floatBits(sweepConfig.endDegrees));
+    key.addExact(floatBits(sweepConfig.stepDegrees)).addExact(static_cast<uint64_t>(sweepConfig.speedCount));
+    for (int s = 0; s < sweepConfig.speedCount && s < 4; ++s) key.addExact(floatBits(sweepConfig.speeds[s]));
+    const uint64_t value = key.value();
+    const std::vector<SweepOutcome>* cached = sweeps.find(value);
+    hitLast = cached != nullptr;
+    if (cached) return *cached;
+    std::vector<SweepOutcome>& out = sweeps.insert(value);
+    sweeper.sweep(layout, table, sweepConfig, out);
+    return out;
+}
+
+float* PhysicsCache::anchorsFor(int kind) {
+    return anchors.data() + static_cast<size_t>(kind) * cacheAnchorSlots;
+}
+
+void PhysicsCache::clear() {
+    guides.clear();
+    rollouts.clear();
+    ensembles.clear();
+    sweeps.clear();
+    std::fill(anchors.begin(), anchors.end(), std::nanf(""));
+}
+
+CacheStats PhysicsCache::totals() const {
+    CacheStats total;
+    for (const CacheStats* s : { &guides.stats(), &rollouts.stats(), &ensembles.stats(), &sweeps.stats() }) {
+        total.hits += s->hits;
+        total.misses += s->misses;
+        total.evictions += s->evictions;
+    }
+    return total;
+}
+
+size_t PhysicsCache::bytes() const {
+    return guides.bytes() + rollouts.bytes() + ensembles.bytes() + sweeps.bytes();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "physics.h"
+#include "shot_ensemble.h"
+#include "shot_sweep.h"
+
+// Memoizes per-frame physics on a quantized hash of its inputs. Every input is snapped to a fixed
+// grid of `quantum` overlay pixels, so the same position always lands in the same cell. Plain
+// rounding would flip the key whenever one of a few dozen jittering coordinates sits on a cell
+// border. So every input slot (the n-th value hashed for a result kind) remembers its last cell,
+// and keeps it while the input stays within half a quantum past that cell's borders. Detector
+// jitter below that reuses the previous answer exactly. Each result is keyed only on what it
+// depends on. The cue -> target guideline hashes the cue ball, the target and the table. The
+// rollout and the sweep hash every ball. A ball moving therefore misses just the entries that
+// include it. Entries from earlier layouts stay until the LRU evicts them. A ball that comes back
+// lands in its old cell again, so returning to a layout (e.g. switching target and back) is a hit,
+// unless the ball comes back within half a quantum of a cell border.
+//
+// Capacity is fixed per result kind and allocated up front: memory is
+// capacity x entry size and never grows. Keys do not cover Simulator /
+// ShotEnsemble / ShotSweeper settings; clear() after changing those.
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+constexpr int cacheAnchorSlots = 192;  // Per result kind; values past this get no hysteresis
+
+// 64-bit hash of quantized floats and exact ints, chained with add*(). With `anchors`, the n-th
+// add() keeps the cell held in anchors[n] (see above) while the value stays near it; pass the same
+// array for every key of one result kind.
+class StateKey {
+public:
+    StateKey(float quantum, uint32_t kind, float* anchors = nullptr);
+
+    StateKey& add(float v);          // Snapped to the quantum grid
+    StateKey& addExact(uint64_t v);
+    StateKey& addBall(const GuideBall& ball);
+    StateKey& addTable(const GuideTable& table);
+    StateKey& addTable(const SimTable& table);
+    StateKey& addLayout(const SimState& layout);
+
+    uint64_t value() const;
+
+private:
+    float quantum;
+    float inverse;
+    uint64_t h;
+    float* anchors;
+    int slot = 0;
+};
+
+// Fixed-capacity map from key to Value with least-recently-used eviction. A linear scan over the
+// keys is faster than hashing again at the capacities used here (tens of entries).
+template <typename Value>
+class ResultCache {
+public:
+    explicit ResultCache(int capacity)
+        : keys(capacity > 0 ? capacity : 1), stamps(keys.size()), values(keys.size()) {}
+
+    // Cached value for `key`, marked most recently used; nullptr (a miss) when absent
+    const Value* find(uint64_t key) {
+        for (int i = 0; i < used; ++i) {
+            if (keys[i] != key) continue;
+            stamps[i] = ++clock;
+            ++counters.hits;
+            return &values[i];
+        }
+        ++counters.misses;
+        return nullptr;
+    }
+
+    // Slot for `key` to be filled by the caller: a free one, else the least recently used
+    Value& insert(uint64_t key) {
+        int slot = used;
+        if (used < capacity()) {
+            ++used;
+        }
+        else {
+            slot = 0;
+            for (int i = 1; i < used; ++i)
+                if (stamps[i] < stamps[slot]) slot = i;
+            ++counters.evictions;
+        }
+        keys[slot] = key;
+        stamps[slot] = ++clock;
+        return values[slot];
+    }
+
+    void clear() { used = 0; }
+    int size() const { return used; }
+    int capacity() const { return static_cast<int>(keys.size()); }
+    size_t bytes() const { return keys.size() * (sizeof(uint64_t) * 2 + sizeof(Value)); }
+    const CacheStats& stats() const { return counters; }
+
+private:
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> stamps;
+    std::vector<Value> values;
+    int used = 0;
+    uint64_t clock = 0;
+    CacheStats counters;
+};
+
+struct PhysicsCacheConfig {
+    float quantum = 0.5f;            // Overlay pixels; grid cell size of the keys
+    int guideEntries = 16;           // Guidelines and shot paths
+    int rolloutEntries = 8;
+    int ensembleEntries = 32;
+    int sweepEntries = 2;            // Each holds a full angle table
+};
+
+struct CachedRollout {
+    bool valid = false;              // simulateShot succeeded
+    SimResult result;
+    GuideBuffer path;
+};
+
+class PhysicsCache {
+public:
+    explicit PhysicsCache(const PhysicsCacheConfig& config = PhysicsCacheConfig());
+
+    // Cached calculateGuideline / Physics::predictShotPath
+    const GuideBuffer& guideline(const GuideBall& cueBall, const GuideBall& targetBall, const GuideTable& table);
+    const GuideBuffer& shotPath(const GuideBall& cueBall, const GuideBall& targetBall, const GuideTable& table,
+                                int bounces);
+
+    // Cached simulateShot (layout form); check `valid`
+    const CachedRollout& rollout(const SimState& layout, float ballRadius, const GuideTable& table, GuidePoint aimPoint,
+                                 float speed, Simulator& simulator);
+
+    // Cached ShotEnsemble::evaluate; `microseconds` is that of the run that filled the entry
+    const ShotUncertainty& uncertainty(ShotEnsemble& ensemble, const EnsembleShot& shot);
+
+    // Cached ShotSweeper::sweep
+    const std::vector<SweepOutcome>& sweep(ShotSweeper& sweeper, const SimState& layout, const SimTable& table,
+                                           const SweepConfig& config);
+
+    bool lastHit() const { return hitLast; }
+    void clear();
+
+    const CacheStats& guideStats() const { return guides.stats(); }
+    const CacheStats& rolloutStats() const { return rollouts.stats(); }
+    const CacheStats& ensembleStats() const { return ensembles.stats(); }
+    const CacheStats& sweepStats() const { return sweeps.stats(); }
+    CacheStats totals() const;
+    size_t bytes() const;            // Fixed part; each cached sweep adds its angle table on the heap
+
+private:
+    float* anchorsFor(int kind);
+
+    PhysicsCacheConfig config;
+    ResultCache<GuideBuffer> guides;
+    ResultCache<CachedRollout> rollouts;
+    ResultCache<ShotUncertainty> ensembles;
+    ResultCache<std::vector<SweepOutcome>> sweeps;
+    bool hitLast = false;
+    std::vector<float> anchors;      // cacheAnchorSlots per key kind
+};
@@ -0,0 +1,220 @@
+#include "pipeline.h"
+#include <algorithm>
+#include "latency_stats.h"
+#include "trace.h"
+
+namespace {
+
+// Back off gently when a stage has nothing to do
+void idleWait(int& spins) {
+    if (++spins < 64) {
+        std::this_thread::yield();
+    }
+    else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+// Whole microseconds for the atomic counters
+uint64_t elapsedWholeUs(PipelineClock::time_point from, PipelineClock::time_point to) {
+    const double us = elapsedUs(from, to);
+    return us > 0.0 ? static_cast<uint64_t>(us) : 0;
+}
+
+} // namespace
+
+FramePipeline::FramePipeline(CaptureFn capture, InferenceFn inference, RenderFn render, PipelineConfig config)
+    : captureStage(std::move(capture)),
+      inferenceStage(std::move(inference)),
+      renderStage(std::move(render)),
+      config(config) {
+}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+void FramePipeline::start() {
+    if (captureThread.joinable()) return;
+    stopRequested = false;
+    captureDone = false;
+    inferenceDone = false;
+    renderDone = false;
+    captureThread = std::thread(&FramePipeline::captureLoop, this);
+    inferenceThread = std::thread(&FramePipeline::inferenceLoop, this);
+    renderThread = std::thread(&FramePipeline::renderLoop, this);
+}
+
+void FramePipeline::stop() {
+    stopRequested = true;
+    if (captureThread.joinable()) captureThread.join();
+    if (inferenceThread.joinable()) inferenceThread.join();
+    if (renderThread.joinable()) renderThread.join();
+}
+
+bool FramePipeline::finished() const {
+    return renderDone.load(std::memory_order_acquire);
+}
+
+PipelineStats FramePipeline::stats() const {
+    PipelineStats s;
+    s.captured = capturedCount.load();
+    s.inferred = inferredCount.load();
+    s.rendered = renderedCount.load();
+    s.displayTicks = displayTickCount.load();
+    s.droppedBeforeInference = droppedInference.load();
+    s.droppedBeforeRender = droppedRender.load();
+    s.lastLatencyUs = static_cast<double>(latencyLastUs.load());
+    s.maxLatencyUs = static_cast<double>(latencyMaxUs.load());
+    if (s.rendered > 0) s.meanLatencyUs = static_cast<double>(latencySumUs.load()) / s.rendered;
+    return s;
+}
+
+void FramePipeline::captureLoop() {
+    CHETO_TRACE_THREAD("capture");
+    uint64_t nextFrameId = 0;
+    int spins = 0;
+    FrameChanges droppedChanges; // Changes of frames that never made it into the queue
+    droppedChanges.known = true;
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        cv::Mat image;
+        FrameChanges changes;
+        FrameLease lease;
+        CHETO_TRACE_FRAME(nextFrameId);
+        CaptureStatus status;
+        {
+            CHETO_TRACE_SCOPE("capture");
+            status = captureStage(image, changes, lease);
+        }
+        if (status == CaptureStatus::EndOfStream) break;
+        if (status == CaptureStatus::NoFrame || image.empty()) {
+            idleWait(spins);
+            continue;
+        }
+        spins = 0;
+
+        FramePacket packet;
+        packet.frameId = nextFrameId++;
+        packet.captureTime = PipelineClock::now();
+        packet.image = std::move(image);
+        packet.lease = std::move(lease);
+        packet.changes = std::move(changes);
+        packet.changes.merge(droppedChanges);
+        capturedCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (config.dropStale) {
+            // Consumer drains to the newest frame, so a full queue means it is stalled
+            if (frameQueue.push(std::move(packet))) {
+                droppedChanges = FrameChanges();
+                droppedChanges.known = true;
+            }
+            else {
+                droppedChanges = std::move(packet.changes);
+                droppedInference.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            while (!frameQueue.push(std::move(packet)) && !stopRequested.load(std::memory_order_relaxed))
+                idleWait(spins);
+        }
+    }
+    captureDone.store(true, std::memory_order_release);
+}
+
+void FramePipeline::inferenceLoop() {
+    CHETO_TRACE_THREAD("inference");
+    int spins = 0;
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        FramePacket frame;
+        size_t dropped = 0;
+        bool got = false;
+        if (config.dropStale) {
+            // Skip to the newest frame, carrying the skipped frames' changes forward
+            FramePacket next;
+            while (frameQueue.pop(next)) {
+                if (got) {
+                    next.changes.merge(frame.changes);
+                    ++dropped;
+                }
+                frame = std::move(next);
+                got = true;
+            }
+        }
+        else {
+            got = frameQueue.pop(frame);
+        }
+        if (!got) {
+            if (captureDone.load(std::memory_order_acquire) && frameQueue.sizeApprox() == 0) break;
+            idleWait(spins);
+            continue;
+        }
+        spins = 0;
+        droppedInference.fetch_add(dropped, std::memory_order_relaxed);
+        CHETO_TRACE_FRAME(frame.frameId);
+
+        DetectionPacket packet;
+        packet.frameId = frame.frameId;
+        packet.captureTime = frame.captureTime;
+        packet.frameWidth = frame.image.cols;
+        packet.frameHeight = frame.image.rows;
+        inferenceStage(frame, packet);
+        packet.inferenceDoneTime = PipelineClock::now();
+        inferredCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (config.dropStale) {
+            if (!detectionQueue.push(std::move(packet))) droppedRender.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            while (!detectionQueue.push(std::move(packet)) && !stopRequested.load(std::memory_order_relaxed))
+                idleWait(spins);
+        }
+    }
+    inferenceDone.store(true, std::memory_order_release);
+}
+
+void FramePipeline::renderLoop() {
+    CHETO_TRACE_THREAD("render");
+    int spins = 0;
+    const bool ticking = displayTick && config.displayHz > 0.0;
+    const auto tickInterval = std::chrono::duration_cast<PipelineClock::duration>(
+        std::chrono::duration<double>(ticking ? 1.0 / config.displayHz : 0.0));
+    bool rendered = false;
+    PipelineClock::time_point nextTick;
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        DetectionPacket packet;
+        size_t dropped = 0;
+        bool got = config.dropStale ? detectionQueue.popLatest(packet, &dropped) : detectionQueue.pop(packet);
+        if (!got) {
+            if (inferenceDone.load(std::memory_order_acquire) && detectionQueue.sizeApprox() == 0) break;
+            const PipelineClock::time_point now = PipelineClock::now();
+            if (ticking && rendered && now >= nextTick) {
+                CHETO_TRACE_SCOPE("displayTick");
+                displayTick(now);
+                displayTickCount.fetch_add(1, std::memory_order_relaxed);
+                // Keep the cadence; a tick missed entirely is not made up for
+                nextTick += tickInterval;
+                if (nextTick <= now) nextTick = now + tickInterval;
+                spins = 0;
+                continue;
+            }
+            idleWait(spins);
+            continue;
+        }
+        spins = 0;
+        droppedRender.fetch_add(dropped, std::memory_order_relaxed);
+        CHETO_TRACE_FRAME(packet.frameId);
+
+        renderStage(packet);
+        rendered = true;
+        nextTick = PipelineClock::now() + tickInterval;
+
+        uint64_t latency = elapsedWholeUs(packet.captureTime, PipelineClock::now());
+        renderedCount.fetch_add(1, std::memory_order_relaxed);
+        latencySumUs.fetch_add(latency, std::memory_order_relaxed);
+        latencyLastUs.store(latency, std::memory_order_relaxed);
+        uint64_t prevMax = latencyMaxUs.load(std::memory_order_relaxed);
+        while (latency > prevMax && !latencyMaxUs.compare_exchange_weak(prevMax, latency)) {
+        }
+    }
+    renderDone.store(true, std::memory_order_release);
+}
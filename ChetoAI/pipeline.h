@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+#include "frame_source.h"
+#include "spsc_queue.h"
+
+using PipelineClock = std::chrono::steady_clock;
+
+// Pipeline timestamps as seconds (tracker / extrapolation time base)
+inline double pipelineSeconds(PipelineClock::time_point t) {
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+// Frames the pipeline can hold at once: a full capture queue, the one in inference and the one
+// being captured. A capture pool this size never runs dry because of the pipeline itself.
+constexpr int pipelineFrameQueueDepth = 8;
+constexpr int pipelineFramesInFlight = pipelineFrameQueueDepth + 2;
+
+// A captured frame travelling from the capture stage to inference
+struct FramePacket {
+    uint64_t frameId = 0;
+    PipelineClock::time_point captureTime;
+    cv::Mat image;        // May be a view into a pooled buffer, valid while `lease` is held
+    FrameLease lease;     // Released when the packet is dropped or inference is done with it
+    FrameChanges changes; // Accumulated over any frames dropped before this one
+};
+
+// Inference output travelling to the physics/render stage
+struct DetectionPacket {
+    uint64_t frameId = 0;
+    PipelineClock::time_point captureTime;
+    PipelineClock::time_point inferenceDoneTime;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    bool reused = false;  // Detections are unchanged from the previous packet
+    std::vector<Detection> detections;
+};
+
+struct PipelineConfig {
+    // true: each stage takes the newest item and drops older ones (live use).
+    // false: every frame is processed in order, producers wait (replay/benchmarks).
+    bool dropStale = true;
+    // > 0: while no new detections arrive, the display tick (setDisplayTick) runs at this rate, so
+    // the overlay follows the extrapolated balls at display refresh instead of at inference rate
+    double displayHz = 0.0;
+};
+
+// Counters are cumulative since start(); latencies in microseconds.
+struct PipelineStats {
+    uint64_t captured = 0;
+    uint64_t inferred = 0;
+    uint64_t rendered = 0;
+    uint64_t displayTicks = 0;  // Render-thread redraws between detection packets
+    uint64_t droppedBeforeInference = 0;
+    uint64_t droppedBeforeRender = 0;
+    double lastLatencyUs = 0.0; // Capture -> render done
+    double meanLatencyUs = 0.0;
+    double maxLatencyUs = 0.0;
+};
+
+// Capture -> inference -> physics/render, one thread per stage, connected by
+// SPSC queues. Platform-neutral: stages are plain callbacks, so the same core
+// runs with DXGI capture + D3D overlay or headless from a file-backed source.
+class FramePipeline {
+public:
+    // `lease` stays empty when `image` owns its pixels (see FrameSource::lastLease)
+    using CaptureFn = std::function<CaptureStatus(cv::Mat& image, FrameChanges& changes, FrameLease& lease)>;
+    // Fills result.detections (and result.reused); frame metadata is already set
+    using InferenceFn = std::function<void(const FramePacket& frame, DetectionPacket& result)>;
+    using RenderFn = std::function<void(const DetectionPacket& packet)>;
+    // Redraw on the render thread with no new packet; `now` is the tick time
+    using DisplayFn = std::function<void(PipelineClock::time_point now)>;
+
+    FramePipeline(CaptureFn capture, InferenceFn inference, RenderFn render, PipelineConfig config = {});
+    ~FramePipeline();
+
+    // Set before start(); only called with PipelineConfig::displayHz > 0, after the first packet
+    void setDisplayTick(DisplayFn tick) { displayTick = std::move(tick); }
+
+    void start();
+    void stop();               // Requests stop and joins all stage threads
+    bool finished() const;     // True once an EndOfStream has drained through every stage
+    PipelineStats stats() const;
+
+private:
+    void captureLoop();
+    void inferenceLoop();
+    void renderLoop();
+
+    CaptureFn captureStage;
+    InferenceFn inferenceStage;
+    RenderFn renderStage;
+    DisplayFn displayTick;
+    PipelineConfig config;
+
+    SpscQueue<FramePacket, pipelineFrameQueueDepth> frameQueue;
+    SpscQueue<DetectionPacket, 8> detectionQueue;
+
+    std::atomic<bool> stopRequested{ false };
+    std::atomic<bool> captureDone{ false };
+    std::atomic<bool> inferenceDone{ false };
+    std::atomic<bool> renderDone{ false };
+    std::thread captureThread;
+    std::thread inferenceThread;
+    std::thread renderThread;
+
+    std::atomic<uint64_t> capturedCount{ 0 };
+    std::atomic<uint64_t> inferredCount{ 0 };
+    std::atomic<uint64_t> renderedCount{ 0 };
+    std::atomic<uint64_t> displayTickCount{ 0 };
+    std::atomic<uint64_t> droppedInference{ 0 };
+    std::atomic<uint64_t> droppedRender{ 0 };
+    std::atomic<uint64_t> latencySumUs{ 0 };
+    std::atomic<uint64_t> latencyMaxUs{ 0 };
+    std::atomic<uint64_t> latencyLastUs{ 0 };
+};
@@ -0,0 +1,246 @@
+#include "preprocess.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct RowTables {
+    const int* offset0;
+    const int* offset1;
+    const float* weight0;
+    const float* weight1;
+    int width;       // Destination columns
+    int safeColumns; // Prefix of columns that may use 4-byte loads
+};
+
+// Output plane order is RGB, source byte order is BGR(A)
+void resampleRowScalar(const unsigned char* src, const RowTables& t, int start, float* out) {
+    float* r = out;
+    float* g = out + t.width;
+    float* b = out + 2 * t.width;
+    for (int x = start; x < t.width; ++x) {
+        const unsigned char* p0 = src + t.offset0[x];
+        const unsigned char* p1 = src + t.offset1[x];
+        const float w0 = t.weight0[x];
+        const float w1 = t.weight1[x];
+        b[x] = p0[0] * w0 + p1[0] * w1;
+        g[x] = p0[1] * w0 + p1[1] * w1;
+        r[x] = p0[2] * w0 + p1[2] * w1;
+    }
+}
+
+void blendRowsScalar(const float* row0, const float* row1, float w, float* dst, int n, int start) {
+    for (int x = start; x < n; ++x)
+        dst[x] = row0[x] + w * (row1[x] - row0[x]);
+}
+
+#if defined(CHETO_SIMD_X86)
+inline __m128 loadPixelSSE(const unsigned char* p) {
+    int packed;
+    std::memcpy(&packed, p, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_cvtsi32_si128(packed);
+    v = _mm_unpacklo_epi8(v, zero);
+    v = _mm_unpacklo_epi16(v, zero);
+    return _mm_cvtepi32_ps(v);
+}
+
+void resampleRowSSE(const unsigned char* src, const RowTables& t, float* out) {
+    float* r = out;
+    float* g = out + t.width;
+    float* b = out + 2 * t.width;
+    alignas(16) float px[4];
+    for (int x = 0; x < t.safeColumns; ++x) {
+        __m128 p0 = loadPixelSSE(src + t.offset0[x]);
+        __m128 p1 = loadPixelSSE(src + t.offset1[x]);
+        __m128 v = _mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(t.weight0[x])),
+                              _mm_mul_ps(p1, _mm_set1_ps(t.weight1[x])));
+        _mm_store_ps(px, v);
+        b[x] = px[0];
+        g[x] = px[1];
+        r[x] = px[2];
+    }
+    resampleRowScalar(src, t, t.safeColumns, out);
+}
+
+void blendRowsSSE(const float* row0, const float* row1, float w, float* dst, int n) {
+    const __m128 vw = _mm_set1_ps(w);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        __m128 a = _mm_loadu_ps(row0 + x);
+        __m128 b = _mm_loadu_ps(row1 + x);
+        _mm_storeu_ps(dst + x, _mm_add_ps(a, _mm_mul_ps(vw, _mm_sub_ps(b, a))));
+    }
+    blendRowsScalar(row0, row1, w, dst, n, x);
+}
+
+CHETO_TARGET_AVX2 void resampleRowAVX2(const unsigned char* src, const RowTables& t, float* out) {
+    float* r = out;
+    float* g = out + t.width;
+    float* b = out + 2 * t.width;
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const int* base = reinterpret_cast<const int*>(src);
+    int x = 0;
+    for (; x + 8 <= t.safeColumns; x += 8) {
+        __m256i o0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t.offset0 + x));
+        __m256i o1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t.offset1 + x));
+        __m256i p0 = _mm256_i32gather_epi32(base, o0, 1);
+        __m256i p1 = _mm256_i32gather_epi32(base, o1, 1);
+        __m256 w0 = _mm256_loadu_ps(t.weight0 + x);
+        __m256 w1 = _mm256_loadu_ps(t.weight1 + x);
+
+        __m256 b0 = _mm256_cvtepi32_ps(_mm256_and_si256(p0, byteMask));
+        __m256 g0 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p0, 8), byteMask));
+        __m256 r0 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p0, 16), byteMask));
+        __m256 b1 = _mm256_cvtepi32_ps(_mm256_and_si256(p1, byteMask));
+        __m256 g1 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p1, 8), byteMask));
+        __m256 r1 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p1, 16), byteMask));
+
+        _mm256_storeu_ps(b + x, _mm256_fmadd_ps(b1, w1, _mm256_mul_ps(b0, w0)));
+        _mm256_storeu_ps(g + x, _mm256_fmadd_ps(g1, w1, _mm256_mul_ps(g0, w0)));
+        _mm256_storeu_ps(r + x, _mm256_fmadd_ps(r1, w1, _mm256_mul_ps(r0, w0)));
+    }
+    resampleRowScalar(src, t, x, out);
+}
+
+CHETO_TARGET_AVX2 void blendRowsAVX2(const float* row0, const float* row1, float w, float* dst, int n) {
+    const __m256 vw = _mm256_set1_ps(w);
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m256 a = _mm256_loadu_ps(row0 + x);
+        __m256 b = _mm256_loadu_ps(row1 + x);
+        _mm256_storeu_ps(dst + x, _mm256_fmadd_ps(vw, _mm256_sub_ps(b, a), a));
+    }
+    blendRowsScalar(row0, row1, w, dst, n, x);
+}
+#endif
+
+// Pixel-center aligned source coordinate, same convention as cv::resize(INTER_LINEAR)
+void sampleAxis(int dst, int srcSize, double scale, int& i0, int& i1, float& frac) {
+    double f = (dst + 0.5) * scale - 0.5;
+    int i = static_cast<int>(std::floor(f));
+    float w = static_cast<float>(f - i);
+    if (i < 0) {
+        i = 0;
+        w = 0.0f;
+    }
+    if (i >= srcSize - 1) {
+        i = srcSize - 1;
+        w = 0.0f;
+    }
+    i0 = i;
+    i1 = std::min(i + 1, srcSize - 1);
+    frac = w;
+}
+
+} // namespace
+
+void FramePreprocessor::buildTables(int srcWidth, int srcHeight, int channels, int dstWidth, int dstHeight) {
+    const double scaleX = static_cast<double>(srcWidth) / dstWidth;
+    const double scaleY = static_cast<double>(srcHeight) / dstHeight;
+    const float inv255 = 1.0f / 255.0f;
+
+    xOffset0.resize(dstWidth);
+    xOffset1.resize(dstWidth);
+    xWeight0.resize(dstWidth);
+    xWeight1.resize(dstWidth);
+    const int rowBytes = srcWidth * channels;
+    gatherSafeColumns = 0;
+    for (int x = 0; x < dstWidth; ++x) {
+        int i0, i1;
+        float w;
+        sampleAxis(x, srcWidth, scaleX, i0, i1, w);
+        xOffset0[x] = i0 * channels;
+        xOffset1[x] = i1 * channels;
+        xWeight0[x] = (1.0f - w) * inv255;
+        xWeight1[x] = w * inv255;
+        // BGR pixels are read as 4 bytes; the last pixel would read past the row
+        if (xOffset1[x] + 4 <= rowBytes) gatherSafeColumns = x + 1;
+    }
+
+    yIndex0.resize(dstHeight);
+    yIndex1.resize(dstHeight);
+    yWeight.resize(dstHeight);
+    for (int y = 0; y < dstHeight; ++y)
+        sampleAxis(y, srcHeight, scaleY, yIndex0[y], yIndex1[y], yWeight[y]);
+
+    rowCache[0].assign(static_cast<size_t>(dstWidth) * 3, 0.0f);
+    rowCache[1].assign(static_cast<size_t>(dstWidth) * 3, 0.0f);
+
+    cachedSrcWidth = srcWidth;
+    cachedSrcHeight = srcHeight;
+    cachedChannels = channels;
+    cachedDstWidth = dstWidth;
+    cachedDstHeight = dstHeight;
+}
+
+void FramePreprocessor::resampleRow(const unsigned char* srcRow, float* out) const {
+    RowTables t = { xOffset0.data(), xOffset1.data(), xWeight0.data(), xWeight1.data(),
+                    cachedDstWidth, gatherSafeColumns };
+#if defined(CHETO_SIMD_X86)
+    switch (activeSimdLevel()) {
+    case SimdLevel::AVX2:
+        resampleRowAVX2(srcRow, t, out);
+        return;
+    case SimdLevel::SSE:
+        resampleRowSSE(srcRow, t, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    resampleRowScalar(srcRow, t, 0, out);
+}
+
+bool FramePreprocessor::run(const cv::Mat& frame, float* dst, int dstWidth, int dstHeight) {
+    if (frame.empty() || frame.depth() != CV_8U || dstWidth <= 0 || dstHeight <= 0) return false;
+    const int channels = frame.channels();
+    if (channels != 3 && channels != 4) return false;
+
+    if (frame.cols != cachedSrcWidth || frame.rows != cachedSrcHeight || channels != cachedChannels ||
+        dstWidth != cachedDstWidth || dstHeight != cachedDstHeight) {
+        buildTables(frame.cols, frame.rows, channels, dstWidth, dstHeight);
+    }
+
+    const SimdLevel level = activeSimdLevel();
+    const size_t planeSize = static_cast<size_t>(dstWidth) * dstHeight;
+    int cachedRow[2] = { -1, -1 };
+
+    // Returns the cache slot holding source row `row`, resampling it if needed
+    auto fetchRow = [&](int row, int keepSlot) -> int {
+        if (cachedRow[0] == row) return 0;
+        if (cachedRow[1] == row) return 1;
+        int slot = (keepSlot == 0) ? 1 : 0;
+        resampleRow(frame.ptr<unsigned char>(row), rowCache[slot].data());
+        cachedRow[slot] = row;
+        return slot;
+    };
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const int y1Slot = (cachedRow[0] == yIndex1[y]) ? 0 : (cachedRow[1] == yIndex1[y]) ? 1 : -1;
+        int s0 = fetchRow(yIndex0[y], y1Slot);
+        int s1 = fetchRow(yIndex1[y], s0);
+        const float w = yWeight[y];
+
+        for (int c = 0; c < 3; ++c) {
+            const float* row0 = rowCache[s0].data() + c * dstWidth;
+            const float* row1 = rowCache[s1].data() + c * dstWidth;
+            float* out = dst + c * planeSize + static_cast<size_t>(y) * dstWidth;
+#if defined(CHETO_SIMD_X86)
+            if (level == SimdLevel::AVX2) {
+                blendRowsAVX2(row0, row1, w, out, dstWidth);
+                continue;
+            }
+            if (level == SimdLevel::SSE) {
+                blendRowsSSE(row0, row1, w, out, dstWidth);
+                continue;
+            }
+#endif
+            blendRowsScalar(row0, row1, w, out, dstWidth, 0);
+        }
+    }
+    (void)level;
+    return true;
+}
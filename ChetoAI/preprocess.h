@@ -0,0 +1,40 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Fused resize + BGR(A)->RGB + 1/255 scale + HWC->CHW conversion.
+// Replaces the resize/cvtColor/convertTo/transpose chain with a single pass that
+// writes directly into a caller-owned [1, 3, dstHeight, dstWidth] float tensor.
+// Sampling matches cv::resize(INTER_LINEAR) (pixel-center aligned bilinear).
+class FramePreprocessor {
+public:
+    // frame: CV_8UC3 (BGR) or CV_8UC4 (BGRA); ROI views are fine.
+    // dst: at least 3 * dstWidth * dstHeight floats.
+    bool run(const cv::Mat& frame, float* dst, int dstWidth, int dstHeight);
+
+private:
+    void buildTables(int srcWidth, int srcHeight, int channels, int dstWidth, int dstHeight);
+    void resampleRow(const unsigned char* srcRow, float* out) const;
+
+    // Horizontal sampling table (one entry per destination column)
+    std::vector<int> xOffset0;   // Byte offset of the left sample
+    std::vector<int> xOffset1;   // Byte offset of the right sample
+    std::vector<float> xWeight0; // Left weight, pre-multiplied by 1/255
+    std::vector<float> xWeight1; // Right weight, pre-multiplied by 1/255
+    int gatherSafeColumns = 0;   // Columns whose 4-byte loads stay inside the source row
+
+    // Vertical sampling table (one entry per destination row)
+    std::vector<int> yIndex0;
+    std::vector<int> yIndex1;
+    std::vector<float> yWeight;
+
+    // Two horizontally resampled source rows, planar RGB
+    std::vector<float> rowCache[2];
+
+    int cachedSrcWidth = 0;
+    int cachedSrcHeight = 0;
+    int cachedChannels = 0;
+    int cachedDstWidth = 0;
+    int cachedDstHeight = 0;
+};
@@ -0,0 +1,180 @@
+#include "scene.h"
+#include "debug_log.h"
+#include "Enums.h"
+#include <algorithm>
+
+// Convert YOLO detections to Ball and Table structs
+void processDetections(const std::vector<Detection>& detections, Ball& cueBall, Ball& targetBall, Table& table, int screenWidth, int screenHeight) {
+    table.pockets.clear();
+    bool cueFound = false, targetFound = false;
+
+    for (const auto& det : detections) {
+        cv::Point2f center(det.box.x + det.box.width / 2.0f, det.box.y + det.box.height / 2.0f);
+        float radius = std::min(det.box.width, det.box.height) / 2.0f;
+
+        // Scale coordinates to overlay resolution
+        center.x = (center.x / screenWidth) * 1920.0f;
+        center.y = (center.y / screenHeight) * 1080.0f;
+        radius = (radius / screenWidth) * 1920.0f;
+
+        switch (static_cast<ObjectType>(det.class_id)) {
+        case ObjectType::White:
+            cueBall = { center, radius, BallType::Cue };
+            cueFound = true;
+            break;
+        case ObjectType::Ball:
+            if (!targetFound) {
+                targetBall = { center, radius, BallType::Target };
+                targetFound = true;
+            }
+            break;
+        case ObjectType::Hole:
+            table.pockets.push_back(center);
+            break;
+        case ObjectType::PlayArea:
+            table.bounds = cv::Rect(
+                static_cast<int>((det.box.x / static_cast<float>(screenWidth)) * 1920.0f),
+                static_cast<int>((det.box.y / static_cast<float>(screenHeight)) * 1080.0f),
+                static_cast<int>((det.box.width / static_cast<float>(screenWidth)) * 1920.0f),
+                static_cast<int>((det.box.height / static_cast<float>(screenHeight)) * 1080.0f)
+            );
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Optional debug
+    if (!cueFound || !targetFound || table.pockets.empty()) {
+        debugLog("Warning: Missing cue/target ball or pockets.\n");
+    }
+}
+
+void processTrackedScene(const std::vector<Detection>& detections, const std::vector<TrackedBall>& balls, int& targetId,
+                         Ball& cueBall, Ball& targetBall, Table& table, int screenWidth, int screenHeight,
+                         std::vector<Ball>* others, ShotRanking* ranking, const ShotRankingConfig& rankingConfig) {
+    // Pockets and play area still come straight from the detections. `table` may be reused across
+    // frames (keeps the pocket vector's capacity), so reset it here
+    table.pockets.clear();
+    table.bounds = cv::Rect();
+    for (const auto& det : detections) {
+        if (det.type == ObjectType::Hole) {
+            cv::Point2f center(det.box.x + det.box.width / 2.0f, det.box.y + det.box.height / 2.0f);
+            table.pockets.push_back(cv::Point2f((center.x / screenWidth) * 1920.0f, (center.y / screenHeight) * 1080.0f));
+        }
+        else if (det.type == ObjectType::PlayArea) {
+            table.bounds = cv::Rect(
+                static_cast<int>((det.box.x / static_cast<float>(screenWidth)) * 1920.0f),
+                static_cast<int>((det.box.y / static_cast<float>(screenHeight)) * 1080.0f),
+                static_cast<int>((det.box.width / static_cast<float>(screenWidth)) * 1920.0f),
+                static_cast<int>((det.box.height / static_cast<float>(screenHeight)) * 1080.0f));
+        }
+    }
+
+    auto toOverlay = [screenWidth, screenHeight](const TrackedBall& b, BallType type) {
+        cv::Point2f center((b.center.x / screenWidth) * 1920.0f, (b.center.y / screenHeight) * 1080.0f);
+        return Ball{ center, (b.radius / screenWidth) * 1920.0f, type };
+    };
+
+    const TrackedBall* cue = nullptr;
+    for (const auto& b : balls)
+        if (b.type == ObjectType::White && (!cue || b.hits > cue->hits)) cue = &b;
+
+    const TrackedBall* target = nullptr;
+    if (ranking) {
+        ranking->count = 0;
+        if (cue) {
+            const Ball cueOverlay = toOverlay(*cue, BallType::Cue);
+            ShotQuery query;
+            query.cueX = cueOverlay.center.x;
+            query.cueY = cueOverlay.center.y;
+            query.radius = cueOverlay.radius;
+            for (const auto& b : balls) {
+                if (b.type != ObjectType::Ball) continue;
+                const Ball ball = toOverlay(b, BallType::Other);
+                query.addBall(ball.center.x, ball.center.y, b.id);
+            }
+            for (const auto& pocket : table.pockets) query.addPocket(pocket.x, pocket.y);
+            rankShots(query, rankingConfig, *ranking);
+        }
+        // Stay on the current target while it still has a shot, so the guideline does not flicker
+        const RankedShot* shot = ranking->findBall(targetId);
+        if (!shot && ranking->count > 0) shot = &ranking->shots[0];
+        if (shot)
+            for (const auto& b : balls)
+                if (b.id == shot->ballId) target = &b;
+    }
+
+    // Keep the current target while it is tracked; otherwise take the ball closest to the cue
+    if (!target)
+        for (const auto& b : balls)
+            if (b.id == targetId && b.type == ObjectType::Ball) target = &b;
+    if (!target && cue) {
+        float best = 0.0f;
+        for (const auto& b : balls) {
+            if (b.type != ObjectType::Ball) continue;
+            cv::Point2f d = b.center - cue->center;
+            float d2 = d.dot(d);
+            if (!target || d2 < best) {
+                best = d2;
+                target = &b;
+            }
+        }
+    }
+    targetId = target ? target->id : -1;
+
+    if (cue) cueBall = toOverlay(*cue, BallType::Cue);
+    if (target) targetBall = toOverlay(*target, BallType::Target);
+
+    if (others) {
+        others->clear();
+        for (const auto& b : balls)
+            if (&b != cue && &b != target) others->push_back(toOverlay(b, BallType::Other));
+    }
+}
+
+BallNoise ballNoise(const std::vector<Detection>& detections, const Ball& ball, int screenWidth, int screenHeight,
+                    const EnsembleConfig& config) {
+    const float scale = 1920.0f / screenWidth;
+    const ObjectType kind = ball.type == BallType::Cue ? ObjectType::White : ObjectType::Ball;
+    const Detection* nearest = nullptr;
+    float best = ball.radius * ball.radius;
+    for (const auto& det : detections) {
+        if (det.type != kind) continue;
+        cv::Point2f center(det.box.x + det.box.width / 2.0f, det.box.y + det.box.height / 2.0f);
+        center.x = (center.x / screenWidth) * 1920.0f;
+        center.y = (center.y / screenHeight) * 1080.0f;
+        const cv::Point2f d = center - ball.center;
+        if (d.dot(d) <= best) {
+            best = d.dot(d);
+            nearest = &det;
+        }
+    }
+    if (!nearest) {
+        const float side = 2.0f * ball.radius / scale;
+        return detectionNoise(side, side, 0.0f, scale, config);
+    }
+    return detectionNoise(static_cast<float>(nearest->box.width), static_cast<float>(nearest->box.height),
+        nearest->confidence, scale, config);
+}
+
+EnsembleShot toEnsembleShot(const std::vector<Detection>& detections, const Ball& cueBall, const Ball& targetBall,
+                            const RankedShot& shot, const Table& table, int screenWidth, int screenHeight,
+                            const EnsembleConfig& config) {
+    EnsembleShot e;
+    e.cueX = cueBall.center.x;
+    e.cueY = cueBall.center.y;
+    e.cueRadius = cueBall.radius;
+    e.cueNoise = ballNoise(detections, cueBall, screenWidth, screenHeight, config);
+    e.objectX = targetBall.center.x;
+    e.objectY = targetBall.center.y;
+    e.objectRadius = targetBall.radius;
+    e.objectNoise = ballNoise(detections, targetBall, screenWidth, screenHeight, config);
+    e.aimX = shot.ghostX;
+    e.aimY = shot.ghostY;
+    if (shot.pocket >= 0 && shot.pocket < static_cast<int>(table.pockets.size())) {
+        e.pocketX = table.pockets[shot.pocket].x;
+        e.pocketY = table.pockets[shot.pocket].y;
+    }
+    return e;
+}
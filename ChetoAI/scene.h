@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "detection.h"
+#include "physics.h"
+#include "shot_ensemble.h"
+#include "shot_ranking.h"
+#include "tracker.h"
+
+// Convert YOLO detections (frame pixels) to Ball and Table structs in overlay space (1920x1080)
+void processDetections(const std::vector<Detection>& detections, Ball& cueBall, Ball& targetBall, Table& table, int screenWidth, int screenHeight);
+
+// Same output, but cue and target come from tracked balls (frame pixels, already extrapolated).
+// targetId keeps the chosen target across frames; -1 picks the ball nearest the cue.
+// others (optional) receives every remaining tracked ball, for the full-table simulation.
+// ranking (optional) ranks every object ball / pocket pair; the target then becomes the best
+// unobstructed shot, kept across frames while that ball still has a ranked shot.
+void processTrackedScene(const std::vector<Detection>& detections, const std::vector<TrackedBall>& balls, int& targetId,
+                         Ball& cueBall, Ball& targetBall, Table& table, int screenWidth, int screenHeight,
+                         std::vector<Ball>* others = nullptr, ShotRanking* ranking = nullptr,
+                         const ShotRankingConfig& rankingConfig = ShotRankingConfig());
+
+// Noise model of `ball` (overlay space) from the ball detection it came from: the nearest one of the
+// same kind within one radius. A ball with no such detection (the tracker is coasting it) gets the
+// zero-confidence noise.
+BallNoise ballNoise(const std::vector<Detection>& detections, const Ball& ball, int screenWidth, int screenHeight,
+                    const EnsembleConfig& config);
+
+// Ensemble input for a ranked shot on `targetBall`, noise from this frame's detections
+EnsembleShot toEnsembleShot(const std::vector<Detection>& detections, const Ball& cueBall, const Ball& targetBall,
+                            const RankedShot& shot, const Table& table, int screenWidth, int screenHeight,
+                            const EnsembleConfig& config);
@@ -0,0 +1,56 @@
+#include "seg_mask.h"
+#include "detection.h"
+#include <algorithm>
+#include <cmath>
+
+bool MaskAssembler::assemble(const MaskPrototypes& protos, const float* coeffs, const cv::Rect2f& boxProto,
+                             cv::Mat& mask, cv::Rect& protoRect) {
+    if (!protos.data || !coeffs || protos.channels <= 0) return false;
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(boxProto.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(boxProto.y)));
+    const int x1 = std::min(protos.width, static_cast<int>(std::ceil(boxProto.x + boxProto.width)));
+    const int y1 = std::min(protos.height, static_cast<int>(std::ceil(boxProto.y + boxProto.height)));
+    if (x1 <= x0 || y1 <= y0) return false;
+
+    const int roiW = x1 - x0;
+    const int roiH = y1 - y0;
+    const size_t planeSize = static_cast<size_t>(protos.width) * protos.height;
+    logits.assign(static_cast<size_t>(roiW) * roiH, 0.0f);
+
+    // One prototype plane at a time keeps the inner loop a contiguous axpy
+    for (int k = 0; k < protos.channels; ++k) {
+        const float c = coeffs[k];
+        const float* plane = protos.data + k * planeSize;
+        float* acc = logits.data();
+        for (int y = y0; y < y1; ++y) {
+            const float* src = plane + static_cast<size_t>(y) * protos.width + x0;
+            for (int x = 0; x < roiW; ++x) acc[x] += c * src[x];
+            acc += roiW;
+        }
+    }
+
+    // sigmoid(v) > 0.5  <=>  v > 0, so no exp is needed
+    mask.create(roiH, roiW, CV_8UC1);
+    const float* v = logits.data();
+    for (int y = 0; y < roiH; ++y) {
+        unsigned char* dst = mask.ptr<unsigned char>(y);
+        for (int x = 0; x < roiW; ++x) dst[x] = (*v++ > 0.0f) ? 255 : 0;
+    }
+    protoRect = cv::Rect(x0, y0, roiW, roiH);
+    return true;
+}
+
+cv::Mat upsampleMask(const Detection& det) {
+    if (det.mask.empty() || det.box.width <= 0 || det.box.height <= 0) return cv::Mat();
+
+    cv::Mat upsampled;
+    cv::resize(det.mask, upsampled, cv::Size(det.box.width, det.box.height), 0, 0, cv::INTER_LINEAR);
+    cv::threshold(upsampled, upsampled, 127, 255, cv::THRESH_BINARY);
+    return upsampled;
+}
+
+bool saveMaskImage(const std::string& path, const cv::Mat& mask) {
+    if (mask.empty()) return false;
+    return cv::imwrite(path, mask);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+struct Detection;
+
+// View of the YOLO-seg prototype output [1, channels, height, width]
+struct MaskPrototypes {
+    const float* data = nullptr;
+    int channels = 0; // 32 for YOLOv8/11-seg
+    int height = 0;   // 160 for a 640 input
+    int width = 0;
+};
+
+// Builds instance masks as sigmoid(coeffs . prototypes) > 0.5, evaluated only
+// inside the detection box. The dot product over the prototype channels is a
+// [1 x K] * [K x roiPixels] GEMM accumulated row by row.
+class MaskAssembler {
+public:
+    // coeffs: `protos.channels` floats for one detection.
+    // boxProto: detection box in prototype pixels (clamped here).
+    // mask receives a CV_8U 0/255 image the size of the clamped box; protoRect its placement.
+    bool assemble(const MaskPrototypes& protos, const float* coeffs, const cv::Rect2f& boxProto,
+                  cv::Mat& mask, cv::Rect& protoRect);
+
+private:
+    std::vector<float> logits;
+};
+
+// Resamples det.mask (prototype resolution) to the size of det.box in frame pixels.
+// Returns an empty Mat if the detection has no mask.
+cv::Mat upsampleMask(const Detection& det);
+
+// Debug helper: writes a mask to disk. Never call this from the frame loop.
+bool saveMaskImage(const std::string& path, const cv::Mat& mask);
@@ -0,0 +1,258 @@
+#include "shot_ensemble.h"
+#include "simd.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr float degreesToRadians = 0.017453292519943295f;
+constexpr float radiansToDegrees = 57.29577951308232f;
+constexpr float tiny = 1.0e-12f;
+
+// Per-call constants of the kernels
+struct Lanes {
+    float cueX, cueY, cueSigma, cueRadiusSigma;
+    float objectX, objectY, objectSigma, objectRadiusSigma;
+    float contact;                   // Nominal cue radius + object radius
+    float aimX, aimY;
+    float pocketX, pocketY, capture2;
+    float lineX, lineY;              // Unit nominal object ball -> pocket direction
+    const float* n[7];               // Noise rows (ShotEnsemble::Row order)
+    const float* aimCos;
+    const float* aimSin;
+    float* outcome;
+    float* spread;
+};
+
+void ensembleScalar(const Lanes& l, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        const float cx = l.cueX + l.cueSigma * l.n[0][i], cy = l.cueY + l.cueSigma * l.n[1][i];
+        const float ox = l.objectX + l.objectSigma * l.n[3][i], oy = l.objectY + l.objectSigma * l.n[4][i];
+        const float contact = l.contact + l.cueRadiusSigma * l.n[2][i] + l.objectRadiusSigma * l.n[5][i];
+
+        // Aim from the perturbed cue ball at the nominal ghost ball, rotated by the cueing error
+        const float ax = l.aimX - cx, ay = l.aimY - cy;
+        const float inv = 1.0f / std::sqrt(ax * ax + ay * ay + tiny);
+        const float ux = ax * inv, uy = ay * inv;
+        const float dx = ux * l.aimCos[i] - uy * l.aimSin[i], dy = ux * l.aimSin[i] + uy * l.aimCos[i];
+
+        // First touch: |r - t d| = contact, moving forward
+        const float rx = ox - cx, ry = oy - cy;
+        const float b = rx * dx + ry * dy;
+        const float disc = b * b - (rx * rx + ry * ry - contact * contact);
+        const bool hit = disc >= 0.0f && b > 0.0f;
+        const float t = b - std::sqrt(std::max(disc, 0.0f));
+        const float nx = (rx - t * dx) / contact, ny = (ry - t * dy) / contact;
+
+        // Object ball leaves along the line of centres; it drops if that line passes the capture circle
+        const float px = l.pocketX - ox, py = l.pocketY - oy;
+        const float along = px * nx + py * ny, perp = px * ny - py * nx;
+        const bool pocketed = hit && along > 0.0f && perp * perp < l.capture2;
+        l.outcome[i] = (hit ? 1.0f : 0.0f) + (pocketed ? 1.0f : 0.0f);
+        l.spread[i] = l.lineX * ny - l.lineY * nx;
+    }
+}
+
+#if defined(CHETO_SIMD_X86)
+void ensembleSSE(const Lanes& l, int begin, int end) {
+    const __m128 cueX = _mm_set1_ps(l.cueX), cueY = _mm_set1_ps(l.cueY), cueSigma = _mm_set1_ps(l.cueSigma);
+    const __m128 objX = _mm_set1_ps(l.objectX), objY = _mm_set1_ps(l.objectY), objSigma = _mm_set1_ps(l.objectSigma);
+    const __m128 cueRs = _mm_set1_ps(l.cueRadiusSigma), objRs = _mm_set1_ps(l.objectRadiusSigma);
+    const __m128 contact0 = _mm_set1_ps(l.contact), aimX = _mm_set1_ps(l.aimX), aimY = _mm_set1_ps(l.aimY);
+    const __m128 pocketX = _mm_set1_ps(l.pocketX), pocketY = _mm_set1_ps(l.pocketY), capture2 = _mm_set1_ps(l.capture2);
+    const __m128 lineX = _mm_set1_ps(l.lineX), lineY = _mm_set1_ps(l.lineY);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), eps = _mm_set1_ps(tiny);
+    for (int i = begin; i < end; i += 4) {
+        const __m128 cx = _mm_add_ps(cueX, _mm_mul_ps(cueSigma, _mm_load_ps(l.n[0] + i)));
+        const __m128 cy = _mm_add_ps(cueY, _mm_mul_ps(cueSigma, _mm_load_ps(l.n[1] + i)));
+        const __m128 ox = _mm_add_ps(objX, _mm_mul_ps(objSigma, _mm_load_ps(l.n[3] + i)));
+        const __m128 oy = _mm_add_ps(objY, _mm_mul_ps(objSigma, _mm_load_ps(l.n[4] + i)));
+        const __m128 contact = _mm_add_ps(contact0, _mm_add_ps(_mm_mul_ps(cueRs, _mm_load_ps(l.n[2] + i)),
+                                                               _mm_mul_ps(objRs, _mm_load_ps(l.n[5] + i))));
+
+        const __m128 ax = _mm_sub_ps(aimX, cx), ay = _mm_sub_ps(aimY, cy);
+        const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), eps)));
+        const __m128 ux = _mm_mul_ps(ax, inv), uy = _mm_mul_ps(ay, inv);
+        const __m128 c = _mm_load_ps(l.aimCos + i), s = _mm_load_ps(l.aimSin + i);
+        const __m128 dx = _mm_sub_ps(_mm_mul_ps(ux, c), _mm_mul_ps(uy, s));
+        const __m128 dy = _mm_add_ps(_mm_mul_ps(ux, s), _mm_mul_ps(uy, c));
+
+        const __m128 rx = _mm_sub_ps(ox, cx), ry = _mm_sub_ps(oy, cy);
+        const __m128 b = _mm_add_ps(_mm_mul_ps(rx, dx), _mm_mul_ps(ry, dy));
+        const __m128 r2 = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+        const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_sub_ps(r2, _mm_mul_ps(contact, contact)));
+        const __m128 hit = _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpgt_ps(b, zero));
+        const __m128 t = _mm_sub_ps(b, _mm_sqrt_ps(_mm_max_ps(disc, zero)));
+        const __m128 invContact = _mm_div_ps(one, contact);
+        const __m128 nx = _mm_mul_ps(_mm_sub_ps(rx, _mm_mul_ps(t, dx)), invContact);
+        const __m128 ny = _mm_mul_ps(_mm_sub_ps(ry, _mm_mul_ps(t, dy)), invContact);
+
+        const __m128 px = _mm_sub_ps(pocketX, ox), py = _mm_sub_ps(pocketY, oy);
+        const __m128 along = _mm_add_ps(_mm_mul_ps(px, nx), _mm_mul_ps(py, ny));
+        const __m128 perp = _mm_sub_ps(_mm_mul_ps(px, ny), _mm_mul_ps(py, nx));
+        const __m128 pocketed = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(along, zero),
+                                                           _mm_cmplt_ps(_mm_mul_ps(perp, perp), capture2)));
+        _mm_store_ps(l.outcome + i, _mm_add_ps(_mm_and_ps(hit, one), _mm_and_ps(pocketed, one)));
+        _mm_store_ps(l.spread + i, _mm_sub_ps(_mm_mul_ps(lineX, ny), _mm_mul_ps(lineY, nx)));
+    }
+}
+
+CHETO_TARGET_AVX2 void ensembleAVX2(const Lanes& l, int begin, int end) {
+    const __m256 cueX = _mm256_set1_ps(l.cueX), cueY = _mm256_set1_ps(l.cueY), cueSigma = _mm256_set1_ps(l.cueSigma);
+    const __m256 objX = _mm256_set1_ps(l.objectX), objY = _mm256_set1_ps(l.objectY);
+    const __m256 objSigma = _mm256_set1_ps(l.objectSigma);
+    const __m256 cueRs = _mm256_set1_ps(l.cueRadiusSigma), objRs = _mm256_set1_ps(l.objectRadiusSigma);
+    const __m256 contact0 = _mm256_set1_ps(l.contact), aimX = _mm256_set1_ps(l.aimX), aimY = _mm256_set1_ps(l.aimY);
+    const __m256 pocketX = _mm256_set1_ps(l.pocketX), pocketY = _mm256_set1_ps(l.pocketY);
+    const __m256 capture2 = _mm256_set1_ps(l.capture2);
+    const __m256 lineX = _mm256_set1_ps(l.lineX), lineY = _mm256_set1_ps(l.lineY);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), eps = _mm256_set1_ps(tiny);
+    for (int i = begin; i < end; i += 8) {
+        const __m256 cx = _mm256_fmadd_ps(cueSigma, _mm256_load_ps(l.n[0] + i), cueX);
+        const __m256 cy = _mm256_fmadd_ps(cueSigma, _mm256_load_ps(l.n[1] + i), cueY);
+        const __m256 ox = _mm256_fmadd_ps(objSigma, _mm256_load_ps(l.n[3] + i), objX);
+        const __m256 oy = _mm256_fmadd_ps(objSigma, _mm256_load_ps(l.n[4] + i), objY);
+        const __m256 contact = _mm256_fmadd_ps(objRs, _mm256_load_ps(l.n[5] + i),
+                                               _mm256_fmadd_ps(cueRs, _mm256_load_ps(l.n[2] + i), contact0));
+
+        const __m256 ax = _mm256_sub_ps(aimX, cx), ay = _mm256_sub_ps(aimY, cy);
+        const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_fmadd_ps(ax, ax, _mm256_fmadd_ps(ay, ay, eps))));
+        const __m256 ux = _mm256_mul_ps(ax, inv), uy = _mm256_mul_ps(ay, inv);
+        const __m256 c = _mm256_load_ps(l.aimCos + i), s = _mm256_load_ps(l.aimSin + i);
+        const __m256 dx = _mm256_fmsub_ps(ux, c, _mm256_mul_ps(uy, s));
+        const __m256 dy = _mm256_fmadd_ps(ux, s, _mm256_mul_ps(uy, c));
+
+        const __m256 rx = _mm256_sub_ps(ox, cx), ry = _mm256_sub_ps(oy, cy);
+        const __m256 b = _mm256_fmadd_ps(rx, dx, _mm256_mul_ps(ry, dy));
+        const __m256 r2 = _mm256_fmadd_ps(rx, rx, _mm256_mul_ps(ry, ry));
+        const __m256 disc = _mm256_fmsub_ps(b, b, _mm256_fnmadd_ps(contact, contact, r2));
+        const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ), _mm256_cmp_ps(b, zero, _CMP_GT_OQ));
+        const __m256 t = _mm256_sub_ps(b, _mm256_sqrt_ps(_mm256_max_ps(disc, zero)));
+        const __m256 invContact = _mm256_div_ps(one, contact);
+        const __m256 nx = _mm256_mul_ps(_mm256_fnmadd_ps(t, dx, rx), invContact);
+        const __m256 ny = _mm256_mul_ps(_mm256_fnmadd_ps(t, dy, ry), invContact);
+
+        const __m256 px = _mm256_sub_ps(pocketX, ox), py = _mm256_sub_ps(pocketY, oy);
+        const __m256 along = _mm256_fmadd_ps(px, nx, _mm256_mul_ps(py, ny));
+        const __m256 perp = _mm256_fmsub_ps(px, ny, _mm256_mul_ps(py, nx));
+        const __m256 pocketed = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(along, zero, _CMP_GT_OQ),
+            _mm256_cmp_ps(_mm256_mul_ps(perp, perp), capture2, _CMP_LT_OQ)));
+        _mm256_store_ps(l.outcome + i, _mm256_add_ps(_mm256_and_ps(hit, one), _mm256_and_ps(pocketed, one)));
+        _mm256_store_ps(l.spread + i, _mm256_fmsub_ps(lineX, ny, _mm256_mul_ps(lineY, nx)));
+    }
+}
+#endif
+
+float asinDegrees(float s) {
+    return std::asin(std::min(1.0f, std::max(-1.0f, s))) * radiansToDegrees;
+}
+
+} // namespace
+
+BallNoise detectionNoise(float boxWidth, float boxHeight, float confidence, float scale, const EnsembleConfig& config) {
+    BallNoise noise;
+    const float doubt = 1.0f - std::min(1.0f, std::max(0.0f, confidence));
+    // Centre and radius are each half the sum / difference of two edges: sigma / sqrt(2) from the edges.
+    // The radius is half the shorter side, a quarter of the side difference away from the mean radius
+    noise.position = scale * (config.boxJitter * 0.70710678f + config.confidenceJitter * doubt);
+    noise.radius = scale * (config.boxJitter * 0.70710678f + 0.25f * std::abs(boxWidth - boxHeight));
+    return noise;
+}
+
+ShotEnsemble::ShotEnsemble(const EnsembleConfig& config) : config(config) {
+    samples = std::min(ensembleMaxSamples, std::max(8, (config.samples + 7) / 8 * 8));
+    std::mt19937 rng(config.seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    for (int r = 0; r < RowCount; ++r)
+        for (int i = 0; i < ensembleMaxSamples; ++i) noise[r][i] = i < samples ? normal(rng) : 0.0f;
+    for (int i = 0; i < ensembleMaxSamples; ++i) {
+        const float angle = config.aimSigmaDegrees * degreesToRadians * noise[Aim][i];
+        aimCos[i] = std::cos(angle);
+        aimSin[i] = std::sin(angle);
+    }
+}
+
+void ShotEnsemble::evaluate(const EnsembleShot& shot, ShotUncertainty& out) {
+    CHETO_TRACE_SCOPE("shot ensemble");
+    const auto start = std::chrono::steady_clock::now();
+    out = ShotUncertainty();
+    out.samples = samples;
+    const float contact = shot.cueRadius + shot.objectRadius;
+    float lineX = shot.pocketX - shot.objectX, lineY = shot.pocketY - shot.objectY;
+    const float lineLength = std::sqrt(lineX * lineX + lineY * lineY);
+    if (contact <= 0.0f || lineLength <= 0.0f) return;
+
+    Lanes lanes;
+    lanes.cueX = shot.cueX;
+    lanes.cueY = shot.cueY;
+    lanes.cueSigma = shot.cueNoise.position;
+    lanes.cueRadiusSigma = shot.cueNoise.radius;
+    lanes.objectX = shot.objectX;
+    lanes.objectY = shot.objectY;
+    lanes.objectSigma = shot.objectNoise.position;
+    lanes.objectRadiusSigma = shot.objectNoise.radius;
+    lanes.contact = contact;
+    lanes.aimX = shot.aimX;
+    lanes.aimY = shot.aimY;
+    lanes.pocketX = shot.pocketX;
+    lanes.pocketY = shot.pocketY;
+    lanes.capture2 = config.pocketRadius * config.pocketRadius;
+    lanes.lineX = lineX / lineLength;
+    lanes.lineY = lineY / lineLength;
+    for (int r = 0; r < RowCount; ++r) lanes.n[r] = noise[r];
+    lanes.aimCos = aimCos;
+    lanes.aimSin = aimSin;
+    lanes.outcome = outcome;
+    lanes.spread = spread;
+
+#if defined(CHETO_SIMD_X86)
+    const SimdLevel level = activeSimdLevel();
+    if (level >= SimdLevel::AVX2) ensembleAVX2(lanes, 0, samples);
+    else if (level >= SimdLevel::SSE) ensembleSSE(lanes, 0, samples);
+    else ensembleScalar(lanes, 0, samples);
+#else
+    ensembleScalar(lanes, 0, samples);
+#endif
+
+    // Tally, the aim histogram and the hit directions
+    int hits = 0, pocketed = 0;
+    int binTotal[ensembleAimBins] = {}, binPocketed[ensembleAimBins] = {};
+    for (int i = 0; i < samples; ++i) {
+        const int bin = std::min(ensembleAimBins - 1,
+            std::max(0, static_cast<int>((noise[Aim][i] + 3.0f) * (ensembleAimBins / 6.0f))));
+        ++binTotal[bin];
+        if (outcome[i] >= 2.0f) {
+            ++pocketed;
+            ++binPocketed[bin];
+        }
+        if (outcome[i] >= 1.0f) sorted[hits++] = spread[i];
+    }
+    out.hitProbability = static_cast<float>(hits) / samples;
+    out.pocketProbability = static_cast<float>(pocketed) / samples;
+
+    // Widen the window from the bins around zero while they still pocket at least half the time
+    auto pockets = [&](int bin) { return binTotal[bin] > 0 && 2 * binPocketed[bin] >= binTotal[bin]; };
+    const float binWidth = 6.0f * config.aimSigmaDegrees / ensembleAimBins;
+    const int mid = ensembleAimBins / 2;
+    if (pockets(mid - 1) || pockets(mid)) {
+        int low = pockets(mid - 1) ? mid - 1 : mid, high = pockets(mid) ? mid : mid - 1;
+        while (low > 0 && pockets(low - 1)) --low;
+        while (high < ensembleAimBins - 1 && pockets(high + 1)) ++high;
+        out.aimLowDegrees = (low - mid) * binWidth;
+        out.aimHighDegrees = (high + 1 - mid) * binWidth;
+    }
+
+    if (hits > 0) {
+        const float tail = 0.5f * (1.0f - std::min(1.0f, std::max(0.0f, config.coverage)));
+        const int lowIndex = static_cast<int>(tail * (hits - 1));
+        const int highIndex = hits - 1 - lowIndex;
+        std::nth_element(sorted, sorted + lowIndex, sorted + hits);
+        out.coneLowDegrees = asinDegrees(sorted[lowIndex]);
+        std::nth_element(sorted + lowIndex, sorted + highIndex, sorted + hits);
+        out.coneHighDegrees = asinDegrees(sorted[highIndex]);
+    }
+    out.microseconds = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+// Monte Carlo view of one cut shot. Detection boxes jitter by a few pixels, so
+// each sample moves both balls and their radii within a per-detection noise
+// model and adds a cueing error to the aim. It then plays the shot: cue ray to
+// contact, object ball off along the line of centres, and a check on whether
+// that line passes the pocket's capture radius. The standard-normal draws are
+// made once per ensemble and stored SoA, so a frame costs only arithmetic over
+// SIMD lanes. The same draws every frame also keep the estimate from
+// flickering on a still table.
+
+constexpr int ensembleMaxSamples = 1024;
+constexpr int ensembleAimBins = 16;   // Aim-offset histogram over +-3 sigma for the tolerance window
+
+struct EnsembleConfig {
+    int samples = 256;                // Rounded up to a multiple of 8, at most ensembleMaxSamples
+    float boxJitter = 1.5f;           // Box edge noise, frame pixels (1 sigma)
+    float confidenceJitter = 4.0f;    // Extra centre noise at confidence 0, frame pixels
+    float aimSigmaDegrees = 0.1f;     // Aiming error (the in-game aim line is fine-grained)
+    float pocketRadius = 20.0f;       // Object ball centre passing within this of the pocket centre drops
+    float coverage = 0.9f;            // Share of object-ball directions inside the reported cone
+    uint32_t seed = 1;
+};
+
+// 1-sigma noise of a ball's centre (per axis) and radius, in the units the shot is given in
+struct BallNoise {
+    float position = 0.0f;
+    float radius = 0.0f;
+};
+
+// Noise of a ball detected as a boxWidth x boxHeight box (frame pixels) at `confidence`.
+// `scale` converts frame pixels to shot units (1920 / frame width for overlay space). The radius
+// is taken from the shorter box side, so a non-square box adds radius noise.
+BallNoise detectionNoise(float boxWidth, float boxHeight, float confidence, float scale, const EnsembleConfig& config);
+
+struct EnsembleShot {
+    float cueX = 0.0f, cueY = 0.0f, cueRadius = 0.0f;
+    BallNoise cueNoise;
+    float objectX = 0.0f, objectY = 0.0f, objectRadius = 0.0f;
+    BallNoise objectNoise;
+    float aimX = 0.0f, aimY = 0.0f;   // Where the player sends the cue ball (ghost-ball centre)
+    float pocketX = 0.0f, pocketY = 0.0f;
+};
+
+struct ShotUncertainty {
+    int samples = 0;
+    float hitProbability = 0.0f;      // Cue ball reaches the object ball
+    float pocketProbability = 0.0f;
+    // Aim offsets (degrees, around the nominal aim) whose histogram bins still pocket at least half
+    // their samples, contiguous with the nominal aim; both 0 when the nominal aim does not
+    float aimLowDegrees = 0.0f, aimHighDegrees = 0.0f;
+    // Object-ball directions relative to the nominal object ball -> pocket line (degrees, positive
+    // turning from +x towards +y), holding `coverage` of the hits
+    float coneLowDegrees = 0.0f, coneHighDegrees = 0.0f;
+    float microseconds = 0.0f;
+};
+
+class ShotEnsemble {
+public:
+    explicit ShotEnsemble(const EnsembleConfig& config = EnsembleConfig());
+
+    void evaluate(const EnsembleShot& shot, ShotUncertainty& out);
+
+    int sampleCount() const { return samples; }
+    const EnsembleConfig& settings() const { return config; }
+
+private:
+    enum Row { CueX, CueY, CueRadius, ObjectX, ObjectY, ObjectRadius, Aim, RowCount };
+
+    EnsembleConfig config;
+    int samples = 0;
+    alignas(32) float noise[RowCount][ensembleMaxSamples];   // Standard normal draws
+    alignas(32) float aimCos[ensembleMaxSamples];            // Rotation by the aim error of each sample
+    alignas(32) float aimSin[ensembleMaxSamples];
+    // Per-sample results of the last evaluate(): 0 miss, 1 hit, 2 pocketed; sine of the object-ball
+    // direction off the nominal pocket line
+    alignas(32) float outcome[ensembleMaxSamples];
+    alignas(32) float spread[ensembleMaxSamples];
+    float sorted[ensembleMaxSamples];
+};
@@ -0,0 +1,177 @@
+#include "shot_ranking.h"
+#include "simd.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float farAway = 1.0e15f;
+constexpr float radiansToDegrees = 57.29577951308232f;
+
+uint32_t segmentHitsScalar(float x0, float y0, float ex, float ey, float invLength2, float reach2,
+                           const float* xs, const float* ys, int begin) {
+    uint32_t mask = 0;
+    for (int j = begin; j < shotMaxBalls; ++j) {
+        const float rx = xs[j] - x0, ry = ys[j] - y0;
+        const float t = std::min(1.0f, std::max(0.0f, (rx * ex + ry * ey) * invLength2));
+        const float dx = rx - ex * t, dy = ry - ey * t;
+        if (dx * dx + dy * dy < reach2) mask |= 1u << j;
+    }
+    return mask;
+}
+
+#if defined(CHETO_SIMD_X86)
+uint32_t segmentHitsSSE(float x0, float y0, float ex, float ey, float invLength2, float reach2,
+                        const float* xs, const float* ys) {
+    const __m128 px = _mm_set1_ps(x0), py = _mm_set1_ps(y0);
+    const __m128 vx = _mm_set1_ps(ex), vy = _mm_set1_ps(ey);
+    const __m128 inv = _mm_set1_ps(invLength2), r2 = _mm_set1_ps(reach2);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    uint32_t mask = 0;
+    for (int j = 0; j < shotMaxBalls; j += 4) {
+        const __m128 rx = _mm_sub_ps(_mm_loadu_ps(xs + j), px);
+        const __m128 ry = _mm_sub_ps(_mm_loadu_ps(ys + j), py);
+        const __m128 t = _mm_min_ps(one, _mm_max_ps(zero, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rx, vx), _mm_mul_ps(ry, vy)), inv)));
+        const __m128 dx = _mm_sub_ps(rx, _mm_mul_ps(vx, t));
+        const __m128 dy = _mm_sub_ps(ry, _mm_mul_ps(vy, t));
+        const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(d2, r2))) << j;
+    }
+    return mask;
+}
+
+CHETO_TARGET_AVX2 uint32_t segmentHitsAVX2(float x0, float y0, float ex, float ey, float invLength2, float reach2,
+                                           const float* xs, const float* ys) {
+    const __m256 px = _mm256_set1_ps(x0), py = _mm256_set1_ps(y0);
+    const __m256 vx = _mm256_set1_ps(ex), vy = _mm256_set1_ps(ey);
+    const __m256 inv = _mm256_set1_ps(invLength2), r2 = _mm256_set1_ps(reach2);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    uint32_t mask = 0;
+    for (int j = 0; j < shotMaxBalls; j += 8) {
+        const __m256 rx = _mm256_sub_ps(_mm256_loadu_ps(xs + j), px);
+        const __m256 ry = _mm256_sub_ps(_mm256_loadu_ps(ys + j), py);
+        const __m256 t = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_mul_ps(_mm256_fmadd_ps(rx, vx, _mm256_mul_ps(ry, vy)), inv)));
+        const __m256 dx = _mm256_fnmadd_ps(vx, t, rx);
+        const __m256 dy = _mm256_fnmadd_ps(vy, t, ry);
+        const __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ))) << j;
+    }
+    return mask;
+}
+#endif
+
+// Keeps out.shots sorted by score, at most k entries
+void insertRanked(ShotRanking& out, int k, const RankedShot& shot) {
+    if (out.count == k && shot.score <= out.shots[k - 1].score) return;
+    int i = out.count < k ? out.count++ : k - 1;
+    while (i > 0 && out.shots[i - 1].score < shot.score) {
+        out.shots[i] = out.shots[i - 1];
+        --i;
+    }
+    out.shots[i] = shot;
+}
+
+} // namespace
+
+bool ShotQuery::addBall(float x, float y, int id) {
+    if (ballCount >= shotMaxBalls) return false;
+    ballX[ballCount] = x;
+    ballY[ballCount] = y;
+    ballId[ballCount] = id;
+    ++ballCount;
+    return true;
+}
+
+bool ShotQuery::addPocket(float x, float y) {
+    if (pocketCount >= shotMaxPockets) return false;
+    pocketX[pocketCount] = x;
+    pocketY[pocketCount] = y;
+    ++pocketCount;
+    return true;
+}
+
+const RankedShot* ShotRanking::findBall(int ballId) const {
+    for (int i = 0; i < count; ++i)
+        if (shots[i].ballId == ballId) return &shots[i];
+    return nullptr;
+}
+
+uint32_t segmentCircleHits(float x0, float y0, float x1, float y1, float reach, const float* xs, const float* ys) {
+    const float ex = x1 - x0, ey = y1 - y0;
+    const float length2 = ex * ex + ey * ey;
+    const float invLength2 = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+    const float reach2 = reach * reach;
+#if defined(CHETO_SIMD_X86)
+    const SimdLevel level = activeSimdLevel();
+    if (level >= SimdLevel::AVX2) return segmentHitsAVX2(x0, y0, ex, ey, invLength2, reach2, xs, ys);
+    if (level >= SimdLevel::SSE) return segmentHitsSSE(x0, y0, ex, ey, invLength2, reach2, xs, ys);
+#endif
+    return segmentHitsScalar(x0, y0, ex, ey, invLength2, reach2, xs, ys, 0);
+}
+
+void rankShots(const ShotQuery& query, const ShotRankingConfig& config, ShotRanking& out) {
+    CHETO_TRACE_SCOPE("shot ranking");
+    out.count = 0;
+    out.evaluated = 0;
+    out.blocked = 0;
+    const int k = std::min(std::max(config.topK, 1), shotMaxRanked);
+    if (query.radius <= 0.0f) return;
+
+    // Padded SoA copy so the kernels always run full width
+    alignas(32) float xs[shotMaxBalls];
+    alignas(32) float ys[shotMaxBalls];
+    const int ballCount = std::min(query.ballCount, shotMaxBalls);
+    for (int j = 0; j < shotMaxBalls; ++j) {
+        xs[j] = j < ballCount ? query.ballX[j] : farAway;
+        ys[j] = j < ballCount ? query.ballY[j] : farAway;
+    }
+
+    const float contact = 2.0f * query.radius;
+    const float reach = contact + config.clearance;
+    const float minCos = std::cos(config.maxCutDegrees / radiansToDegrees);
+
+    for (int b = 0; b < ballCount; ++b) {
+        const uint32_t others = ~(1u << b);
+        for (int p = 0; p < query.pocketCount; ++p) {
+            ++out.evaluated;
+            float ox = query.pocketX[p] - xs[b], oy = query.pocketY[p] - ys[b];
+            const float objectDistance = std::sqrt(ox * ox + oy * oy);
+            if (objectDistance <= 0.0f) continue;
+            ox /= objectDistance;
+            oy /= objectDistance;
+
+            // Ghost ball: cue centre at contact, one diameter behind the object ball on the pocket line
+            const float ghostX = xs[b] - ox * contact, ghostY = ys[b] - oy * contact;
+            float ax = ghostX - query.cueX, ay = ghostY - query.cueY;
+            const float cueDistance = std::sqrt(ax * ax + ay * ay);
+            if (cueDistance <= 0.0f) continue;
+            ax /= cueDistance;
+            ay /= cueDistance;
+
+            const float cutCos = ax * ox + ay * oy;
+            if (cutCos < minCos) continue;
+
+            const float score = cutCos / (1.0f + (cueDistance + objectDistance) / config.distanceScale);
+            if (out.count == k && score <= out.shots[k - 1].score) continue; // Cannot place; skip the queries
+
+            if ((segmentCircleHits(query.cueX, query.cueY, ghostX, ghostY, reach, xs, ys) & others)
+                || (segmentCircleHits(xs[b], ys[b], query.pocketX[p], query.pocketY[p], reach, xs, ys) & others)) {
+                ++out.blocked;
+                continue;
+            }
+
+            RankedShot shot;
+            shot.ball = b;
+            shot.ballId = query.ballId[b];
+            shot.pocket = p;
+            shot.ghostX = ghostX;
+            shot.ghostY = ghostY;
+            shot.cutDegrees = std::acos(std::min(1.0f, cutCos)) * radiansToDegrees;
+            shot.cueDistance = cueDistance;
+            shot.objectDistance = objectDistance;
+            shot.score = score;
+            insertRanked(out, k, shot);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+// Ranks every (object ball, pocket) pair as a direct cut shot: ghost-ball
+// position, cut angle, and whether another ball sits in the way of either leg
+// (cue -> ghost ball, object ball -> pocket). Plain float input and fixed-size
+// output, no allocation; cheap enough to run every frame.
+
+constexpr int shotMaxBalls = 16;     // Object balls (padded SIMD width)
+constexpr int shotMaxPockets = 6;
+constexpr int shotMaxRanked = 8;
+
+struct ShotRankingConfig {
+    int topK = 3;                    // <= shotMaxRanked
+    float maxCutDegrees = 75.0f;     // Thinner cuts are not offered
+    float clearance = 1.0f;          // Extra gap (units) a passing ball must leave
+    float distanceScale = 600.0f;    // Score halves when the combined leg length reaches this
+};
+
+// One frame's table, in any consistent units (overlay pixels in ChetoAI)
+struct ShotQuery {
+    float cueX = 0.0f, cueY = 0.0f;
+    float radius = 0.0f;             // Ball radius
+    int ballCount = 0;
+    float ballX[shotMaxBalls];
+    float ballY[shotMaxBalls];
+    int ballId[shotMaxBalls];        // Caller's id, copied to the result
+    int pocketCount = 0;
+    float pocketX[shotMaxPockets];
+    float pocketY[shotMaxPockets];
+
+    bool addBall(float x, float y, int id);
+    bool addPocket(float x, float y);
+};
+
+struct RankedShot {
+    int ball = -1;                   // Index in the query
+    int ballId = -1;
+    int pocket = -1;
+    float ghostX = 0.0f, ghostY = 0.0f; // Cue ball centre at contact
+    float cutDegrees = 0.0f;
+    float cueDistance = 0.0f;        // Cue -> ghost
+    float objectDistance = 0.0f;     // Object ball -> pocket
+    float score = 0.0f;              // Higher is easier
+};
+
+struct ShotRanking {
+    int count = 0;                   // Best first
+    RankedShot shots[shotMaxRanked];
+    int evaluated = 0;               // Pairs considered
+    int blocked = 0;                 // Pairs rejected for an obstruction (only pairs that could still
+                                     // make the top K are tested)
+
+    // Highest-ranked shot on the given ball id, or nullptr
+    const RankedShot* findBall(int ballId) const;
+};
+
+void rankShots(const ShotQuery& query, const ShotRankingConfig& config, ShotRanking& out);
+
+// Bit j set when obstacle j's centre lies within `reach` of the segment (x0, y0)-(x1, y1).
+// xs/ys hold shotMaxBalls entries; unused slots must be far away. Exposed for benchmarks.
+uint32_t segmentCircleHits(float x0, float y0, float x1, float y1, float reach,
+                           const float* xs, const float* ys);
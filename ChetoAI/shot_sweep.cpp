@@ -0,0 +1,327 @@
+#include "shot_sweep.h"
+#include "simd.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+constexpr float noContact = 3.0e38f;
+constexpr double degreesToRadians = 3.14159265358979323846 / 180.0;
+
+void firstContactsScalar(const ContactScene& s, const float* dirX, const float* dirY, int begin, int end,
+                         float* distance, int* code) {
+    for (int i = begin; i < end; ++i) {
+        const float ux = dirX[i], uy = dirY[i];
+        float best = noContact;
+        int bestCode = contactNone;
+
+        for (int j = 0; j < s.ballCount; ++j) {
+            const float along = s.ballX[j] * ux + s.ballY[j] * uy;
+            const float perp = s.ballX[j] * uy - s.ballY[j] * ux;
+            const float perp2 = perp * perp;
+            const float disc = s.contactRadius2 - perp2;
+            if (along <= 0.0f || disc <= 0.0f) continue;
+            const float d = std::max(0.0f, along - std::sqrt(disc));
+            if (d < best) { best = d; bestCode = contactCodeBall(s.ballIndex[j]); }
+        }
+
+        for (int k = 0; k < s.cushionCount; ++k) {
+            const float approach = -(s.cushionNx[k] * ux + s.cushionNy[k] * uy);
+            if (approach <= 0.0f) continue;
+            const float d = std::max(0.0f, s.cushionGap[k]) / approach;
+            if (d >= best) continue;
+            const float qx = ux * d - s.cushionX0[k], qy = uy * d - s.cushionY0[k];
+            const float t = (qx * s.cushionEx[k] + qy * s.cushionEy[k]) * s.cushionInvLength2[k];
+            if (t < -s.cushionSlack[k] || t > 1.0f + s.cushionSlack[k]) continue;
+            best = d;
+            bestCode = contactCodeCushion(k);
+        }
+
+        for (int p = 0; p < s.pocketCount; ++p) {
+            const float along = s.pocketX[p] * ux + s.pocketY[p] * uy;
+            const float perp = s.pocketX[p] * uy - s.pocketY[p] * ux;
+            const float perp2 = perp * perp;
+            const float disc = s.pocketRadius2 - perp2;
+            if (along <= 0.0f || disc <= 0.0f) continue;
+            const float d = std::max(0.0f, along - std::sqrt(disc));
+            if (d < best) { best = d; bestCode = contactCodePocket(p); }
+        }
+
+        distance[i] = best;
+        code[i] = bestCode;
+    }
+}
+
+#if defined(CHETO_SIMD_X86)
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+int firstContactsSSE(const ContactScene& s, const float* dirX, const float* dirY, int count,
+                     float* distance, int* code) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 contactR2 = _mm_set1_ps(s.contactRadius2);
+    const __m128 pocketR2 = _mm_set1_ps(s.pocketRadius2);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 ux = _mm_loadu_ps(dirX + i), uy = _mm_loadu_ps(dirY + i);
+        __m128 best = _mm_set1_ps(noContact);
+        __m128 bestCode = _mm_castsi128_ps(_mm_set1_epi32(contactNone));
+
+        for (int j = 0; j < s.ballCount; ++j) {
+            const __m128 bx = _mm_set1_ps(s.ballX[j]), by = _mm_set1_ps(s.ballY[j]);
+            const __m128 along = _mm_add_ps(_mm_mul_ps(bx, ux), _mm_mul_ps(by, uy));
+            const __m128 perp = _mm_sub_ps(_mm_mul_ps(bx, uy), _mm_mul_ps(by, ux));
+            const __m128 disc = _mm_sub_ps(contactR2, _mm_mul_ps(perp, perp));
+            const __m128 d = _mm_max_ps(zero, _mm_sub_ps(along, _mm_sqrt_ps(_mm_max_ps(disc, zero))));
+            const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(along, zero), _mm_cmpgt_ps(disc, zero)),
+                                          _mm_cmplt_ps(d, best));
+            best = select(hit, d, best);
+            bestCode = select(hit, _mm_castsi128_ps(_mm_set1_epi32(contactCodeBall(s.ballIndex[j]))), bestCode);
+        }
+
+        for (int k = 0; k < s.cushionCount; ++k) {
+            const __m128 approach = _mm_sub_ps(zero, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.cushionNx[k]), ux),
+                                                               _mm_mul_ps(_mm_set1_ps(s.cushionNy[k]), uy)));
+            const __m128 towards = _mm_cmpgt_ps(approach, zero);
+            const __m128 d = _mm_div_ps(_mm_set1_ps(std::max(0.0f, s.cushionGap[k])), select(towards, approach, one));
+            const __m128 qx = _mm_sub_ps(_mm_mul_ps(ux, d), _mm_set1_ps(s.cushionX0[k]));
+            const __m128 qy = _mm_sub_ps(_mm_mul_ps(uy, d), _mm_set1_ps(s.cushionY0[k]));
+            const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(qx, _mm_set1_ps(s.cushionEx[k])),
+                                                   _mm_mul_ps(qy, _mm_set1_ps(s.cushionEy[k]))),
+                                        _mm_set1_ps(s.cushionInvLength2[k]));
+            const __m128 onSegment = _mm_and_ps(_mm_cmpge_ps(t, _mm_set1_ps(-s.cushionSlack[k])),
+                                                _mm_cmple_ps(t, _mm_set1_ps(1.0f + s.cushionSlack[k])));
+            const __m128 hit = _mm_and_ps(_mm_and_ps(towards, onSegment), _mm_cmplt_ps(d, best));
+            best = select(hit, d, best);
+            bestCode = select(hit, _mm_castsi128_ps(_mm_set1_epi32(contactCodeCushion(k))), bestCode);
+        }
+
+        for (int p = 0; p < s.pocketCount; ++p) {
+            const __m128 px = _mm_set1_ps(s.pocketX[p]), py = _mm_set1_ps(s.pocketY[p]);
+            const __m128 along = _mm_add_ps(_mm_mul_ps(px, ux), _mm_mul_ps(py, uy));
+            const __m128 perp = _mm_sub_ps(_mm_mul_ps(px, uy), _mm_mul_ps(py, ux));
+            const __m128 disc = _mm_sub_ps(pocketR2, _mm_mul_ps(perp, perp));
+            const __m128 d = _mm_max_ps(zero, _mm_sub_ps(along, _mm_sqrt_ps(_mm_max_ps(disc, zero))));
+            const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(along, zero), _mm_cmpgt_ps(disc, zero)),
+                                          _mm_cmplt_ps(d, best));
+            best = select(hit, d, best);
+            bestCode = select(hit, _mm_castsi128_ps(_mm_set1_epi32(contactCodePocket(p))), bestCode);
+        }
+
+        _mm_storeu_ps(distance + i, best);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(code + i), _mm_castps_si128(bestCode));
+    }
+    return i;
+}
+
+CHETO_TARGET_AVX2 int firstContactsAVX2(const ContactScene& s, const float* dirX, const float* dirY, int count,
+                                        float* distance, int* code) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 contactR2 = _mm256_set1_ps(s.contactRadius2);
+    const __m256 pocketR2 = _mm256_set1_ps(s.pocketRadius2);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 ux = _mm256_loadu_ps(dirX + i), uy = _mm256_loadu_ps(dirY + i);
+        __m256 best = _mm256_set1_ps(noContact);
+        __m256 bestCode = _mm256_castsi256_ps(_mm256_set1_epi32(contactNone));
+
+        for (int j = 0; j < s.ballCount; ++j) {
+            const __m256 bx = _mm256_set1_ps(s.ballX[j]), by = _mm256_set1_ps(s.ballY[j]);
+            const __m256 along = _mm256_fmadd_ps(bx, ux, _mm256_mul_ps(by, uy));
+            const __m256 perp = _mm256_fmsub_ps(bx, uy, _mm256_mul_ps(by, ux));
+            const __m256 disc = _mm256_fnmadd_ps(perp, perp, contactR2);
+            const __m256 d = _mm256_max_ps(zero, _mm256_sub_ps(along, _mm256_sqrt_ps(_mm256_max_ps(disc, zero))));
+            const __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(along, zero, _CMP_GT_OQ),
+                                                           _mm256_cmp_ps(disc, zero, _CMP_GT_OQ)),
+                                             _mm256_cmp_ps(d, best, _CMP_LT_OQ));
+            best = _mm256_blendv_ps(best, d, hit);
+            bestCode = _mm256_blendv_ps(bestCode, _mm256_castsi256_ps(_mm256_set1_epi32(contactCodeBall(s.ballIndex[j]))), hit);
+        }
+
+        for (int k = 0; k < s.cushionCount; ++k) {
+            const __m256 approach = _mm256_sub_ps(zero, _mm256_fmadd_ps(_mm256_set1_ps(s.cushionNx[k]), ux,
+                                                                        _mm256_mul_ps(_mm256_set1_ps(s.cushionNy[k]), uy)));
+            const __m256 towards = _mm256_cmp_ps(approach, zero, _CMP_GT_OQ);
+            const __m256 d = _mm256_div_ps(_mm256_set1_ps(std::max(0.0f, s.cushionGap[k])), _mm256_blendv_ps(one, approach, towards));
+            const __m256 qx = _mm256_fmsub_ps(ux, d, _mm256_set1_ps(s.cushionX0[k]));
+            const __m256 qy = _mm256_fmsub_ps(uy, d, _mm256_set1_ps(s.cushionY0[k]));
+            const __m256 t = _mm256_mul_ps(_mm256_fmadd_ps(qx, _mm256_set1_ps(s.cushionEx[k]),
+                                                           _mm256_mul_ps(qy, _mm256_set1_ps(s.cushionEy[k]))),
+                                           _mm256_set1_ps(s.cushionInvLength2[k]));
+            const __m256 onSegment = _mm256_and_ps(_mm256_cmp_ps(t, _mm256_set1_ps(-s.cushionSlack[k]), _CMP_GE_OQ),
+                                                   _mm256_cmp_ps(t, _mm256_set1_ps(1.0f + s.cushionSlack[k]), _CMP_LE_OQ));
+            const __m256 hit = _mm256_and_ps(_mm256_and_ps(towards, onSegment), _mm256_cmp_ps(d, best, _CMP_LT_OQ));
+            best = _mm256_blendv_ps(best, d, hit);
+            bestCode = _mm256_blendv_ps(bestCode, _mm256_castsi256_ps(_mm256_set1_epi32(contactCodeCushion(k))), hit);
+        }
+
+        for (int p = 0; p < s.pocketCount; ++p) {
+            const __m256 px = _mm256_set1_ps(s.pocketX[p]), py = _mm256_set1_ps(s.pocketY[p]);
+            const __m256 along = _mm256_fmadd_ps(px, ux, _mm256_mul_ps(py, uy));
+            const __m256 perp = _mm256_fmsub_ps(px, uy, _mm256_mul_ps(py, ux));
+            const __m256 disc = _mm256_fnmadd_ps(perp, perp, pocketR2);
+            const __m256 d = _mm256_max_ps(zero, _mm256_sub_ps(along, _mm256_sqrt_ps(_mm256_max_ps(disc, zero))));
+            const __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(along, zero, _CMP_GT_OQ),
+                                                           _mm256_cmp_ps(disc, zero, _CMP_GT_OQ)),
+                                             _mm256_cmp_ps(d, best, _CMP_LT_OQ));
+            best = _mm256_blendv_ps(best, d, hit);
+            bestCode = _mm256_blendv_ps(bestCode, _mm256_castsi256_ps(_mm256_set1_epi32(contactCodePocket(p))), hit);
+        }
+
+        _mm256_storeu_ps(distance + i, best);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(code + i), _mm256_castps_si256(bestCode));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+ContactScene::ContactScene(const SimState& layout, const SimTable& table, const SimParams& params) {
+    const float cx = static_cast<float>(layout.x[0]), cy = static_cast<float>(layout.y[0]);
+    const float radius = params.ballRadius;
+    contactRadius2 = 4.0f * radius * radius;
+    pocketRadius2 = params.pocketRadius * params.pocketRadius;
+
+    for (int i = 1; i < layout.count; ++i) {
+        if (layout.status[i] == SimBallStatus::Pocketed) continue;
+        ballX[ballCount] = static_cast<float>(layout.x[i]) - cx;
+        ballY[ballCount] = static_cast<float>(layout.y[i]) - cy;
+        ballIndex[ballCount] = i;
+        ++ballCount;
+    }
+
+    for (int k = 0; k < table.cushionCount; ++k) {
+        const SimCushion& e = table.cushions[k];
+        const float ex = e.x1 - e.x0, ey = e.y1 - e.y0;
+        const float length2 = ex * ex + ey * ey;
+        cushionNx[k] = e.nx;
+        cushionNy[k] = e.ny;
+        cushionX0[k] = e.x0 - cx;
+        cushionY0[k] = e.y0 - cy;
+        cushionEx[k] = ex;
+        cushionEy[k] = ey;
+        cushionInvLength2[k] = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+        cushionSlack[k] = length2 > 0.0f ? radius / std::sqrt(length2) : -2.0f; // Degenerate: never on the segment
+        cushionGap[k] = e.nx * (cx - e.x0) + e.ny * (cy - e.y0) - radius;
+    }
+    cushionCount = table.cushionCount;
+
+    for (int p = 0; p < table.pocketCount; ++p) {
+        pocketX[p] = table.pocketX[p] - cx;
+        pocketY[p] = table.pocketY[p] - cy;
+    }
+    pocketCount = table.pocketCount;
+}
+
+void findFirstContacts(const ContactScene& scene, const float* dirX, const float* dirY, int count,
+                       float* distance, int* code) {
+    int done = 0;
+#if defined(CHETO_SIMD_X86)
+    const SimdLevel level = activeSimdLevel();
+    if (level >= SimdLevel::AVX2) done = firstContactsAVX2(scene, dirX, dirY, count, distance, code);
+    else if (level >= SimdLevel::SSE) done = firstContactsSSE(scene, dirX, dirY, count, distance, code);
+#endif
+    firstContactsScalar(scene, dirX, dirY, done, count, distance, code);
+}
+
+ShotSweeper::ShotSweeper(const SimParams& params, int threads)
+    : params(params), pool(threads) {
+    this->params.outcomeOnly = true;
+    simulators.assign(pool.workerCount(), Simulator(this->params));
+    results.resize(pool.workerCount());
+    workerRollouts.assign(pool.workerCount(), 0);
+}
+
+void ShotSweeper::sweep(const SimState& layout, const SimTable& table, const SweepConfig& config,
+                        std::vector<SweepOutcome>& out) {
+    CHETO_TRACE_SCOPE("shot sweep");
+    const auto start = std::chrono::steady_clock::now();
+    const int angles = config.stepDegrees > 0.0f
+        ? std::max(0, static_cast<int>(std::ceil((config.endDegrees - config.startDegrees) / config.stepDegrees)))
+        : 0;
+    const int speedCount = std::min(std::max(config.speedCount, 1), 4);
+
+    if (static_cast<int>(dirX.size()) < angles) {
+        dirX.resize(angles);
+        dirY.resize(angles);
+        contactDistance.resize(angles);
+        contactCode.resize(angles);
+    }
+    for (int a = 0; a < angles; ++a) {
+        const double radians = (config.startDegrees + a * static_cast<double>(config.stepDegrees)) * degreesToRadians;
+        dirX[a] = static_cast<float>(std::cos(radians));
+        dirY[a] = static_cast<float>(std::sin(radians));
+    }
+    out.resize(static_cast<size_t>(angles) * speedCount);
+    std::fill(workerRollouts.begin(), workerRollouts.end(), 0);
+
+    pool.parallelFor(angles, config.grain, [&](int begin, int end, int worker) {
+        sweepRange(begin, end, worker, layout, table, config, out);
+    });
+
+    counters.candidates = angles * speedCount;
+    counters.rollouts = 0;
+    for (int n : workerRollouts) counters.rollouts += n;
+    counters.microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShotSweeper::sweepRange(int begin, int end, int worker, const SimState& layout, const SimTable& table,
+                             const SweepConfig& config, std::vector<SweepOutcome>& out) {
+    const ContactScene scene(layout, table, params);
+    findFirstContacts(scene, dirX.data() + begin, dirY.data() + begin, end - begin,
+                      contactDistance.data() + begin, contactCode.data() + begin);
+
+    Simulator& simulator = simulators[worker];
+    SimResult& result = results[worker];
+    const int speedCount = std::min(std::max(config.speedCount, 1), 4);
+    const double decel = params.rollingDecel;
+
+    for (int a = begin; a < end; ++a) {
+        const float ux = dirX[a], uy = dirY[a];
+        const float distance = contactDistance[a];
+        const int code = contactCode[a];
+        for (int s = 0; s < speedCount; ++s) {
+            const float speed = config.speeds[s];
+            SweepOutcome& row = out[static_cast<size_t>(a) * speedCount + s];
+            row.degrees = config.startDegrees + a * config.stepDegrees;
+            row.speed = speed;
+            row.firstHit = -1;
+            row.scratch = false;
+            row.truncated = false;
+            row.pocketed = 0;
+
+            // Settled by the straight-line pass: rolls dead, or drops straight into a pocket
+            const double stopDistance = decel > 0.0 ? speed * static_cast<double>(speed) / (2.0 * decel) : 1e30;
+            if (code == contactNone || distance >= stopDistance) continue;
+            if (code >= contactCodePocket(0)) {
+                row.scratch = true;
+                row.pocketed = 1;
+                continue;
+            }
+
+            // Roll out from the first contact; nothing else moved before it
+            const double remaining = std::sqrt(std::max(0.0, speed * static_cast<double>(speed) - 2.0 * decel * distance));
+            SimState state = layout;
+            state.x[0] += ux * distance;
+            state.y[0] += uy * distance;
+            state.vx[0] = ux * remaining;
+            state.vy[0] = uy * remaining;
+            state.status[0] = SimBallStatus::Moving;
+            simulator.run(state, table, result);
+            ++workerRollouts[worker];
+
+            row.firstHit = static_cast<int8_t>(result.firstHit);
+            row.scratch = result.scratch;
+            row.truncated = result.truncated;
+            for (int i = 0; i < result.ballCount; ++i)
+                if (result.balls[i].pocketed && layout.status[i] != SimBallStatus::Pocketed)
+                    row.pocketed |= static_cast<uint16_t>(1u << i);
+        }
+    }
+}
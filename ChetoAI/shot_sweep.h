@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "simulation.h"
+#include "thread_pool.h"
+
+struct SweepConfig {
+    float startDegrees = 0.0f;
+    float endDegrees = 360.0f;      // Exclusive
+    float stepDegrees = 0.05f;
+    int speedCount = 1;             // Power levels per angle, from speeds[]
+    float speeds[4] = { 1500.0f, 800.0f, 2500.0f, 3500.0f }; // Cue ball speed, units/s
+    int grain = 64;                 // Angles per work chunk
+};
+
+// One row of the angle -> outcome table
+struct SweepOutcome {
+    float degrees;
+    float speed;
+    int8_t firstHit;                // Object ball the cue ball touched first, -1 if none
+    bool scratch;
+    bool truncated;                 // Rollout hit a simulator limit
+    uint16_t pocketed;              // Bit i = ball i pocketed (bit 0 = cue)
+};
+
+struct SweepStats {
+    int candidates = 0;
+    int rollouts = 0;               // Candidates that needed the full simulator
+    double microseconds = 0.0;
+};
+
+// Sweeps the cue ball through many aim directions (and power levels) over one
+// resting layout. Stage 1 finds, for a block of directions at once in SIMD
+// lanes (directions are the lanes, balls/cushions/pockets are broadcast), what
+// the cue ball's straight path meets first; a direct scratch or a shot that
+// dies before reaching anything is settled there. Everything else is rolled
+// out by the event-driven Simulator, starting at that first contact. Chunks of
+// angles run on a WorkStealingPool with one Simulator per worker.
+class ShotSweeper {
+public:
+    explicit ShotSweeper(const SimParams& params = SimParams(), int threads = -1);
+
+    // layout: balls at rest, ball 0 the cue ball. out is angle-major, speedCount rows per angle.
+    void sweep(const SimState& layout, const SimTable& table, const SweepConfig& config,
+               std::vector<SweepOutcome>& out);
+
+    const SweepStats& stats() const { return counters; }
+    int workerCount() const { return pool.workerCount(); }
+
+private:
+    void sweepRange(int begin, int end, int worker, const SimState& layout, const SimTable& table,
+                    const SweepConfig& config, std::vector<SweepOutcome>& out);
+
+    SimParams params;
+    WorkStealingPool pool;
+    std::vector<Simulator> simulators;  // One per worker
+    std::vector<SimResult> results;
+    std::vector<int> workerRollouts;
+
+    // Per-angle SoA scratch, sized to the largest sweep so far
+    std::vector<float> dirX, dirY;
+    std::vector<float> contactDistance;
+    std::vector<int> contactCode;
+
+    SweepStats counters;
+};
+
+// First thing the cue ball's straight path meets, per direction: a code from
+// contactCode*() and the distance travelled. Exposed for benchmarks.
+struct ContactScene {
+    int ballCount = 0;               // Object balls, relative to the cue ball
+    float ballX[simMaxBalls], ballY[simMaxBalls];
+    int ballIndex[simMaxBalls];      // Index in the SimState
+    int cushionCount = 0;
+    float cushionGap[simMaxCushions];    // Cue centre distance to the cushion line minus one radius
+    float cushionNx[simMaxCushions], cushionNy[simMaxCushions];
+    float cushionX0[simMaxCushions], cushionY0[simMaxCushions]; // Relative to the cue ball
+    float cushionEx[simMaxCushions], cushionEy[simMaxCushions];
+    float cushionInvLength2[simMaxCushions], cushionSlack[simMaxCushions];
+    int pocketCount = 0;
+    float pocketX[simMaxPockets], pocketY[simMaxPockets];
+    float contactRadius2 = 0.0f;     // (2R)^2
+    float pocketRadius2 = 0.0f;
+
+    ContactScene(const SimState& layout, const SimTable& table, const SimParams& params);
+};
+
+constexpr int contactNone = -1;
+inline int contactCodeBall(int i) { return i; }
+inline int contactCodeCushion(int k) { return 64 + k; }
+inline int contactCodePocket(int p) { return 128 + p; }
+
+void findFirstContacts(const ContactScene& scene, const float* dirX, const float* dirY, int count,
+                       float* distance, int* code);
@@ -0,0 +1,78 @@
+#include "simd.h"
+#include <atomic>
+
+#if defined(CHETO_SIMD_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static SimdLevel detectSimdLevel() {
+#if defined(CHETO_SIMD_X86)
+    int regs[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+    __cpuid(regs, 0);
+#else
+    __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    const int maxLeaf = regs[0];
+
+#if defined(_MSC_VER)
+    __cpuid(regs, 1);
+#else
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+
+    bool ymmEnabled = false;
+    if (osxsave && avx) {
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int lo = 0, hi = 0;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        unsigned long long xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+        ymmEnabled = (xcr0 & 0x6) == 0x6; // XMM and YMM state saved by the OS
+    }
+
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+#if defined(_MSC_VER)
+        __cpuidex(regs, 7, 0);
+#else
+        __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        avx2 = (regs[1] & (1 << 5)) != 0;
+    }
+
+    if (ymmEnabled && avx2 && fma) return SimdLevel::AVX2;
+    return SimdLevel::SSE;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static std::atomic<int> simdCap{ static_cast<int>(SimdLevel::AVX2) };
+
+SimdLevel activeSimdLevel() {
+    static const SimdLevel detected = detectSimdLevel();
+    int cap = simdCap.load(std::memory_order_relaxed);
+    return static_cast<int>(detected) < cap ? detected : static_cast<SimdLevel>(cap);
+}
+
+void overrideSimdLevel(SimdLevel maxLevel) {
+    simdCap.store(static_cast<int>(maxLevel), std::memory_order_relaxed);
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::SSE: return "SSE2";
+    default: return "Scalar";
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Shared helpers for the hand-vectorized hot-path kernels.
+// Kernels are compiled for every level and picked at runtime, so the project
+// does not need /arch:AVX2 to get the AVX2 paths.
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CHETO_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// MSVC allows AVX2 intrinsics in any function; GCC/Clang need the target attribute.
+#if defined(CHETO_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CHETO_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define CHETO_TARGET_AVX2
+#endif
+
+enum class SimdLevel {
+    Scalar = 0,
+    SSE = 1,   // SSE2 (baseline on x64)
+    AVX2 = 2   // AVX2 + FMA
+};
+
+// Best level supported by both the CPU and the OS, capped by overrideSimdLevel().
+SimdLevel activeSimdLevel();
+
+// Caps the level returned by activeSimdLevel(); used by benchmarks to compare paths.
+void overrideSimdLevel(SimdLevel maxLevel);
+
+const char* simdLevelName(SimdLevel level);
@@ -0,0 +1,559 @@
+#include "simulation.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double infiniteTime = std::numeric_limits<double>::infinity();
+constexpr double timeEpsilon = 1e-9;
+
+double evaluate(const double* c, int degree, double t) {
+    double v = c[degree];
+    for (int k = degree - 1; k >= 0; --k) v = v * t + c[k];
+    return v;
+}
+
+// Safeguarded Newton on a bracket [a, b] with a sign change (fa at a)
+double refineRoot(const double* c, int degree, double a, double b, double fa) {
+    double d[4];
+    for (int k = 1; k <= degree; ++k) d[k - 1] = k * c[k];
+
+    double t = 0.5 * (a + b);
+    for (int iter = 0; iter < 60; ++iter) {
+        const double f = evaluate(c, degree, t);
+        if (f == 0.0) return t;
+        if ((f < 0.0) == (fa < 0.0)) { a = t; fa = f; }
+        else b = t;
+
+        const double slope = evaluate(d, degree - 1, t);
+        double next = slope != 0.0 ? t - f / slope : a;
+        if (!(next > a && next < b)) next = 0.5 * (a + b);
+        if (std::fabs(next - t) <= 1e-12 * (1.0 + std::fabs(t)) || b - a <= 1e-12) return next;
+        t = next;
+    }
+    return t;
+}
+
+// All sign-changing roots in (lo, hi), ascending; stops after the first when firstOnly
+int rootsIn(const double* c, int degree, double lo, double hi, double* out, bool firstOnly) {
+    while (degree > 0 && c[degree] == 0.0) --degree;
+    if (degree <= 0 || !(hi > lo)) return 0;
+
+    if (degree == 1) {
+        const double t = -c[0] / c[1];
+        if (t > lo && t < hi) { out[0] = t; return 1; }
+        return 0;
+    }
+
+    // Split at the critical points (roots of the derivative) so every piece is
+    // monotone and holds at most one root
+    double d[4];
+    for (int k = 1; k <= degree; ++k) d[k - 1] = k * c[k];
+    double critical[4];
+    const int criticalCount = rootsIn(d, degree - 1, lo, hi, critical, false);
+
+    int n = 0;
+    double a = lo;
+    double fa = evaluate(c, degree, a);
+    for (int k = 0; k <= criticalCount; ++k) {
+        const double b = k < criticalCount ? critical[k] : hi;
+        const double fb = evaluate(c, degree, b);
+        if ((fa < 0.0 && fb > 0.0) || (fa > 0.0 && fb < 0.0)) {
+            out[n++] = refineRoot(c, degree, a, b, fa);
+            if (firstOnly) return n;
+        }
+        a = b;
+        fa = fb;
+    }
+    return n;
+}
+
+// Distance along the ray from (x, y) in unit direction (ux, uy) to the first point
+// within `radius` of (cx, cy). Starting inside counts only when heading inwards.
+bool rayCircle(double x, double y, double ux, double uy, double cx, double cy, double radius, double& distance) {
+    const double rx = cx - x, ry = cy - y;
+    const double along = rx * ux + ry * uy;
+    const double length2 = rx * rx + ry * ry;
+    const double radius2 = radius * radius;
+    if (length2 <= radius2) {
+        distance = 0.0;
+        return along > 0.0;
+    }
+    if (along <= 0.0) return false;
+    const double perp2 = length2 - along * along;
+    if (perp2 >= radius2) return false;
+    distance = along - std::sqrt(radius2 - perp2);
+    return true;
+}
+
+// Time for a ball rolling at `speed` under `decel` to cover `distance`; false if it stops first
+bool timeToTravel(double speed, double decel, double distance, double& t) {
+    const double disc = speed * speed - 2.0 * decel * distance;
+    if (disc < 0.0) return false;
+    t = 2.0 * distance / (speed + std::sqrt(disc)); // Stable form of (v - sqrt(v^2 - 2ad)) / a
+    return true;
+}
+
+double segmentDistance2(double px, double py, double qx, double qy, double ax, double ay) {
+    const double ex = qx - px, ey = qy - py;
+    const double length2 = ex * ex + ey * ey;
+    double t = length2 > 0.0 ? ((ax - px) * ex + (ay - py) * ey) / length2 : 0.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    const double dx = px + ex * t - ax, dy = py + ey * t - ay;
+    return dx * dx + dy * dy;
+}
+
+bool segmentsIntersect(double p0x, double p0y, double p1x, double p1y, double q0x, double q0y, double q1x, double q1y) {
+    const double d1 = (p1x - p0x) * (q0y - p0y) - (p1y - p0y) * (q0x - p0x);
+    const double d2 = (p1x - p0x) * (q1y - p0y) - (p1y - p0y) * (q1x - p0x);
+    const double d3 = (q1x - q0x) * (p0y - q0y) - (q1y - q0y) * (p0x - q0x);
+    const double d4 = (q1x - q0x) * (p1y - q0y) - (q1y - q0y) * (p1x - q0x);
+    return ((d1 < 0.0) != (d2 < 0.0)) && ((d3 < 0.0) != (d4 < 0.0));
+}
+
+// Squared distance between segments p0-p1 and q0-q1
+double segmentSegmentDistance2(double p0x, double p0y, double p1x, double p1y,
+                               double q0x, double q0y, double q1x, double q1y) {
+    if (segmentsIntersect(p0x, p0y, p1x, p1y, q0x, q0y, q1x, q1y)) return 0.0;
+    const double a = segmentDistance2(p0x, p0y, p1x, p1y, q0x, q0y);
+    const double b = segmentDistance2(p0x, p0y, p1x, p1y, q1x, q1y);
+    const double c = segmentDistance2(q0x, q0y, q1x, q1y, p0x, p0y);
+    const double d = segmentDistance2(q0x, q0y, q1x, q1y, p1x, p1y);
+    return std::min(std::min(a, b), std::min(c, d));
+}
+
+} // namespace
+
+// Distance a ball covers in the next `horizon` seconds (horizon <= its stop time)
+double Simulator::reachWithin(const Motion& m, double horizon) const {
+    if (m.stop <= 0.0) return 0.0;
+    return m.speed * horizon - 0.5 * params.rollingDecel * horizon * horizon;
+}
+
+bool smallestRoot(const double* c, int degree, double lo, double hi, double& root) {
+    double roots[4];
+    if (rootsIn(c, degree, lo, hi, roots, true) == 0) return false;
+    root = roots[0];
+    return true;
+}
+
+SimTable SimTable::rectangle(float minX, float minY, float maxX, float maxY,
+                             const float* pocketX, const float* pocketY, int pocketCount) {
+    SimTable table;
+    table.cushions[0] = { minX, minY, maxX, minY, 0.0f, 1.0f };  // Top
+    table.cushions[1] = { maxX, minY, maxX, maxY, -1.0f, 0.0f }; // Right
+    table.cushions[2] = { maxX, maxY, minX, maxY, 0.0f, -1.0f }; // Bottom
+    table.cushions[3] = { minX, maxY, minX, minY, 1.0f, 0.0f };  // Left
+    table.cushionCount = 4;
+
+    table.pocketCount = pocketCount < simMaxPockets ? pocketCount : simMaxPockets;
+    for (int i = 0; i < table.pocketCount; ++i) {
+        table.pocketX[i] = pocketX[i];
+        table.pocketY[i] = pocketY[i];
+    }
+    return table;
+}
+
+int SimState::add(float px, float py, float pvx, float pvy) {
+    if (count >= simMaxBalls) return -1;
+    const int i = count++;
+    x[i] = px;
+    y[i] = py;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    t0[i] = 0.0;
+    status[i] = (pvx != 0.0f || pvy != 0.0f) ? SimBallStatus::Moving : SimBallStatus::Resting;
+    return i;
+}
+
+Simulator::Motion Simulator::motionAt(const SimState& state, int i, double now) const {
+    Motion m = { state.x[i], state.y[i], 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (state.status[i] != SimBallStatus::Moving) return m;
+
+    const double speed = std::sqrt(state.vx[i] * state.vx[i] + state.vy[i] * state.vy[i]);
+    if (speed <= 0.0) return m;
+    const double decel = params.rollingDecel;
+    const double ux = state.vx[i] / speed;
+    const double uy = state.vy[i] / speed;
+    const double stopAfter = decel > 0.0 ? speed / decel : infiniteTime;
+
+    const double dt = now - state.t0[i];
+    const double tau = dt < stopAfter ? dt : stopAfter;
+    const double travelled = speed * tau - 0.5 * decel * tau * tau;
+    const double remaining = speed - decel * tau;
+    m.x += ux * travelled;
+    m.y += uy * travelled;
+    if (remaining <= 0.0) return m;
+
+    m.vx = ux * remaining;
+    m.vy = uy * remaining;
+    m.ax = -ux * decel;
+    m.ay = -uy * decel;
+    m.speed = remaining;
+    m.ux = ux;
+    m.uy = uy;
+    m.stop = stopAfter - tau;
+    return m;
+}
+
+void Simulator::updateMotions(const SimState& state, double now) {
+    for (int i = 0; i < state.count; ++i) motions[i] = motionAt(state, i, now);
+}
+
+// Earliest approach to contact distance before either ball's motion changes by itself
+void Simulator::schedulePair(int i, int j, double now) {
+    const Motion& a = motions[i];
+    const Motion& b = motions[j];
+    const bool aMoving = a.stop > 0.0;
+    const bool bMoving = b.stop > 0.0;
+    if (!aMoving && !bMoving) return;
+    double horizon = aMoving && bMoving ? (a.stop < b.stop ? a.stop : b.stop) : (aMoving ? a.stop : b.stop);
+    if (now + horizon > params.maxTime) horizon = params.maxTime - now;
+    if (horizon <= 0.0) return;
+
+    const double contact = 2.0 * params.ballRadius;
+    double t = 0.0;
+
+    // Against a resting ball the mover's path is a straight ray: contact distance in closed form
+    if (!aMoving || !bMoving) {
+        const Motion& m = aMoving ? a : b;
+        const Motion& rest = aMoving ? b : a;
+        double distance;
+        if (!rayCircle(m.x, m.y, m.ux, m.uy, rest.x, rest.y, contact, distance)) return;
+        if (!timeToTravel(m.speed, params.rollingDecel, distance, t) || t > horizon) return;
+        push({ now + t, SimEventType::BallBall, static_cast<uint8_t>(i), static_cast<uint8_t>(j), version[i], version[j] });
+        return;
+    }
+
+    // Both rolling: each stays on its own straight segment until the horizon, so segments
+    // further apart than a ball diameter cannot meet and the quartic is skipped
+    {
+        const double travelA = reachWithin(a, horizon);
+        const double travelB = reachWithin(b, horizon);
+        if (segmentSegmentDistance2(a.x, a.y, a.x + a.ux * travelA, a.y + a.uy * travelA,
+                                    b.x, b.y, b.x + b.ux * travelB, b.y + b.uy * travelB) > contact * contact)
+            return;
+    }
+
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    const double ux = b.vx - a.vx, uy = b.vy - a.vy;
+    const double wx = b.ax - a.ax, wy = b.ay - a.ay;
+
+    // |d + u t + w t^2 / 2|^2 - contact^2
+    double c[5];
+    c[4] = 0.25 * (wx * wx + wy * wy);
+    c[3] = ux * wx + uy * wy;
+    c[2] = ux * ux + uy * uy + dx * wx + dy * wy;
+    c[1] = 2.0 * (dx * ux + dy * uy);
+    c[0] = dx * dx + dy * dy - contact * contact;
+
+    if (c[0] <= 0.0) {
+        // Already touching: collide now if closing, otherwise wait until they part and meet again
+        if (c[1] < 0.0) t = 0.0;
+        else {
+            double exit;
+            if (!smallestRoot(c, 4, 0.0, horizon, exit)) return;
+            if (!smallestRoot(c, 4, exit + timeEpsilon, horizon, t)) return;
+        }
+    }
+    else if (!smallestRoot(c, 4, 0.0, horizon, t)) return;
+
+    push({ now + t, SimEventType::BallBall, static_cast<uint8_t>(i), static_cast<uint8_t>(j), version[i], version[j] });
+}
+
+void Simulator::scheduleSingle(const SimTable& table, int i, double now) {
+    const Motion& m = motions[i];
+    if (m.stop <= 0.0) return;
+    // Always queued, even past maxTime, so a ball still rolling at the limit marks the run truncated
+    push({ now + m.stop, SimEventType::Stop, static_cast<uint8_t>(i), 0, version[i], 0 });
+
+    double horizon = m.stop;
+    if (now + horizon > params.maxTime) horizon = params.maxTime - now;
+    if (horizon <= 0.0) return;
+
+    const double radius = params.ballRadius;
+    const double reach = reachWithin(m, horizon);
+    const double speed = m.speed;
+    const double ux = m.ux, uy = m.uy;
+    const double pocketR2 = static_cast<double>(params.pocketRadius) * params.pocketRadius;
+    for (int k = 0; k < table.cushionCount; ++k) {
+        const SimCushion& e = table.cushions[k];
+        // Straight path: distance to the cushion line (minus one radius) over the approach rate
+        const double gap = e.nx * (m.x - e.x0) + e.ny * (m.y - e.y0) - radius;
+        const double approach = -(e.nx * ux + e.ny * uy);
+        if (approach <= 0.0) continue; // Parallel or leaving (e.g. right after a bounce)
+        const double distance = gap > 0.0 ? gap / approach : 0.0;
+        double t;
+        if (distance > reach || !timeToTravel(speed, params.rollingDecel, distance, t)) continue;
+
+        // Contact must fall on the segment (slightly extended so corners do not leak)
+        const double px = m.x + ux * distance;
+        const double py = m.y + uy * distance;
+        const double ex = e.x1 - e.x0, ey = e.y1 - e.y0;
+        const double length2 = ex * ex + ey * ey;
+        if (length2 <= 0.0) continue;
+        const double s = ((px - e.x0) * ex + (py - e.y0) * ey) / length2;
+        const double slack = radius / std::sqrt(length2);
+        if (s < -slack || s > 1.0 + slack) continue;
+
+        // No cushion across a pocket mouth
+        bool inMouth = false;
+        for (int p = 0; p < table.pocketCount && !inMouth; ++p) {
+            const double qx = px - table.pocketX[p], qy = py - table.pocketY[p];
+            inMouth = qx * qx + qy * qy <= pocketR2;
+        }
+        if (inMouth) continue;
+
+        push({ now + t, SimEventType::Cushion, static_cast<uint8_t>(i), static_cast<uint8_t>(k), version[i], 0 });
+    }
+
+    for (int p = 0; p < table.pocketCount; ++p) {
+        double distance, t;
+        const double qx = m.x - table.pocketX[p], qy = m.y - table.pocketY[p];
+        if (qx * qx + qy * qy <= pocketR2) t = 0.0;
+        else if (!rayCircle(m.x, m.y, ux, uy, table.pocketX[p], table.pocketY[p], params.pocketRadius, distance)
+                 || distance > reach || !timeToTravel(speed, params.rollingDecel, distance, t))
+            continue;
+        push({ now + t, SimEventType::Pocket, static_cast<uint8_t>(i), static_cast<uint8_t>(p), version[i], 0 });
+    }
+}
+
+void Simulator::scheduleAll(const SimState& state, const SimTable& table, double now) {
+    heapSize = 0;
+    heapOverflow = false;
+    updateMotions(state, now);
+    for (int i = 0; i < state.count; ++i) {
+        if (state.status[i] == SimBallStatus::Pocketed) continue;
+        scheduleSingle(table, i, now);
+        for (int j = i + 1; j < state.count; ++j)
+            if (state.status[j] != SimBallStatus::Pocketed) schedulePair(i, j, now);
+    }
+}
+
+void Simulator::push(const Event& e) {
+    if (heapSize == simMaxEvents) compactHeap();
+    if (heapSize == simMaxEvents) {
+        heapOverflow = true;
+        return;
+    }
+    int i = heapSize++;
+    while (i > 0) {
+        const int parent = (i - 1) / 2;
+        if (heap[parent].time <= e.time) break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = e;
+}
+
+Simulator::Event Simulator::pop() {
+    const Event top = heap[0];
+    const Event last = heap[--heapSize];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heapSize) break;
+        if (child + 1 < heapSize && heap[child + 1].time < heap[child].time) ++child;
+        if (last.time <= heap[child].time) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heapSize > 0) heap[i] = last;
+    return top;
+}
+
+// Drop events invalidated by a later change of either ball, then re-heapify
+void Simulator::compactHeap() {
+    int kept = 0;
+    for (int k = 0; k < heapSize; ++k) {
+        const Event& e = heap[k];
+        if (e.versionA != version[e.a]) continue;
+        if (e.type == SimEventType::BallBall && e.versionB != version[e.b]) continue;
+        heap[kept++] = e;
+    }
+    heapSize = kept;
+    for (int start = heapSize / 2 - 1; start >= 0; --start) {
+        const Event e = heap[start];
+        int i = start;
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= heapSize) break;
+            if (child + 1 < heapSize && heap[child + 1].time < heap[child].time) ++child;
+            if (e.time <= heap[child].time) break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = e;
+    }
+}
+
+void Simulator::advance(SimState& state, int i, double t) const {
+    if (state.status[i] == SimBallStatus::Pocketed) return;
+    const Motion m = motionAt(state, i, t);
+    state.x[i] = m.x;
+    state.y[i] = m.y;
+    state.vx[i] = m.vx;
+    state.vy[i] = m.vy;
+    state.t0[i] = t;
+    if (state.status[i] == SimBallStatus::Moving && m.stop <= 0.0) state.status[i] = SimBallStatus::Resting;
+}
+
+void Simulator::addPathPoint(const SimState& state, SimResult& result, int i, double t) const {
+    SimBallResult& ball = result.balls[i];
+    if (ball.pathCount == simMaxPathPoints) {
+        result.truncated = true;
+        return;
+    }
+    ball.path[ball.pathCount++] = { static_cast<float>(state.x[i]), static_cast<float>(state.y[i]), static_cast<float>(t) };
+}
+
+// A struck ball never leaves faster than the one that hit it, so no ball can travel further than
+// the longest remaining roll; if that is short of every pocket, nothing else can drop
+bool Simulator::outcomeDecided(const SimState& state, const SimTable& table, const SimResult& result) const {
+    if (result.firstHit < 0 && motions[0].stop > 0.0) return false;
+    if (params.rollingDecel <= 0.0f) return false;
+
+    double longestRoll = 0.0;
+    for (int i = 0; i < state.count; ++i)
+        if (motions[i].stop > 0.0) longestRoll = std::max(longestRoll, motions[i].speed * motions[i].speed / (2.0 * params.rollingDecel));
+    if (longestRoll == 0.0) return true;
+
+    const double reach = longestRoll + params.pocketRadius;
+    for (int i = 0; i < state.count; ++i) {
+        if (state.status[i] == SimBallStatus::Pocketed) continue;
+        for (int p = 0; p < table.pocketCount; ++p) {
+            const double dx = motions[i].x - table.pocketX[p], dy = motions[i].y - table.pocketY[p];
+            if (dx * dx + dy * dy < reach * reach) return false;
+        }
+    }
+    return true;
+}
+
+void Simulator::run(SimState& state, const SimTable& table, SimResult& result) {
+    CHETO_TRACE_SCOPE("simulate");
+    result.ballCount = state.count;
+    result.firstHit = -1;
+    result.scratch = false;
+    result.truncated = false;
+    result.events = 0;
+    result.endTime = 0.0;
+
+    for (int i = 0; i < state.count; ++i) {
+        version[i] = 0;
+        state.t0[i] = 0.0;
+        SimBallResult& ball = result.balls[i];
+        ball.pathCount = 0;
+        ball.pocketed = state.status[i] == SimBallStatus::Pocketed;
+        ball.pocket = -1;
+        addPathPoint(state, result, i, 0.0);
+    }
+
+    scheduleAll(state, table, 0.0);
+
+    double now = 0.0;
+    while (heapSize > 0) {
+        if (heapOverflow) {
+            // Lost an event: bring everyone to `now` and start from a clean queue
+            for (int i = 0; i < state.count; ++i) advance(state, i, now);
+            scheduleAll(state, table, now);
+            continue;
+        }
+
+        const Event e = pop();
+        if (e.versionA != version[e.a]) continue;
+        if (e.type == SimEventType::BallBall && e.versionB != version[e.b]) continue;
+        if (e.time > params.maxTime || result.events >= params.maxEvents) {
+            result.truncated = true;
+            break;
+        }
+        now = e.time;
+        ++result.events;
+
+        const int a = e.a;
+        advance(state, a, now);
+
+        switch (e.type) {
+        case SimEventType::Stop:
+            state.vx[a] = state.vy[a] = 0.0;
+            state.status[a] = SimBallStatus::Resting;
+            break;
+
+        case SimEventType::Cushion: {
+            const SimCushion& c = table.cushions[e.b];
+            const double vn = state.vx[a] * c.nx + state.vy[a] * c.ny;
+            if (vn < 0.0) {
+                const double k = (1.0 + params.cushionRestitution) * vn;
+                state.vx[a] -= k * c.nx;
+                state.vy[a] -= k * c.ny;
+            }
+            break;
+        }
+
+        case SimEventType::Pocket:
+            state.x[a] = table.pocketX[e.b];
+            state.y[a] = table.pocketY[e.b];
+            state.vx[a] = state.vy[a] = 0.0;
+            state.status[a] = SimBallStatus::Pocketed;
+            result.balls[a].pocketed = true;
+            result.balls[a].pocket = e.b;
+            if (a == 0) result.scratch = true;
+            break;
+
+        case SimEventType::BallBall: {
+            const int b = e.b;
+            advance(state, b, now);
+            double nx = state.x[b] - state.x[a];
+            double ny = state.y[b] - state.y[a];
+            const double length = std::sqrt(nx * nx + ny * ny);
+            if (length > 0.0) { nx /= length; ny /= length; }
+            // Equal masses: exchange the normal component, scaled by restitution
+            const double closing = (state.vx[a] - state.vx[b]) * nx + (state.vy[a] - state.vy[b]) * ny;
+            if (closing > 0.0) {
+                const double j = 0.5 * (1.0 + params.ballRestitution) * closing;
+                state.vx[a] -= j * nx;
+                state.vy[a] -= j * ny;
+                state.vx[b] += j * nx;
+                state.vy[b] += j * ny;
+            }
+            state.status[a] = (state.vx[a] != 0.0 || state.vy[a] != 0.0) ? SimBallStatus::Moving : SimBallStatus::Resting;
+            state.status[b] = (state.vx[b] != 0.0 || state.vy[b] != 0.0) ? SimBallStatus::Moving : SimBallStatus::Resting;
+            if (result.firstHit < 0 && (a == 0 || b == 0)) result.firstHit = a == 0 ? b : a;
+
+            ++version[b];
+            addPathPoint(state, result, b, now);
+            break;
+        }
+        }
+
+        ++version[a];
+        addPathPoint(state, result, a, now);
+
+        // Reschedule the balls whose motion changed against everything else
+        updateMotions(state, now);
+        if (params.outcomeOnly && outcomeDecided(state, table, result)) break;
+        const int b = e.type == SimEventType::BallBall ? e.b : -1;
+        if (state.status[a] != SimBallStatus::Pocketed) {
+            scheduleSingle(table, a, now);
+            for (int j = 0; j < state.count; ++j)
+                if (j != a && j != b && state.status[j] != SimBallStatus::Pocketed) schedulePair(a, j, now);
+        }
+        if (b >= 0) {
+            scheduleSingle(table, b, now);
+            schedulePair(a, b, now);
+            for (int j = 0; j < state.count; ++j)
+                if (j != a && j != b && state.status[j] != SimBallStatus::Pocketed) schedulePair(b, j, now);
+        }
+    }
+
+    result.endTime = now;
+    for (int i = 0; i < state.count; ++i) {
+        advance(state, i, now);
+        SimBallResult& ball = result.balls[i];
+        ball.finalX = static_cast<float>(state.x[i]);
+        ball.finalY = static_cast<float>(state.y[i]);
+        const SimPathPoint& last = ball.path[ball.pathCount - 1];
+        if (last.x != ball.finalX || last.y != ball.finalY) addPathPoint(state, result, i, now);
+    }
+}
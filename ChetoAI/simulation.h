@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+
+// Event-driven pool simulation. Plain float/double structs, fixed capacities,
+// no OpenCV and no allocation per call, so it can sit in per-frame and batch
+// (sweep / Monte Carlo) loops. Units are whatever the caller uses for positions
+// (overlay pixels in ChetoAI), seconds for time.
+//
+// Between events every ball moves in a straight line with constant rolling
+// deceleration, so positions are closed-form quadratics in time and every
+// event time is a polynomial root:
+//   ball-ball: |dp + dv t + da t^2 / 2| = 2R   (quartic)
+//   cushion:   n . (p(t) - edge) = R            (quadratic)
+//   pocket:    |p(t) - pocket| = pocketRadius   (quartic)
+//   stop:      |v| / decel                      (closed form)
+
+constexpr int simMaxBalls = 16;
+constexpr int simMaxCushions = 32;
+constexpr int simMaxPockets = 6;
+constexpr int simMaxPathPoints = 48;
+constexpr int simMaxEvents = 1024;
+
+struct SimParams {
+    float ballRadius = 12.0f;
+    float pocketRadius = 20.0f;        // Ball center within this of a pocket center = pocketed
+    float rollingDecel = 300.0f;       // Rolling friction, units/s^2
+    float ballRestitution = 0.95f;
+    float cushionRestitution = 0.75f;
+    double maxTime = 20.0;             // Give up after this much simulated time
+    int maxEvents = 512;
+    // Stop as soon as the outcome is decided: the cue ball's first contact is known and no
+    // ball can reach a pocket any more. Final positions are then not at rest. For sweeps.
+    bool outcomeOnly = false;
+};
+
+// One straight cushion segment; the normal points into the table
+struct SimCushion {
+    float x0, y0, x1, y1;
+    float nx, ny;
+};
+
+struct SimTable {
+    int cushionCount = 0;
+    SimCushion cushions[simMaxCushions];
+    int pocketCount = 0;
+    float pocketX[simMaxPockets];
+    float pocketY[simMaxPockets];
+
+    // Axis-aligned play area (cushion lines) with pockets at the given points
+    static SimTable rectangle(float minX, float minY, float maxX, float maxY,
+                              const float* pocketX = nullptr, const float* pocketY = nullptr, int pocketCount = 0);
+};
+
+enum class SimBallStatus : uint8_t { Resting, Moving, Pocketed };
+
+// Structure-of-arrays ball state; ball 0 is the cue ball by convention
+struct SimState {
+    int count = 0;
+    double x[simMaxBalls];
+    double y[simMaxBalls];
+    double vx[simMaxBalls];
+    double vy[simMaxBalls];
+    double t0[simMaxBalls];            // Time at which x/y/vx/vy are valid
+    SimBallStatus status[simMaxBalls];
+
+    int add(float px, float py, float pvx = 0.0f, float pvy = 0.0f);
+};
+
+enum class SimEventType : uint8_t { BallBall, Cushion, Pocket, Stop };
+
+struct SimPathPoint {
+    float x, y;
+    float t;
+};
+
+struct SimBallResult {
+    int pathCount = 0;                 // Polyline of the ball's centre, one point per direction change
+    SimPathPoint path[simMaxPathPoints];
+    bool pocketed = false;
+    int pocket = -1;
+    float finalX = 0.0f, finalY = 0.0f;
+};
+
+struct SimResult {
+    int ballCount = 0;
+    SimBallResult balls[simMaxBalls];
+    int firstHit = -1;                 // First ball the cue ball touched, -1 if none
+    bool scratch = false;              // Cue ball pocketed
+    bool truncated = false;            // Hit maxEvents / maxTime / a path capacity
+    int events = 0;
+    double endTime = 0.0;
+};
+
+// Reusable simulator: keeps its event heap between runs, so run() never allocates.
+class Simulator {
+public:
+    explicit Simulator(const SimParams& params = SimParams()) : params(params) {}
+
+    // Rolls `state` forward until every ball is at rest, pocketed, or a limit is hit.
+    // `state` is left at the final positions.
+    void run(SimState& state, const SimTable& table, SimResult& result);
+
+    SimParams& settings() { return params; }
+    const SimParams& settings() const { return params; }
+
+private:
+    struct Event {
+        double time;
+        SimEventType type;
+        uint8_t a;
+        uint8_t b;                     // Other ball, cushion or pocket index
+        uint32_t versionA;
+        uint32_t versionB;
+    };
+
+    struct Motion {
+        double x, y, vx, vy, ax, ay;
+        double speed, ux, uy;          // |v| and its direction
+        double stop;                   // Time from `now` until the ball rests (0 if resting)
+    };
+
+    Motion motionAt(const SimState& state, int i, double now) const;
+    void updateMotions(const SimState& state, double now);
+    bool outcomeDecided(const SimState& state, const SimTable& table, const SimResult& result) const;
+    double reachWithin(const Motion& m, double horizon) const;
+    void schedulePair(int i, int j, double now);
+    void scheduleSingle(const SimTable& table, int i, double now);
+    void scheduleAll(const SimState& state, const SimTable& table, double now);
+    void push(const Event& e);
+    Event pop();
+    void compactHeap();
+    void advance(SimState& state, int i, double t) const;
+    void addPathPoint(const SimState& state, SimResult& result, int i, double t) const;
+
+    SimParams params;
+    Event heap[simMaxEvents];
+    int heapSize = 0;
+    bool heapOverflow = false;
+    uint32_t version[simMaxBalls] = {};
+    Motion motions[simMaxBalls];       // Every ball at the current event time
+};
+
+// Smallest root of c[0] + c[1] t + ... + c[degree] t^degree in (lo, hi] where the
+// polynomial changes sign (tangential touches are ignored). degree <= 4.
+bool smallestRoot(const double* c, int degree, double lo, double hi, double& root);
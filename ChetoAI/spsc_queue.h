@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free single-producer / single-consumer ring buffer.
+// Capacity must be a power of two. push() and pop() never block; the caller
+// decides whether to retry, drop, or skip ahead with popLatest().
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and leaves `item` untouched) when full.
+    bool push(T&& item) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) >= Capacity) return false;
+        slots[tail & (Capacity - 1)] = std::move(item);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T& out) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false;
+        out = std::move(slots[head & (Capacity - 1)]);
+        slots[head & (Capacity - 1)] = T();
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Drains the queue and keeps only the newest item.
+    // `dropped` (optional) receives how many older items were discarded.
+    bool popLatest(T& out, size_t* dropped = nullptr) {
+        size_t skipped = 0;
+        bool got = false;
+        while (pop(out)) {
+            if (got) ++skipped;
+            got = true;
+        }
+        if (dropped) *dropped = skipped;
+        return got;
+    }
+
+    size_t sizeApprox() const {
+        return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    // Separate cache lines so producer and consumer do not false-share
+    alignas(64) std::atomic<size_t> headIndex{ 0 };
+    alignas(64) std::atomic<size_t> tailIndex{ 0 };
+    alignas(64) T slots[Capacity];
+};
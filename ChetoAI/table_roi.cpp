@@ -0,0 +1,194 @@
+#include "table_roi.h"
+#include "onnx_inference.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Highest-confidence PlayArea detection, or nullptr
+const Detection* findPlayArea(const std::vector<Detection>& detections) {
+    const Detection* best = nullptr;
+    for (const auto& det : detections)
+        if (det.type == ObjectType::PlayArea && (!best || det.confidence > best->confidence)) best = &det;
+    return best;
+}
+
+float squaredDistance(const cv::Point2f& a, const cv::Point2f& b) {
+    const float dx = a.x - b.x;
+    const float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+} // namespace
+
+TableRoiTracker::TableRoiTracker(ONNXInference& detector, TableRoiConfig config)
+    : detector(detector), config(config) {
+}
+
+void TableRoiTracker::reset() {
+    isLocked = false;
+    rectified = false;
+    missedFrames = 0;
+    framesSinceLock = 0;
+}
+
+std::vector<Detection> TableRoiTracker::run(const cv::Mat& frame) {
+    const bool relockDue = config.relockInterval > 0 && framesSinceLock >= config.relockInterval;
+    if (!isLocked || relockDue || frame.cols < roiRect.br().x || frame.rows < roiRect.br().y)
+        return runFullFrame(frame);
+    return runLocked(frame);
+}
+
+std::vector<Detection> TableRoiTracker::runOther(ONNXInference& model, const cv::Mat& frame) const {
+    const cv::Rect roi = isLocked ? roiRect & cv::Rect(0, 0, frame.cols, frame.rows) : cv::Rect();
+    if (roi.area() == 0) return model.runInference(frame);
+    std::vector<Detection> detections = model.runInference(frame(roi));
+    for (Detection& det : detections) {
+        det.box.x += roi.x;
+        det.box.y += roi.y;
+    }
+    return detections;
+}
+
+std::vector<Detection> TableRoiTracker::runFullFrame(const cv::Mat& frame) {
+    CHETO_TRACE_SCOPE("roi.fullFrame");
+    if (config.matchInputAspect) detector.setInputSize(detector.closestInputSize(frame.size()));
+    std::vector<Detection> detections = detector.runInference(frame);
+    ++counters.fullFrames;
+    tryLock(detections, frame.size());
+    return detections;
+}
+
+void TableRoiTracker::tryLock(const std::vector<Detection>& detections, cv::Size frameSize) {
+    const bool wasLocked = isLocked;
+    isLocked = false;
+    rectified = false;
+
+    const Detection* table = findPlayArea(detections);
+    if (!table || table->confidence < config.lockConfidence) return;
+
+    const cv::Rect& box = table->box;
+    const int padX = static_cast<int>(std::lround(box.width * config.padding));
+    const int padY = static_cast<int>(std::lround(box.height * config.padding));
+    cv::Rect padded(box.x - padX, box.y - padY, box.width + 2 * padX, box.height + 2 * padY);
+    padded &= cv::Rect(0, 0, frameSize.width, frameSize.height);
+    if (padded.width < 32 || padded.height < 32) return;
+
+    roiRect = padded;
+    isLocked = true;
+    missedFrames = 0;
+    framesSinceLock = 0;
+    if (!wasLocked) ++counters.locks;
+
+    cv::Point2f pockets[4];
+    if (config.rectify && findCornerPockets(detections, box, pockets)) {
+        // Corner pockets land on the padded rectangle's inner corners, so the
+        // crop keeps the same margin around the cushions as the axis-aligned mode
+        const float w = static_cast<float>(roiRect.width);
+        const float h = static_cast<float>(roiRect.height);
+        const float mx = w * config.padding / (1.0f + 2.0f * config.padding);
+        const float my = h * config.padding / (1.0f + 2.0f * config.padding);
+        const cv::Point2f target[4] = {
+            { mx, my }, { w - mx, my }, { w - mx, h - my }, { mx, h - my }
+        };
+        toRectified = cv::getPerspectiveTransform(pockets, target);
+        fromRectified = cv::getPerspectiveTransform(target, pockets);
+        rectified = true;
+    }
+}
+
+bool TableRoiTracker::findCornerPockets(const std::vector<Detection>& detections, const cv::Rect& table,
+                                        cv::Point2f corners[4]) const {
+    const cv::Point2f boxCorners[4] = {
+        { (float)table.x, (float)table.y },
+        { (float)(table.x + table.width), (float)table.y },
+        { (float)(table.x + table.width), (float)(table.y + table.height) },
+        { (float)table.x, (float)(table.y + table.height) }
+    };
+    // A corner pocket has to be clearly closer to its corner than to the side pockets
+    const float maxDistance = 0.25f * std::min(table.width, table.height);
+    const float maxDistanceSq = maxDistance * maxDistance;
+
+    const Detection* used[4] = {};
+    for (int c = 0; c < 4; ++c) {
+        float bestSq = maxDistanceSq;
+        for (const auto& det : detections) {
+            if (det.type != ObjectType::Hole) continue;
+            cv::Point2f center(det.box.x + det.box.width * 0.5f, det.box.y + det.box.height * 0.5f);
+            float d = squaredDistance(center, boxCorners[c]);
+            if (d < bestSq) {
+                bestSq = d;
+                corners[c] = center;
+                used[c] = &det;
+            }
+        }
+        if (!used[c]) return false;
+        for (int prev = 0; prev < c; ++prev)
+            if (used[prev] == used[c]) return false;
+    }
+    return true;
+}
+
+std::vector<Detection> TableRoiTracker::runLocked(const cv::Mat& frame) {
+    CHETO_TRACE_SCOPE("roi.locked");
+    ++framesSinceLock;
+    ++counters.roiFrames;
+
+    std::vector<Detection> detections;
+    cv::Size cropSize = roiRect.size();
+    if (config.matchInputAspect) detector.setInputSize(detector.closestInputSize(cropSize));
+    if (rectified) {
+        cv::warpPerspective(frame, rectifiedFrame, toRectified, cropSize, cv::INTER_LINEAR);
+        detections = detector.runInference(rectifiedFrame);
+    }
+    else {
+        detections = detector.runInference(frame(roiRect)); // View, no copy
+    }
+
+    // Judge the lock in crop coordinates: a table touching a crop edge inside the frame has moved
+    const Detection* table = findPlayArea(detections);
+    bool keep = table && table->confidence >= config.keepConfidence;
+    if (keep && !rectified) {
+        keep = !touchesInnerCropEdge(table->box, roiRect, frame.size());
+        if (keep && touchesFrameBorder(table->box, roiRect, frame.size())) ++counters.atFrameBorder;
+    }
+    missedFrames = keep ? 0 : missedFrames + 1;
+
+    if (rectified) {
+        mapRectified(detections, frame.size());
+    }
+    else {
+        for (auto& det : detections) {
+            det.box.x += roiRect.x;
+            det.box.y += roiRect.y;
+        }
+    }
+
+    if (missedFrames >= config.maxMissedFrames) {
+        isLocked = false;
+        ++counters.lostLocks;
+    }
+    return detections;
+}
+
+// Box corners through the inverse homography; the box becomes their bounding
+// rect. Masks stay in the rectified box's frame.
+void TableRoiTracker::mapRectified(std::vector<Detection>& detections, cv::Size frameSize) const {
+    std::vector<cv::Point2f> corners(4 * detections.size());
+    for (size_t i = 0; i < detections.size(); ++i) {
+        const cv::Rect& b = detections[i].box;
+        corners[4 * i + 0] = cv::Point2f((float)b.x, (float)b.y);
+        corners[4 * i + 1] = cv::Point2f((float)(b.x + b.width), (float)b.y);
+        corners[4 * i + 2] = cv::Point2f((float)(b.x + b.width), (float)(b.y + b.height));
+        corners[4 * i + 3] = cv::Point2f((float)b.x, (float)(b.y + b.height));
+    }
+    if (corners.empty()) return;
+    cv::perspectiveTransform(corners, corners, fromRectified);
+
+    const cv::Rect frameRect(0, 0, frameSize.width, frameSize.height);
+    for (size_t i = 0; i < detections.size(); ++i) {
+        std::vector<cv::Point2f> quad(corners.begin() + 4 * i, corners.begin() + 4 * i + 4);
+        detections[i].box = cv::boundingRect(quad) & frameRect;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+
+class ONNXInference;
+
+struct TableRoiConfig {
+    float padding = 0.06f;        // Added on each side, as a fraction of the table size
+    float lockConfidence = 0.6f;  // PlayArea confidence needed to lock from a full frame
+    float keepConfidence = 0.4f;  // Below this (or missing) counts as a miss while locked
+    int maxMissedFrames = 3;      // Consecutive misses before falling back to full frame
+    int relockInterval = 300;     // Forced full-frame pass every N frames; 0 = never
+    bool rectify = false;         // Warp the four corner pockets to a rectangle
+    bool matchInputAspect = true; // With several model input sizes, use the one closest to the crop's aspect
+};
+
+struct TableRoiStats {
+    uint64_t fullFrames = 0;
+    uint64_t roiFrames = 0;
+    uint64_t locks = 0;
+    uint64_t lostLocks = 0;       // Fallbacks caused by low confidence / table moving
+    uint64_t atFrameBorder = 0;   // Crop frames where the table lay on a crop edge that is the frame border
+};
+
+// Whether `table` (crop pixels) touches an edge of `crop` (frame pixels) that lies inside the frame.
+// A crop edge clipped to the frame border does not count: a table against the border of a
+// borderless game window or a window crop always touches it without having moved.
+inline bool touchesInnerCropEdge(const cv::Rect& table, const cv::Rect& crop, cv::Size frameSize) {
+    return (table.x <= 0 && crop.x > 0)
+        || (table.y <= 0 && crop.y > 0)
+        || (table.x + table.width >= crop.width && crop.x + crop.width < frameSize.width)
+        || (table.y + table.height >= crop.height && crop.y + crop.height < frameSize.height);
+}
+
+// Whether `table` touches a crop edge that is also the frame border (the case touchesInnerCropEdge ignores)
+inline bool touchesFrameBorder(const cv::Rect& table, const cv::Rect& crop, cv::Size frameSize) {
+    return (table.x <= 0 && crop.x <= 0)
+        || (table.y <= 0 && crop.y <= 0)
+        || (table.x + table.width >= crop.width && crop.x + crop.width >= frameSize.width)
+        || (table.y + table.height >= crop.height && crop.y + crop.height >= frameSize.height);
+}
+
+// Runs inference on the whole frame until the play area is found, then only on
+// a padded crop around it (optionally perspective-rectified from the pockets).
+// Detections are always returned in frame pixels, so processDetections() and
+// the overlay do not care which mode produced them.
+class TableRoiTracker {
+public:
+    explicit TableRoiTracker(ONNXInference& detector, TableRoiConfig config = {});
+
+    std::vector<Detection> run(const cv::Mat& frame);
+    // Another model (e.g. the cascade's fast one) on the plain table crop once locked, else on the
+    // whole frame. Does not move the lock; boxes come back in frame pixels
+    std::vector<Detection> runOther(ONNXInference& model, const cv::Mat& frame) const;
+
+    void reset();                        // Next frame is a full-frame pass
+    bool locked() const { return isLocked; }
+    cv::Rect roi() const { return roiRect; }
+    const TableRoiStats& stats() const { return counters; }
+    TableRoiConfig& settings() { return config; }
+
+private:
+    std::vector<Detection> runFullFrame(const cv::Mat& frame);
+    std::vector<Detection> runLocked(const cv::Mat& frame);
+    void tryLock(const std::vector<Detection>& detections, cv::Size frameSize);
+    bool findCornerPockets(const std::vector<Detection>& detections, const cv::Rect& table, cv::Point2f corners[4]) const;
+    void mapRectified(std::vector<Detection>& detections, cv::Size frameSize) const;
+
+    ONNXInference& detector;
+    TableRoiConfig config;
+    TableRoiStats counters;
+
+    bool isLocked = false;
+    cv::Rect roiRect;
+    int missedFrames = 0;
+    int framesSinceLock = 0;
+
+    bool rectified = false;
+    cv::Mat toRectified;    // Frame -> rectified crop (3x3)
+    cv::Mat fromRectified;  // Rectified crop -> frame
+    cv::Mat rectifiedFrame; // Reused warp target
+};
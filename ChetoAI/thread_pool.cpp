@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+#include "trace.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads < 0) threads = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for (int i = 0; i <= threads; ++i) queues.push_back(std::make_unique<WorkerQueue>());
+    for (int i = 1; i <= threads; ++i) this->threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+bool WorkStealingPool::takeChunk(int worker, Chunk& chunk) {
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.head < own.tail) {
+            chunk = own.chunks[own.head++];
+            return true;
+        }
+    }
+    const int n = workerCount();
+    for (int k = 1; k < n; ++k) {
+        WorkerQueue& victim = *queues[(worker + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.head < victim.tail) {
+            chunk = victim.chunks[--victim.tail];
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::runChunks(int worker, const RangeFn& fn) {
+    Chunk chunk;
+    while (takeChunk(worker, chunk)) fn(chunk.begin, chunk.end, worker);
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    CHETO_TRACE_THREAD("pool worker");
+    uint64_t seen = 0;
+    for (;;) {
+        const RangeFn* fn;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return stopping || jobGeneration != seen; });
+            if (stopping) return;
+            seen = jobGeneration;
+            fn = job;
+        }
+        runChunks(worker, *fn);
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if (--activeWorkers == 0) jobDone.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::parallelFor(int count, int grain, const RangeFn& fn) {
+    if (count <= 0) return;
+    grain = std::max(1, grain);
+    std::lock_guard<std::mutex> call(callMutex);
+
+    // Contiguous chunks dealt round-robin: neighbouring chunks (similar cost) land on different workers
+    const int n = workerCount();
+    for (auto& q : queues) {
+        q->chunks.clear();
+        q->head = 0;
+    }
+    int chunkIndex = 0;
+    for (int begin = 0; begin < count; begin += grain, ++chunkIndex)
+        queues[chunkIndex % n]->chunks.push_back({ begin, std::min(count, begin + grain) });
+    for (auto& q : queues) q->tail = static_cast<int>(q->chunks.size());
+
+    if (n == 1 || chunkIndex == 1) {
+        runChunks(0, fn);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        job = &fn;
+        activeWorkers = n - 1;
+        ++jobGeneration;
+    }
+    jobReady.notify_all();
+    runChunks(0, fn);
+
+    // Workers may still be finishing a chunk (or not have woken yet); fn must outlive them
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [&] { return activeWorkers == 0; });
+    job = nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor() cuts the
+// range into chunks dealt round-robin to per-worker queues; a worker that runs
+// dry steals from the back of another worker's queue, so uneven chunks (a long
+// multi-collision rollout next to a miss) still balance. The calling thread
+// works as worker 0, so a pool of N threads has N + 1 workers.
+class WorkStealingPool {
+public:
+    // fn(begin, end, worker): process [begin, end); worker is in [0, workerCount())
+    using RangeFn = std::function<void(int begin, int end, int worker)>;
+
+    explicit WorkStealingPool(int threads = -1); // -1 = hardware threads - 1
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int workerCount() const { return static_cast<int>(queues.size()); }
+
+    // Blocks until every chunk has run. One call at a time.
+    void parallelFor(int count, int grain, const RangeFn& fn);
+
+private:
+    struct Chunk {
+        int begin;
+        int end;
+    };
+    // head/tail index into chunks; the owner pops at head, thieves take from tail
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Chunk> chunks;
+        int head = 0;
+        int tail = 0;
+    };
+
+    bool takeChunk(int worker, Chunk& chunk);
+    void runChunks(int worker, const RangeFn& fn);
+    void workerLoop(int worker);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex callMutex;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const RangeFn* job = nullptr;
+    uint64_t jobGeneration = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,123 @@
+#include "trace.h"
+
+#if defined(CHETO_TRACING)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Single writer (the owning thread), any number of readers. The writer only
+// publishes the write index; readers copy the newest min(count, capacity)
+// events. Rings are owned by the registry so they outlive their threads.
+struct TraceRing {
+    TraceEvent events[traceRingCapacity];
+    std::atomic<uint64_t> written{ 0 };
+    uint64_t currentFrame = 0;
+    uint32_t threadIndex = 0;
+    char threadName[32] = {};
+};
+
+struct TraceRegistry {
+    std::mutex mutex; // Only taken when a thread records its first event, and on export
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+TraceRing& localRing() {
+    thread_local TraceRing* ring = nullptr;
+    if (!ring) {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.push_back(std::make_unique<TraceRing>());
+        ring = reg.rings.back().get();
+        ring->threadIndex = static_cast<uint32_t>(reg.rings.size());
+        std::snprintf(ring->threadName, sizeof(ring->threadName), "thread %u", ring->threadIndex);
+    }
+    return *ring;
+}
+
+void writeJsonString(std::FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') std::fputc('\\', file);
+        if (static_cast<unsigned char>(*c) >= 0x20) std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+uint64_t traceNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().epoch).count());
+}
+
+void traceRecord(const char* name, uint64_t startNs, uint64_t endNs) {
+    TraceRing& ring = localRing();
+    const uint64_t index = ring.written.load(std::memory_order_relaxed);
+    TraceEvent& e = ring.events[index & (traceRingCapacity - 1)];
+    e.name = name;
+    e.startNs = startNs;
+    e.durationNs = endNs > startNs ? endNs - startNs : 0;
+    e.frameId = ring.currentFrame;
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void traceSetFrame(uint64_t frameId) {
+    localRing().currentFrame = frameId;
+}
+
+void traceSetThreadName(const char* name) {
+    TraceRing& ring = localRing();
+    std::snprintf(ring.threadName, sizeof(ring.threadName), "%s", name);
+}
+
+bool traceWriteChromeJson(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    for (const auto& ring : reg.rings) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",\n", ring->threadIndex);
+        writeJsonString(file, ring->threadName);
+        std::fputs("}}", file);
+        first = false;
+
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > traceRingCapacity ? written - traceRingCapacity : 0;
+        for (uint64_t i = begin; i < written; ++i) {
+            const TraceEvent e = ring->events[i & (traceRingCapacity - 1)];
+            std::fputs(",\n{\"name\":", file);
+            writeJsonString(file, e.name);
+            std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+                ring->threadIndex, e.startNs / 1000.0, e.durationNs / 1000.0, (unsigned long long)e.frameId);
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
+
+#else
+
+uint64_t traceNowNs() { return 0; }
+void traceRecord(const char*, uint64_t, uint64_t) {}
+void traceSetFrame(uint64_t) {}
+void traceSetThreadName(const char*) {}
+bool traceWriteChromeJson(const std::string&) { return false; }
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Hot-path tracing. Build with CHETO_TRACING defined to record scoped timers
+// into per-thread lock-free rings; without it every macro below expands to
+// nothing and no tracing code is generated at the call sites.
+//
+//   CHETO_TRACE_THREAD("inference");     // Once per thread, names the track
+//   CHETO_TRACE_FRAME(packet.frameId);   // Tag following events with a frame ID
+//   { CHETO_TRACE_SCOPE("session.Run"); session->Run(...); }
+//
+// traceWriteChromeJson() dumps everything recorded so far in Chrome trace
+// event format (chrome://tracing, ui.perfetto.dev).
+
+// Events kept per thread; older ones are overwritten
+constexpr uint32_t traceRingCapacity = 1u << 16;
+
+struct TraceEvent {
+    const char* name;   // Must be a string literal (or otherwise outlive the trace)
+    uint64_t startNs;   // Since process trace epoch
+    uint64_t durationNs;
+    uint64_t frameId;
+};
+
+uint64_t traceNowNs();
+void traceRecord(const char* name, uint64_t startNs, uint64_t endNs);
+void traceSetFrame(uint64_t frameId);
+void traceSetThreadName(const char* name);
+
+// Write all rings as Chrome trace JSON. Returns false if tracing is compiled
+// out or the file cannot be written. Meant to be called once recording threads
+// have stopped; events written concurrently may be skipped.
+bool traceWriteChromeJson(const std::string& path);
+
+constexpr bool traceEnabled() {
+#if defined(CHETO_TRACING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(CHETO_TRACING)
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), startNs(traceNowNs()) {}
+    ~TraceScope() { traceRecord(name, startNs, traceNowNs()); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#define CHETO_TRACE_CONCAT_INNER(a, b) a##b
+#define CHETO_TRACE_CONCAT(a, b) CHETO_TRACE_CONCAT_INNER(a, b)
+#define CHETO_TRACE_SCOPE(name) TraceScope CHETO_TRACE_CONCAT(chetoTraceScope_, __LINE__)(name)
+#define CHETO_TRACE_FRAME(id) traceSetFrame(static_cast<uint64_t>(id))
+#define CHETO_TRACE_THREAD(name) traceSetThreadName(name)
+
+#else
+
+#define CHETO_TRACE_SCOPE(name) ((void)0)
+#define CHETO_TRACE_FRAME(id) ((void)0)
+#define CHETO_TRACE_THREAD(name) ((void)0)
+
+#endif
@@ -0,0 +1,174 @@
+#include "tracker.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+bool isBall(ObjectType type) {
+    return type == ObjectType::Ball || type == ObjectType::White;
+}
+
+cv::Point2f boxCenter(const cv::Rect& box) {
+    return cv::Point2f(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+}
+
+float boxRadius(const cv::Rect& box) {
+    return std::min(box.width, box.height) * 0.5f;
+}
+
+} // namespace
+
+void AxisFilter::init(float z, float measurementVar, float velocityVar) {
+    position = z;
+    velocity = 0.0f;
+    p00 = measurementVar;
+    p01 = 0.0f;
+    p11 = velocityVar;
+}
+
+// x' = F x, P' = F P F^T + Q with F = [1 dt; 0 1] and white-noise acceleration Q
+void AxisFilter::predict(float dt, float accelerationVar) {
+    position += velocity * dt;
+    const float dt2 = dt * dt;
+    p00 += dt * (2.0f * p01 + dt * p11) + accelerationVar * dt2 * dt2 * 0.25f;
+    p01 += dt * p11 + accelerationVar * dt2 * dt * 0.5f;
+    p11 += accelerationVar * dt2;
+}
+
+void AxisFilter::correct(float z, float measurementVar) {
+    const float s = p00 + measurementVar;
+    const float k0 = p00 / s;
+    const float k1 = p01 / s;
+    const float innovation = z - position;
+    position += k0 * innovation;
+    velocity += k1 * innovation;
+    p11 -= k1 * p01;
+    p01 *= 1.0f - k0;
+    p00 *= 1.0f - k0;
+}
+
+BallTracker::BallTracker(TrackerConfig config)
+    : config(config) {
+}
+
+void BallTracker::reset() {
+    tracks.clear();
+    hasUpdate = false;
+    nextId = 0;
+}
+
+void BallTracker::update(const std::vector<Detection>& detections, double time) {
+    CHETO_TRACE_SCOPE("tracker");
+    const float dt = hasUpdate ? static_cast<float>(std::max(0.0, time - lastUpdate)) : 0.0f;
+    lastUpdate = time;
+    hasUpdate = true;
+
+    const float measurementVar = config.measurementNoise * config.measurementNoise;
+    const float accelerationVar = config.accelerationNoise * config.accelerationNoise;
+
+    for (auto& t : tracks) {
+        t.x.predict(dt, accelerationVar);
+        t.y.predict(dt, accelerationVar);
+    }
+
+    ballDetections.clear();
+    for (int i = 0; i < static_cast<int>(detections.size()); ++i)
+        if (isBall(detections[i].type)) ballDetections.push_back(i);
+
+    // Gated pairwise costs (squared distance in gate units), then greedy lowest-cost-first
+    candidates.clear();
+    for (int ti = 0; ti < static_cast<int>(tracks.size()); ++ti) {
+        const Track& t = tracks[ti];
+        const float gate = config.gateRadii * std::max(t.state.radius, 1.0f)
+            + std::sqrt(t.x.velocity * t.x.velocity + t.y.velocity * t.y.velocity) * dt;
+        for (int di = 0; di < static_cast<int>(ballDetections.size()); ++di) {
+            const Detection& det = detections[ballDetections[di]];
+            if (det.type != t.state.type) continue;
+            const cv::Point2f c = boxCenter(det.box);
+            const float dx = c.x - t.x.position;
+            const float dy = c.y - t.y.position;
+            const float d2 = dx * dx + dy * dy;
+            if (d2 <= gate * gate) candidates.push_back({ d2 / (gate * gate), ti, di });
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+    trackUsed.assign(tracks.size(), 0);
+    detectionUsed.assign(ballDetections.size(), 0);
+    for (const Candidate& c : candidates) {
+        if (trackUsed[c.track] || detectionUsed[c.detection]) continue;
+        trackUsed[c.track] = 1;
+        detectionUsed[c.detection] = 1;
+
+        Track& t = tracks[c.track];
+        const Detection& det = detections[ballDetections[c.detection]];
+        const cv::Point2f z = boxCenter(det.box);
+        t.x.correct(z.x, measurementVar);
+        t.y.correct(z.y, measurementVar);
+        t.state.radius += 0.3f * (boxRadius(det.box) - t.state.radius);
+        ++t.state.hits;
+        t.state.misses = 0;
+        t.state.lastSeen = time;
+    }
+
+    // Unmatched tracks age out; unmatched detections start new tentative tracks
+    for (size_t ti = 0; ti < trackUsed.size(); ++ti)
+        if (!trackUsed[ti]) ++tracks[ti].state.misses;
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this, time](const Track& t) {
+        return t.state.misses > config.maxMisses
+            || (t.state.misses > 0 && time - t.state.lastSeen > config.maxCoastSeconds);
+    }), tracks.end());
+
+    for (size_t di = 0; di < ballDetections.size(); ++di) {
+        if (detectionUsed[di]) continue;
+        const Detection& det = detections[ballDetections[di]];
+        const cv::Point2f z = boxCenter(det.box);
+        const float radius = boxRadius(det.box);
+        Track t;
+        t.state.id = nextId++;
+        t.state.type = det.type;
+        t.state.radius = radius;
+        t.state.hits = 1;
+        t.state.lastSeen = time;
+        // Unknown initial velocity: allow about one ball diameter per frame at 30 fps
+        const float velocityVar = (radius * 60.0f) * (radius * 60.0f);
+        t.x.init(z.x, measurementVar, velocityVar);
+        t.y.init(z.y, measurementVar, velocityVar);
+        tracks.push_back(t);
+    }
+
+    for (auto& t : tracks) {
+        t.state.center = cv::Point2f(t.x.position, t.y.position);
+        t.state.velocity = cv::Point2f(t.x.velocity, t.y.velocity);
+    }
+}
+
+void BallTracker::predictAt(double time, std::vector<TrackedBall>& out) const {
+    out.clear();
+    for (const auto& t : tracks) {
+        if (t.state.hits < config.minHits) continue;
+        TrackedBall ball = t.state;
+        if (!ball.moving(config.stillSpeed)) {
+            out.push_back(ball); // Filter noise on a resting ball must not make it creep
+            continue;
+        }
+        const double ahead = std::min(std::max(0.0, time + config.latencyCompensation - lastUpdate),
+                                      config.maxCoastSeconds);
+        ball.center += ball.velocity * static_cast<float>(ahead);
+        out.push_back(ball);
+    }
+}
+
+const TrackedBall* BallTracker::find(int id) const {
+    for (const auto& t : tracks)
+        if (t.state.id == id) return &t.state;
+    return nullptr;
+}
+
+bool BallTracker::anyMoving() const {
+    for (const auto& t : tracks)
+        if (t.state.hits >= config.minHits && t.state.moving(config.stillSpeed)) return true;
+    return false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+
+struct TrackerConfig {
+    float gateRadii = 3.0f;         // Max association distance, in ball radii (plus the predicted motion)
+    int minHits = 2;                // Detections before a track is reported
+    int maxMisses = 5;              // Consecutive updates without a match before a track is dropped
+    double maxCoastSeconds = 0.25;  // Longest extrapolation past the last measurement
+    float measurementNoise = 2.0f;  // Detector center jitter, pixels (1 sigma)
+    float accelerationNoise = 800.0f; // Unmodelled acceleration, pixels/s^2 (1 sigma)
+    float stillSpeed = 40.0f;       // Below this (pixels/s) a ball counts as at rest and is not extrapolated
+    double latencyCompensation = 0.0; // Seconds added to every predictAt time: display delay after the
+                                      // render stage (present, scan-out), so the drawn balls match the screen
+};
+
+// Constant-velocity Kalman filter for one axis: state (position, velocity).
+// With per-axis diagonal noise the 4-state 2D filter separates exactly into two of these.
+struct AxisFilter {
+    float position = 0.0f;
+    float velocity = 0.0f;
+    float p00 = 0.0f, p01 = 0.0f, p11 = 0.0f; // Covariance
+
+    void init(float z, float measurementVar, float velocityVar);
+    void predict(float dt, float accelerationVar);
+    void correct(float z, float measurementVar);
+};
+
+struct TrackedBall {
+    int id = -1;
+    ObjectType type = ObjectType::Ball;  // Ball or White
+    cv::Point2f center;                  // Frame pixels
+    cv::Point2f velocity;                // Frame pixels per second
+    float radius = 0.0f;
+    int hits = 0;
+    int misses = 0;
+    double lastSeen = 0.0;               // Time of the last matched detection, seconds
+
+    bool moving(float stillSpeed) const { return velocity.dot(velocity) > stillSpeed * stillSpeed; }
+};
+
+// Gives every detected ball a persistent ID across frames and smooths its
+// position. Association is greedy on gated center distance (same class only);
+// with at most 16 balls that is both cheap and, in practice, what the
+// Hungarian assignment would pick. Tracks coast on their velocity through
+// frames where inference is skipped or late.
+class BallTracker {
+public:
+    explicit BallTracker(TrackerConfig config = {});
+
+    // detections: one frame's output (frame pixels); time: when that frame was captured, seconds
+    void update(const std::vector<Detection>& detections, double time);
+
+    // Confirmed tracks extrapolated to `time` (e.g. now, for display) plus latencyCompensation.
+    // Coasting is capped. A time at or before (last update - latencyCompensation) gives the filtered
+    // positions unmoved.
+    void predictAt(double time, std::vector<TrackedBall>& out) const;
+
+    const TrackedBall* find(int id) const;
+    bool anyMoving() const;
+    void reset();
+    TrackerConfig& settings() { return config; }
+
+private:
+    struct Track {
+        TrackedBall state;
+        AxisFilter x;
+        AxisFilter y;
+    };
+    struct Candidate {
+        float cost;
+        int track;
+        int detection;
+    };
+
+    TrackerConfig config;
+    std::vector<Track> tracks;
+    std::vector<Candidate> candidates;       // Scratch, reused between updates
+    std::vector<unsigned char> trackUsed;
+    std::vector<unsigned char> detectionUsed;
+    std::vector<int> ballDetections;
+    double lastUpdate = 0.0;
+    bool hasUpdate = false;
+    int nextId = 0;
+};
@@ -0,0 +1,190 @@
+#include "yolo_decode.h"
+#include "detection.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+inline void pushCandidate(const float* output, int numAnchors, int anchor, int classId, float score,
+                          std::vector<DecodedBox>& out) {
+    const float cx = output[0 * numAnchors + anchor];
+    const float cy = output[1 * numAnchors + anchor];
+    const float w = output[2 * numAnchors + anchor];
+    const float h = output[3 * numAnchors + anchor];
+    out.push_back({ cx - w * 0.5f, cy - h * 0.5f, cx + w * 0.5f, cy + h * 0.5f, score, classId, anchor });
+}
+
+// Argmax over classes for anchors [start, numAnchors)
+void collectScalar(const float* output, int numAnchors, const DecodeParams& params, int start,
+                   std::vector<DecodedBox>& out) {
+    const float* scores = output + 4 * numAnchors;
+    for (int i = start; i < numAnchors; ++i) {
+        float best = scores[i];
+        int bestClass = 0;
+        for (int c = 1; c < params.numClasses; ++c) {
+            float s = scores[c * numAnchors + i];
+            if (s > best) {
+                best = s;
+                bestClass = c;
+            }
+        }
+        if (best > params.confThreshold) pushCandidate(output, numAnchors, i, bestClass, best, out);
+    }
+}
+
+#if defined(CHETO_SIMD_X86)
+void collectSSE(const float* output, int numAnchors, const DecodeParams& params, std::vector<DecodedBox>& out) {
+    const float* scores = output + 4 * numAnchors;
+    const __m128 threshold = _mm_set1_ps(params.confThreshold);
+    alignas(16) float bestScores[4];
+    alignas(16) int bestClasses[4];
+    int i = 0;
+    for (; i + 4 <= numAnchors; i += 4) {
+        __m128 best = _mm_loadu_ps(scores + i);
+        __m128i bestIdx = _mm_setzero_si128();
+        for (int c = 1; c < params.numClasses; ++c) {
+            __m128 v = _mm_loadu_ps(scores + c * numAnchors + i);
+            __m128i gt = _mm_castps_si128(_mm_cmpgt_ps(v, best));
+            best = _mm_max_ps(v, best);
+            bestIdx = _mm_or_si128(_mm_and_si128(gt, _mm_set1_epi32(c)), _mm_andnot_si128(gt, bestIdx));
+        }
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(best, threshold));
+        if (!mask) continue; // Early out: most anchors are background
+        _mm_store_ps(bestScores, best);
+        _mm_store_si128(reinterpret_cast<__m128i*>(bestClasses), bestIdx);
+        for (int lane = 0; lane < 4; ++lane)
+            if (mask & (1 << lane))
+                pushCandidate(output, numAnchors, i + lane, bestClasses[lane], bestScores[lane], out);
+    }
+    collectScalar(output, numAnchors, params, i, out);
+}
+
+CHETO_TARGET_AVX2 void collectAVX2(const float* output, int numAnchors, const DecodeParams& params,
+                                   std::vector<DecodedBox>& out) {
+    const float* scores = output + 4 * numAnchors;
+    const __m256 threshold = _mm256_set1_ps(params.confThreshold);
+    alignas(32) float bestScores[8];
+    alignas(32) int bestClasses[8];
+    int i = 0;
+    for (; i + 8 <= numAnchors; i += 8) {
+        __m256 best = _mm256_loadu_ps(scores + i);
+        __m256 bestIdx = _mm256_castsi256_ps(_mm256_setzero_si256());
+        for (int c = 1; c < params.numClasses; ++c) {
+            __m256 v = _mm256_loadu_ps(scores + c * numAnchors + i);
+            __m256 gt = _mm256_cmp_ps(v, best, _CMP_GT_OQ);
+            best = _mm256_max_ps(v, best);
+            bestIdx = _mm256_blendv_ps(bestIdx, _mm256_castsi256_ps(_mm256_set1_epi32(c)), gt);
+        }
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(best, threshold, _CMP_GT_OQ));
+        if (!mask) continue;
+        _mm256_store_ps(bestScores, best);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(bestClasses), _mm256_castps_si256(bestIdx));
+        for (int lane = 0; lane < 8; ++lane)
+            if (mask & (1 << lane))
+                pushCandidate(output, numAnchors, i + lane, bestClasses[lane], bestScores[lane], out);
+    }
+    collectScalar(output, numAnchors, params, i, out);
+}
+#endif
+
+inline float iou(const DecodedBox& a, const DecodedBox& b) {
+    const float ix = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    const float iy = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (ix <= 0.0f || iy <= 0.0f) return 0.0f;
+    const float inter = ix * iy;
+    const float areaA = (a.x2 - a.x1) * (a.y2 - a.y1);
+    const float areaB = (b.x2 - b.x1) * (b.y2 - b.y1);
+    return inter / (areaA + areaB - inter);
+}
+
+} // namespace
+
+void collectCandidates(const float* output, int numAnchors, const DecodeParams& params,
+                       std::vector<DecodedBox>& out) {
+    if (params.numClasses <= 0 || numAnchors <= 0) return;
+#if defined(CHETO_SIMD_X86)
+    switch (activeSimdLevel()) {
+    case SimdLevel::AVX2:
+        collectAVX2(output, numAnchors, params, out);
+        return;
+    case SimdLevel::SSE:
+        collectSSE(output, numAnchors, params, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    collectScalar(output, numAnchors, params, 0, out);
+}
+
+void nonMaxSuppression(std::vector<DecodedBox>& boxes, const DecodeParams& params,
+                       std::vector<DecodedBox>& kept, std::vector<unsigned char>& scratch) {
+    kept.clear();
+    if (boxes.empty()) return;
+
+    // Group by class (unless agnostic), highest score first inside each group
+    const bool agnostic = params.classAgnosticNms;
+    std::sort(boxes.begin(), boxes.end(), [agnostic](const DecodedBox& a, const DecodedBox& b) {
+        if (!agnostic && a.classId != b.classId) return a.classId < b.classId;
+        return a.score > b.score;
+    });
+
+    scratch.assign(boxes.size(), 0);
+    const size_t count = boxes.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (scratch[i]) continue;
+        const DecodedBox& keep = boxes[i];
+        kept.push_back(keep);
+
+        for (size_t j = i + 1; j < count; ++j) {
+            if (!agnostic && boxes[j].classId != keep.classId) break; // End of this class group
+            if (!scratch[j] && iou(keep, boxes[j]) > params.iouThreshold) scratch[j] = 1;
+        }
+    }
+
+    if (static_cast<int>(kept.size()) > params.maxDetections) {
+        std::partial_sort(kept.begin(), kept.begin() + params.maxDetections, kept.end(),
+            [](const DecodedBox& a, const DecodedBox& b) { return a.score > b.score; });
+        kept.resize(params.maxDetections);
+    }
+}
+
+void YoloDecoder::decode(const float* output, int numChannels, int numAnchors,
+                         const DecodeParams& params, std::vector<Detection>& detections) {
+    detections.clear();
+    candidates.clear();
+    if (!output || numChannels < 4 + params.numClasses + params.numMaskCoeffs) return;
+
+    collectCandidates(output, numAnchors, params, candidates);
+    nonMaxSuppression(candidates, params, kept, suppressed);
+
+    detections.reserve(kept.size());
+    for (const DecodedBox& b : kept) {
+        const float x1 = b.x1 * params.scaleX + params.offsetX;
+        const float y1 = b.y1 * params.scaleY + params.offsetY;
+        const float x2 = b.x2 * params.scaleX + params.offsetX;
+        const float y2 = b.y2 * params.scaleY + params.offsetY;
+
+        Detection det;
+        det.box = cv::Rect(
+            static_cast<int>(std::lround(x1)),
+            static_cast<int>(std::lround(y1)),
+            static_cast<int>(std::lround(x2 - x1)),
+            static_cast<int>(std::lround(y2 - y1)));
+        det.confidence = b.score;
+        det.class_id = b.classId;
+        det.anchor = b.anchor;
+        det.type = (b.classId >= 0 && b.classId < static_cast<int>(ObjectType::Unknown))
+            ? static_cast<ObjectType>(b.classId) : ObjectType::Unknown;
+        detections.push_back(det);
+    }
+}
+
+std::vector<Detection> decodeYoloOutput(const float* output, int numChannels, int numAnchors,
+                                        const DecodeParams& params) {
+    YoloDecoder decoder;
+    std::vector<Detection> detections;
+    decoder.decode(output, numChannels, numAnchors, params, detections);
+    return detections;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+struct Detection;
+
+// Decode settings for a YOLO detection head laid out as [1, 4 + C + M, N]
+// (channel-major: every channel stores N anchors contiguously).
+struct DecodeParams {
+    int numClasses = 0;        // C
+    int numMaskCoeffs = 0;     // M (32 for -seg models, 0 for plain detection)
+    float confThreshold = 0.5f;
+    float iouThreshold = 0.45f;
+    bool classAgnosticNms = false;
+    int maxDetections = 300;
+
+    // Model input pixels -> output pixels: out = in * scale + offset
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+};
+
+// Candidate box in model input coordinates (corner form)
+struct DecodedBox {
+    float x1, y1, x2, y2;
+    float score;
+    int classId;
+    int anchor; // Column in the output tensor (indexes mask coefficients)
+};
+
+// Reusable decoder; keeps its scratch buffers between frames.
+class YoloDecoder {
+public:
+    void decode(const float* output, int numChannels, int numAnchors,
+                const DecodeParams& params, std::vector<Detection>& detections);
+
+    // Candidates from the last decode() that survived NMS, in model coordinates
+    const std::vector<DecodedBox>& keptBoxes() const { return kept; }
+
+private:
+    std::vector<DecodedBox> candidates;
+    std::vector<DecodedBox> kept;
+    std::vector<unsigned char> suppressed;
+};
+
+// Thresholded class argmax over all anchors; appends to `out`.
+void collectCandidates(const float* output, int numAnchors, const DecodeParams& params,
+                       std::vector<DecodedBox>& out);
+
+// Greedy NMS, per class unless params.classAgnosticNms. Sorts `boxes` in place.
+void nonMaxSuppression(std::vector<DecodedBox>& boxes, const DecodeParams& params,
+                       std::vector<DecodedBox>& kept, std::vector<unsigned char>& scratch);
+
+// Standalone decode of a recorded output tensor (allocates; for tools and benchmarks).
+std::vector<Detection> decodeYoloOutput(const float* output, int numChannels, int numAnchors,
+                                        const DecodeParams& params);
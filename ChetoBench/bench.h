@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Timing summary for one benchmark case, in microseconds
+struct BenchResult {
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double minUs = 0.0;
+};
+
+template <typename Fn>
+BenchResult measure(Fn&& fn, int iterations, int warmup = 3) {
+    for (int i = 0; i < warmup; ++i) fn();
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    BenchResult result;
+    if (samples.empty()) return result;
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples) total += s;
+    result.meanUs = total / samples.size();
+    result.p50Us = samples[samples.size() / 2];
+    result.p95Us = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    result.minUs = samples.front();
+    return result;
+}
+
+inline void printResult(const char* label, const BenchResult& r) {
+    std::printf("  %-34s mean %9.1f us  p50 %9.1f us  p95 %9.1f us  min %9.1f us\n",
+        label, r.meanUs, r.p50Us, r.p95Us, r.minUs);
+}
+
+// Behaviour checks: each prints one ok/FAIL line, and any failure makes ChetoBench exit non-zero
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline bool check(const char* name, bool ok, double got, double want) {
+    if (!ok) ++checkFailures();
+    std::printf("  %-34s %s  (got %.3f, want %.3f)\n", name, ok ? "ok  " : "FAIL", got, want);
+    return ok;
+}
+
+// |got - want| <= tolerance
+inline bool checkNear(const char* name, double got, double want, double tolerance) {
+    return check(name, std::fabs(got - want) <= tolerance, got, want);
+}
+
+// Heap allocations so far in this process (operator new is replaced in bench_physics.cpp).
+// Only counts this module's C++ allocations, not what a DLL such as onnxruntime does inside.
+long long heapAllocations();
+
+// Benchmark entry points (one per bench_*.cpp)
+void runPreprocessBenchmark();
+void runDecodeBenchmark();
+void runSimulationBenchmark();
+void runSweepBenchmark();
+void runRankingBenchmark();
+void runPhysicsBenchmark();
+void runCushionBenchmark();
+void runMotionBenchmark();
+void runEnsembleBenchmark();
+void runCacheBenchmark();
+void runInferenceBenchmark();
+void runPrecisionBenchmark();
+void runResolutionBenchmark();
+void runCascadeBenchmark();
+void runOverlayBenchmark();
+void runCaptureBenchmark();
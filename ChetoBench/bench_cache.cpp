@@ -0,0 +1,193 @@
+#include "bench.h"
+#include "physics_cache.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+static bool sameGuide(const GuideBuffer& a, const GuideBuffer& b) {
+    return a.count == b.count && std::memcmp(a.segments, b.segments, a.count * sizeof(GuideSegment)) == 0;
+}
+
+// Cue ball, target and 14 more balls on a 1400x700 table in overlay space
+struct CacheScene {
+    GuideTable table;
+    SimState layout;
+    float radius = 14.0f;
+
+    GuideBall ball(int i) const {
+        return { static_cast<float>(layout.x[i]), static_cast<float>(layout.y[i]), radius };
+    }
+    GuidePoint ghost() const {
+        const GuideBall cue = ball(0), target = ball(1);
+        return Physics::computeGhostBall(cue, target);
+    }
+};
+
+static CacheScene makeScene() {
+    CacheScene scene;
+    scene.table.hasBounds = true;
+    scene.table.minX = 260.0f;
+    scene.table.minY = 140.0f;
+    scene.table.maxX = 1660.0f;
+    scene.table.maxY = 840.0f;
+    const float pocketX[] = { 260.0f, 960.0f, 1660.0f, 260.0f, 960.0f, 1660.0f };
+    const float pocketY[] = { 140.0f, 135.0f, 140.0f, 840.0f, 845.0f, 840.0f };
+    for (int p = 0; p < 6; ++p) scene.table.pockets[scene.table.pocketCount++] = { pocketX[p], pocketY[p] };
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> x(300.0f, 1620.0f), y(180.0f, 800.0f);
+    scene.layout.add(600.0f, 500.0f);
+    while (scene.layout.count < 16) {
+        const float px = x(rng), py = y(rng);
+        bool clear = true;
+        for (int i = 0; i < scene.layout.count; ++i)
+            clear = clear && std::hypot(px - scene.layout.x[i], py - scene.layout.y[i]) > 2.5 * scene.radius;
+        if (clear) scene.layout.add(px, py);
+    }
+    return scene;
+}
+
+// One frame of main's physics: rollout toward the ghost ball, guideline, ensemble on the target
+struct FrameWork {
+    Simulator simulator;
+    ShotEnsemble ensemble;
+    SimResult result;
+    GuideBuffer guide, path;
+    ShotUncertainty uncertainty;
+
+    EnsembleShot shot(const CacheScene& s) const {
+        EnsembleShot e;
+        e.cueX = static_cast<float>(s.layout.x[0]);
+        e.cueY = static_cast<float>(s.layout.y[0]);
+        e.objectX = static_cast<float>(s.layout.x[1]);
+        e.objectY = static_cast<float>(s.layout.y[1]);
+        e.cueRadius = e.objectRadius = s.radius;
+        e.cueNoise = e.objectNoise = { 1.4f, 1.0f };
+        const GuidePoint aim = s.ghost();
+        e.aimX = aim.x;
+        e.aimY = aim.y;
+        e.pocketX = s.table.pockets[2].x;
+        e.pocketY = s.table.pockets[2].y;
+        return e;
+    }
+    void direct(const CacheScene& s) {
+        simulateShot(s.layout, s.radius, s.table, s.ghost(), simulatedShotSpeed, simulator, result, path);
+        calculateGuideline(s.ball(0), s.ball(1), s.table, guide);
+        ensemble.evaluate(shot(s), uncertainty);
+    }
+    void cached(const CacheScene& s, PhysicsCache& cache) {
+        cache.rollout(s.layout, s.radius, s.table, s.ghost(), simulatedShotSpeed, simulator);
+        cache.guideline(s.ball(0), s.ball(1), s.table);
+        cache.uncertainty(ensemble, shot(s));
+    }
+};
+
+void runCacheBenchmark() {
+    CacheScene scene = makeScene();
+    FrameWork work;
+    PhysicsCache cache;
+    std::printf("cache: %.0f KB fixed (16 guides, 8 rollouts, 32 ensembles, 2 sweeps)\n", cache.bytes() / 1024.0);
+
+    // Same inputs: the second call is a hit and returns exactly what was computed
+    {
+        work.direct(scene);
+        const GuideBuffer& first = cache.guideline(scene.ball(0), scene.ball(1), scene.table);
+        const bool firstHit = cache.lastHit();
+        const GuideBuffer& second = cache.guideline(scene.ball(0), scene.ball(1), scene.table);
+        check("repeat guideline is a hit", !firstHit && cache.lastHit() && &first == &second, cache.lastHit(), 1);
+        check("cached guideline == direct", sameGuide(second, work.guide), second.count, work.guide.count);
+        const CachedRollout& rollout = cache.rollout(scene.layout, scene.radius, scene.table, scene.ghost(),
+            simulatedShotSpeed, work.simulator);
+        check("cached rollout == direct", rollout.valid && sameGuide(rollout.path, work.path), rollout.path.count,
+            work.path.count);
+    }
+    // Sub-quantum jitter reuses; a ball moving elsewhere only invalidates what depends on it
+    {
+        CacheScene jittered = scene;
+        jittered.layout.x[0] += 0.05;
+        cache.guideline(jittered.ball(0), jittered.ball(1), jittered.table);
+        check("0.05 px jitter reuses the guideline", cache.lastHit(), cache.lastHit(), 1);
+
+        CacheScene moved = scene;
+        moved.layout.x[7] += 30.0;
+        cache.guideline(moved.ball(0), moved.ball(1), moved.table);
+        const bool guideHit = cache.lastHit();
+        cache.rollout(moved.layout, moved.radius, moved.table, moved.ghost(), simulatedShotSpeed, work.simulator);
+        check("other ball moved: guideline kept", guideHit, guideHit, 1);
+        check("other ball moved: rollout redone", !cache.lastHit(), cache.lastHit(), 0);
+        cache.rollout(scene.layout, scene.radius, scene.table, scene.ghost(), simulatedShotSpeed, work.simulator);
+        check("moved back: old rollout still cached", cache.lastHit(), cache.lastHit(), 1);
+        // Coming back with jitter, not to the exact coordinate, is still a hit: the grid is fixed
+        moved = scene;
+        moved.layout.x[7] += 30.0;
+        cache.rollout(moved.layout, moved.radius, moved.table, moved.ghost(), simulatedShotSpeed, work.simulator);
+        const double quantum = PhysicsCacheConfig().quantum;
+        const double centre = std::floor(scene.layout.x[7] / quantum + 0.5) * quantum;
+        moved.layout.x[7] = scene.layout.x[7] + (centre > scene.layout.x[7] ? 0.07 : -0.07);
+        cache.rollout(moved.layout, moved.radius, moved.table, moved.ghost(), simulatedShotSpeed, work.simulator);
+        check("moved back with 0.07 px jitter: hit", cache.lastHit(), cache.lastHit(), 1);
+
+        moved = scene;
+        moved.layout.y[1] += 30.0;
+        cache.guideline(moved.ball(0), moved.ball(1), moved.table);
+        check("target moved: guideline redone", !cache.lastHit(), cache.lastHit(), 0);
+    }
+    // LRU: filling past capacity drops the least recently used entry, not the one just touched
+    {
+        PhysicsCacheConfig small;
+        small.guideEntries = 4;
+        PhysicsCache lru(small);
+        auto line = [&](int i) {
+            CacheScene s = scene;
+            s.layout.x[1] += 10.0 * i;
+            lru.guideline(s.ball(0), s.ball(1), s.table);
+            return lru.lastHit();
+        };
+        for (int i = 0; i < 4; ++i) line(i);
+        line(0);                       // 0 becomes most recent; 1 is now the oldest
+        line(4);                       // Evicts 1
+        const bool kept = line(0), dropped = !line(1);
+        check("LRU keeps recent, evicts oldest", kept && dropped && lru.guideStats().evictions >= 1,
+            static_cast<double>(lru.guideStats().evictions), 2);
+    }
+
+    // Cost of a frame: computed vs answered from the cache
+    cache.clear();
+    printResult("frame, direct", measure([&] { work.direct(scene); }, 2000));
+    printResult("frame, cache hit", measure([&] { work.cached(scene, cache); }, 2000));
+
+    // Replay-like sequence: the balls sit still with +-0.1 px jitter, and every 30th frame one
+    // ball rolls somewhere else. Half of those moves are the cue ball or the target
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<double> jitter(-0.1, 0.1), jump(-40.0, 40.0);
+    std::uniform_int_distribution<int> pick(0, 3);
+    std::uniform_int_distribution<int> other(2, 15);
+    const int frames = 3000;
+    std::vector<CacheScene> sequence;
+    CacheScene rest = scene;
+    for (int f = 0; f < frames; ++f) {
+        if (f % 30 == 29) {
+            const int which = pick(rng) < 2 ? pick(rng) % 2 : other(rng);
+            rest.layout.x[which] += jump(rng);
+            rest.layout.y[which] += jump(rng);
+        }
+        CacheScene frame = rest;
+        for (int i = 0; i < frame.layout.count; ++i) {
+            frame.layout.x[i] += jitter(rng);
+            frame.layout.y[i] += jitter(rng);
+        }
+        sequence.push_back(frame);
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const CacheScene& s : sequence) work.direct(s);
+    const auto t1 = std::chrono::steady_clock::now();
+    PhysicsCache replay;
+    for (const CacheScene& s : sequence) work.cached(s, replay);
+    const auto t2 = std::chrono::steady_clock::now();
+    const double directUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+    const double cachedUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / frames;
+    std::printf("  %d-frame sequence: %.1f us/frame direct, %.1f us/frame cached (%.1fx)\n", frames, directUs,
+        cachedUs, directUs / cachedUs);
+    std::printf("  hit rate: guideline %.2f, rollout %.2f, ensemble %.2f; %llu evictions\n",
+        replay.guideStats().hitRate(), replay.rolloutStats().hitRate(), replay.ensembleStats().hitRate(),
+        (unsigned long long)replay.totals().evictions);
+}
@@ -0,0 +1,164 @@
+#include "bench.h"
+#include "frame_pool.h"
+#include "pipeline.h"
+#include <cstring>
+#include <thread>
+
+// Stands in for desktop capture: renders BGRA frames into pooled buffers and hands out views, the
+// way DxgiFrameSource does with its mapped staging textures. Each frame carries its number in its
+// first pixels (of the crop), so a consumer can tell whether the buffer was overwritten under it.
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource(int width, int height, cv::Rect crop, int buffers, uint64_t frames)
+        : width(width), height(height), crop(crop), frames(frames), pool(buffers) {}
+
+    CaptureStatus grab(cv::Mat& image) override {
+        image.release();
+        lease.reset();
+        if (next >= frames) return CaptureStatus::EndOfStream;
+        lease = pool.acquire();
+        if (!lease) return CaptureStatus::NoFrame;
+        cv::Mat& frame = lease.image();
+        frame.create(height, width, CV_8UC4);
+        // A moving block stands in for the GPU copy; only its area is touched
+        const int x = static_cast<int>(next * 7 % static_cast<uint64_t>(width - 64));
+        frame(cv::Rect(x, height / 2, 64, 64)).setTo(cv::Scalar(255.0, 128.0, 0.0, 255.0));
+        image = frame(crop);
+        std::memcpy(image.ptr(0), &next, sizeof(next));
+        ++next;
+        return CaptureStatus::Frame;
+    }
+    std::string describe() const override { return "synthetic"; }
+    FrameLease lastLease() const override { return lease; }
+
+    const FramePool& buffers() const { return pool; }
+
+private:
+    int width, height;
+    cv::Rect crop;
+    uint64_t frames;
+    uint64_t next = 0;
+    FramePool pool;
+    FrameLease lease;
+};
+
+static uint64_t stampOf(const cv::Mat& image) {
+    uint64_t stamp;
+    std::memcpy(&stamp, image.ptr(0), sizeof(stamp));
+    return stamp;
+}
+
+struct PipelineRun {
+    uint64_t rendered = 0;
+    uint64_t overwritten = 0;        // Frames whose pixels changed while inference held them
+    uint64_t outOfOrder = 0;
+    PipelineStats stats;
+};
+
+// Pushes `source` through the real pipeline; inference holds each frame for `holdUs`
+static PipelineRun runPipeline(SyntheticSource& source, bool dropStale, int holdUs) {
+    PipelineRun run;
+    std::atomic<uint64_t> overwritten{ 0 };
+    uint64_t lastId = 0;
+    PipelineConfig config;
+    config.dropStale = dropStale;
+    FramePipeline pipeline(
+        [&source](cv::Mat& image, FrameChanges& changes, FrameLease& lease) {
+            CaptureStatus status = source.grab(image);
+            changes = source.lastChanges();
+            lease = source.lastLease();
+            return status;
+        },
+        [&](const FramePacket& frame, DetectionPacket&) {
+            const uint64_t before = stampOf(frame.image);
+            std::this_thread::sleep_for(std::chrono::microseconds(holdUs));
+            if (before != frame.frameId || stampOf(frame.image) != frame.frameId) overwritten.fetch_add(1);
+        },
+        [&](const DetectionPacket& packet) {
+            if (run.rendered > 0 && packet.frameId <= lastId) ++run.outOfOrder;
+            lastId = packet.frameId;
+            ++run.rendered;
+        },
+        config);
+    pipeline.start();
+    while (!pipeline.finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pipeline.stop();
+    run.overwritten = overwritten.load();
+    run.stats = pipeline.stats();
+    return run;
+}
+
+void runCaptureBenchmark() {
+    // Lease lifetime: copies share a slot, the last one out frees it, a full pool says so
+    {
+        FramePool pool(2);
+        FrameLease a = pool.acquire();
+        FrameLease b = pool.acquire();
+        const bool exhausted = !pool.acquire();
+        FrameLease copy = a;
+        a.reset();
+        const bool heldByCopy = pool.held(copy.slot());
+        FrameLease moved = std::move(copy);
+        const bool stillHeld = pool.held(moved.slot()) && !copy;
+        moved.reset();
+        b = FrameLease();
+        check("full pool hands out no lease", exhausted && pool.stats().exhausted == 1,
+            static_cast<double>(pool.stats().exhausted), 1);
+        check("copy keeps slot, last release frees", heldByCopy && stillHeld && pool.inUse() == 0, pool.inUse(), 0);
+        check("lowest free slot is reused", pool.acquire().slot() == 0, 0, 0);
+    }
+
+    // A consumer done before the next grab leaves one buffer cycling, and no allocation per frame
+    {
+        SyntheticSource source(1920, 1080, cv::Rect(0, 0, 1920, 1080), 4, 1000);
+        cv::Mat frame;
+        source.grab(frame);
+        const unsigned char* first = frame.data;
+        int moved = 0;
+        const long long allocationsBefore = heapAllocations();
+        for (int i = 0; i < 999; ++i) {
+            source.grab(frame);
+            if (frame.data != first) ++moved;
+        }
+        const long long allocations = heapAllocations() - allocationsBefore;
+        check("sequential grabs reuse one buffer", moved == 0 && source.buffers().stats().peakInUse == 1, moved, 0);
+        check("no heap allocation per grab", allocations == 0, static_cast<double>(allocations), 0);
+    }
+
+    // Through the pipeline: no frame is overwritten while leased, none is lost in order-preserving
+    // mode, and every buffer is free again once the stream has drained
+    {
+        const cv::Rect window(160, 90, 1600, 900);
+        SyntheticSource ordered(1920, 1080, window, 4, 300);
+        const PipelineRun run = runPipeline(ordered, false, 300);
+        check("ordered: every frame, in order", run.rendered == 300 && run.outOfOrder == 0,
+            static_cast<double>(run.rendered), 300);
+        check("ordered: no frame overwritten", run.overwritten == 0, static_cast<double>(run.overwritten), 0);
+        check("ordered: pool back-pressure", ordered.buffers().stats().exhausted > 0
+            && ordered.buffers().stats().peakInUse <= 4, ordered.buffers().stats().peakInUse, 4);
+        check("ordered: all buffers released", ordered.buffers().inUse() == 0, ordered.buffers().inUse(), 0);
+
+        SyntheticSource live(1920, 1080, window, pipelineFramesInFlight, 3000);
+        const PipelineRun dropped = runPipeline(live, true, 300);
+        check("live: no frame overwritten", dropped.overwritten == 0, static_cast<double>(dropped.overwritten), 0);
+        check("live: all buffers released", live.buffers().inUse() == 0, live.buffers().inUse(), 0);
+        std::printf("  live: %llu captured, %llu inferred, %llu dropped; %d of %d buffers at peak, %llu waits\n",
+            (unsigned long long)dropped.stats.captured, (unsigned long long)dropped.stats.inferred,
+            (unsigned long long)dropped.stats.droppedBeforeInference, live.buffers().stats().peakInUse,
+            live.buffers().size(), (unsigned long long)live.buffers().stats().exhausted);
+    }
+
+    // What the capture stage used to do after mapping (clone the frame, then clone the window
+    // crop) against handing on a view of the pooled buffer
+    cv::Mat mapped(1080, 1920, CV_8UC4);
+    mapped.setTo(cv::Scalar(40.0, 90.0, 20.0, 255.0));
+    const cv::Rect window(160, 90, 1600, 900);
+    cv::Mat out;
+    printResult("1080p BGRA, clone + crop clone", measure([&] { out = mapped.clone()(window).clone(); }, 200));
+    FramePool pool(2);
+    printResult("1080p BGRA, pooled view", measure([&] {
+        FrameLease lease = pool.acquire();
+        lease.image() = mapped;
+        out = lease.image()(window);
+    }, 200));
+}
@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "cushions.h"
+#include <cmath>
+#include <random>
+
+// Six pockets of a 1400x700 table at (260, 140) in overlay space
+static Table makeTable(float shift) {
+    Table table;
+    table.bounds = cv::Rect(260 + static_cast<int>(shift), 140, 1400, 700);
+    const float pocketX[] = { 260.0f, 960.0f, 1660.0f, 260.0f, 960.0f, 1660.0f };
+    const float pocketY[] = { 140.0f, 140.0f, 140.0f, 840.0f, 840.0f, 840.0f };
+    for (int p = 0; p < 6; ++p) table.pockets.push_back(cv::Point2f(pocketX[p] + shift, pocketY[p]));
+    return table;
+}
+
+void runCushionBenchmark() {
+    // Bank angles on a plain 1000x500 box: a 45 degree shot mirrors off bottom then right
+    {
+        const float xs[] = { 0.0f, 1000.0f, 1000.0f, 0.0f }, ys[] = { 0.0f, 0.0f, 500.0f, 500.0f };
+        CushionTable box;
+        box.build(xs, ys, 4, nullptr, nullptr, 0, CushionSource::Box);
+        BankPath path;
+        box.trace(500.0f, 250.0f, 1.0f, 1.0f, 10.0f, 2, 5000.0f, path);
+        check("first bank at (740, 490)", path.pointCount == 4 && std::abs(path.x[1] - 740.0f) < 0.01f
+            && std::abs(path.y[1] - 490.0f) < 0.01f, path.x[1], 740.0);
+        check("second bank at (990, 240)", std::abs(path.x[2] - 990.0f) < 0.01f && std::abs(path.y[2] - 240.0f) < 0.01f,
+            path.y[2], 240.0);
+        check("stops on third cushion (760, 10)", std::abs(path.x[3] - 760.0f) < 0.01f && std::abs(path.y[3] - 10.0f) < 0.01f
+            && path.bounces == 2, path.x[3], 760.0);
+    }
+
+    // Mask-like outline: 24 sides, a pocket at every fourth corner. The grid must agree with
+    // testing every edge
+    const int sides = 24;
+    float xs[sides], ys[sides], pocketX[6], pocketY[6];
+    for (int i = 0; i < sides; ++i) {
+        const float a = 6.2831853f * i / sides;
+        const float r = 1.0f + 0.05f * std::sin(5.0f * a);
+        xs[i] = 960.0f + 700.0f * r * std::cos(a);
+        ys[i] = 540.0f + 350.0f * r * std::sin(a);
+        if (i % 4 == 0) {
+            pocketX[i / 4] = xs[i];
+            pocketY[i / 4] = ys[i];
+        }
+    }
+    CushionConfig bruteConfig;
+    bruteConfig.spatialIndex = false;
+    CushionTable indexed, brute(bruteConfig);
+    indexed.build(xs, ys, sides, pocketX, pocketY, 6, CushionSource::Mask);
+    brute.build(xs, ys, sides, pocketX, pocketY, 6, CushionSource::Mask);
+    std::printf("outline: %d sides, %d edges after pocket gaps\n", sides, indexed.size());
+
+    const int rays = 4096;
+    std::vector<float> startX(rays), startY(rays), dirX(rays), dirY(rays);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> x(500.0f, 1400.0f), y(350.0f, 700.0f), angle(0.0f, 6.2831853f);
+    for (int i = 0; i < rays; ++i) {
+        startX[i] = x(rng);
+        startY[i] = y(rng);
+        const float a = angle(rng);
+        dirX[i] = std::cos(a);
+        dirY[i] = std::sin(a);
+    }
+    int mismatches = 0, pocketed = 0;
+    BankPath a, b;
+    for (int i = 0; i < rays; ++i) {
+        indexed.trace(startX[i], startY[i], dirX[i], dirY[i], 14.0f, 4, 8000.0f, a);
+        brute.trace(startX[i], startY[i], dirX[i], dirY[i], 14.0f, 4, 8000.0f, b);
+        const int last = a.pointCount - 1;
+        if (a.pointCount != b.pointCount || a.pocket != b.pocket || std::abs(a.x[last] - b.x[last]) > 0.01f
+            || std::abs(a.y[last] - b.y[last]) > 0.01f)
+            ++mismatches;
+        if (a.pocket >= 0) ++pocketed;
+    }
+    check("grid == every edge, 4 banks", mismatches == 0, mismatches, 0);
+    std::printf("  %d of %d random 4-bank rays end in a pocket\n", pocketed, rays);
+
+    for (int bounces : { 0, 1, 4 }) {
+        for (const CushionTable* table : { &indexed, &brute }) {
+            char label[64];
+            std::snprintf(label, sizeof(label), "%d rays, %d bank%s, %s", rays, bounces, bounces == 1 ? "" : "s",
+                table == &indexed ? "grid" : "all edges");
+            BankPath path;
+            printResult(label, measure([&] {
+                for (int i = 0; i < rays; ++i)
+                    table->trace(startX[i], startY[i], dirX[i], dirY[i], 14.0f, bounces, 8000.0f, path);
+            }, 200));
+        }
+    }
+
+    // Caching: an unchanged table costs a comparison, a moved one a rebuild
+    CushionTable cached;
+    const std::vector<Detection> noDetections;
+    const Table still = makeTable(0.0f), moved = makeTable(12.0f);
+    cached.update(still, noDetections, 1920, 1080);
+    const bool rebuiltStill = cached.update(still, noDetections, 1920, 1080);
+    const bool rebuiltMoved = cached.update(moved, noDetections, 1920, 1080);
+    check("unchanged table is cached", !rebuiltStill, rebuiltStill, 0);
+    check("moved table is rebuilt", rebuiltMoved, rebuiltMoved, 1);
+    printResult("update, table unchanged", measure([&] { cached.update(moved, noDetections, 1920, 1080); }, 10000));
+    bool flip = false;
+    printResult("update, table moved (rebuild)", measure([&] {
+        cached.update(flip ? still : moved, noDetections, 1920, 1080);
+        flip = !flip;
+    }, 2000));
+}
@@ -0,0 +1,138 @@
+#include "bench.h"
+#include "detection.h"
+#include "simd.h"
+#include "yolo_decode.h"
+#include <random>
+
+// Synthetic [4 + C + 32, 8400] head: background noise plus clusters of
+// overlapping anchors around each object, like a real YOLO output before NMS.
+static std::vector<float> makeSyntheticOutput(int numClasses, int numMaskCoeffs, int numAnchors,
+                                              int numObjects, int anchorsPerObject) {
+    const int numChannels = 4 + numClasses + numMaskCoeffs;
+    std::vector<float> out(static_cast<size_t>(numChannels) * numAnchors);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> noise(0.0f, 0.3f);
+    std::uniform_real_distribution<float> pos(20.0f, 620.0f);
+    std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> conf(0.6f, 0.95f);
+
+    for (int c = 4; c < numChannels; ++c)
+        for (int i = 0; i < numAnchors; ++i)
+            out[static_cast<size_t>(c) * numAnchors + i] = noise(rng);
+
+    for (int o = 0; o < numObjects; ++o) {
+        const float cx = pos(rng), cy = pos(rng), size = 18.0f;
+        const int cls = o % numClasses;
+        for (int k = 0; k < anchorsPerObject; ++k) {
+            const int anchor = (o * 397 + k * 31) % numAnchors;
+            out[0 * numAnchors + anchor] = cx + jitter(rng);
+            out[1 * numAnchors + anchor] = cy + jitter(rng);
+            out[2 * numAnchors + anchor] = size + jitter(rng);
+            out[3 * numAnchors + anchor] = size + jitter(rng);
+            out[static_cast<size_t>(4 + cls) * numAnchors + anchor] = conf(rng);
+        }
+    }
+    return out;
+}
+
+// Hand-built [4 + 3 + 2, 10] head with known answers. 10 anchors put anchor 9 in the scalar tail
+// after the SIMD lanes. Anchor 1 (class 0, 0.9) and anchor 9 (class 0, 0.8, shifted 2 px) overlap,
+// so NMS drops 9. Anchor 4 repeats anchor 1's box as class 1 and survives unless NMS is
+// class-agnostic. Anchor 6 scores 0.55 for class 0 and 0.6 for class 2, and argmax picks class 2.
+// Anchor 7 (0.4) is below the threshold.
+struct DecodeCase {
+    static constexpr int classes = 3, coeffs = 2, anchors = 10, channels = 4 + classes + coeffs;
+    std::vector<float> output = std::vector<float>(channels * anchors, 0.1f);
+
+    void set(int anchor, float cx, float cy, float w, float h) {
+        output[0 * anchors + anchor] = cx;
+        output[1 * anchors + anchor] = cy;
+        output[2 * anchors + anchor] = w;
+        output[3 * anchors + anchor] = h;
+    }
+    void score(int anchor, int cls, float s) { output[(4 + cls) * anchors + anchor] = s; }
+
+    DecodeCase() {
+        set(1, 100.0f, 100.0f, 20.0f, 20.0f);
+        score(1, 0, 0.9f);
+        set(9, 102.0f, 101.0f, 20.0f, 20.0f);
+        score(9, 0, 0.8f);
+        set(4, 100.0f, 100.0f, 20.0f, 20.0f);
+        score(4, 1, 0.7f);
+        set(6, 300.0f, 200.0f, 40.0f, 10.0f);
+        score(6, 0, 0.55f);
+        score(6, 2, 0.6f);
+        set(7, 500.0f, 500.0f, 20.0f, 20.0f);
+        score(7, 1, 0.4f);
+    }
+};
+
+static bool sameDetection(const Detection& d, int anchor, int classId, float confidence, cv::Rect box) {
+    return d.anchor == anchor && d.class_id == classId && d.type == static_cast<ObjectType>(classId)
+        && d.confidence == confidence && d.box == box;
+}
+
+static void checkDecode(const char* level) {
+    const DecodeCase input;
+    DecodeParams params;
+    params.numClasses = DecodeCase::classes;
+    params.numMaskCoeffs = DecodeCase::coeffs;
+    // Letterbox back to frame pixels: 2x scale, 10 px left and 5 px top padding removed
+    params.scaleX = params.scaleY = 2.0f;
+    params.offsetX = -10.0f;
+    params.offsetY = 5.0f;
+    const cv::Rect first(170, 185, 40, 40), second(550, 395, 80, 20);
+    char label[64];
+
+    std::vector<Detection> d = decodeYoloOutput(input.output.data(), DecodeCase::channels, DecodeCase::anchors, params);
+    std::snprintf(label, sizeof(label), "decode %s: boxes, classes, NMS", level);
+    check(label, d.size() == 3 && sameDetection(d[0], 1, 0, 0.9f, first) && sameDetection(d[1], 4, 1, 0.7f, first)
+        && sameDetection(d[2], 6, 2, 0.6f, second), static_cast<double>(d.size()), 3);
+
+    params.classAgnosticNms = true;
+    d = decodeYoloOutput(input.output.data(), DecodeCase::channels, DecodeCase::anchors, params);
+    std::snprintf(label, sizeof(label), "decode %s: class-agnostic NMS", level);
+    check(label, d.size() == 2 && sameDetection(d[0], 1, 0, 0.9f, first) && sameDetection(d[1], 6, 2, 0.6f, second),
+        static_cast<double>(d.size()), 2);
+
+    params.classAgnosticNms = false;
+    params.maxDetections = 1;
+    d = decodeYoloOutput(input.output.data(), DecodeCase::channels, DecodeCase::anchors, params);
+    std::snprintf(label, sizeof(label), "decode %s: maxDetections", level);
+    check(label, d.size() == 1 && sameDetection(d[0], 1, 0, 0.9f, first), static_cast<double>(d.size()), 1);
+}
+
+void runDecodeBenchmark() {
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 }) {
+        overrideSimdLevel(level);
+        if (activeSimdLevel() == level) checkDecode(simdLevelName(level));
+    }
+    overrideSimdLevel(SimdLevel::AVX2);
+
+    const int numClasses = 7, numMaskCoeffs = 32, numAnchors = 8400;
+    const int numChannels = 4 + numClasses + numMaskCoeffs;
+    const int iterations = 500;
+
+    for (int objects : { 16, 64 }) {
+        std::vector<float> output = makeSyntheticOutput(numClasses, numMaskCoeffs, numAnchors, objects, 8);
+        DecodeParams params;
+        params.numClasses = numClasses;
+        params.numMaskCoeffs = numMaskCoeffs;
+
+        std::printf("%d anchors, %d objects x 8 anchors\n", numAnchors, objects);
+        YoloDecoder decoder;
+        std::vector<Detection> detections;
+        const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+        for (SimdLevel level : levels) {
+            overrideSimdLevel(level);
+            if (activeSimdLevel() != level) continue;
+            char label[64];
+            std::snprintf(label, sizeof(label), "decode + NMS %s", simdLevelName(level));
+            printResult(label, measure([&] {
+                decoder.decode(output.data(), numChannels, numAnchors, params, detections);
+            }, iterations));
+        }
+        overrideSimdLevel(SimdLevel::AVX2);
+        std::printf("  %-34s kept %zu detections\n", "", detections.size());
+    }
+}
@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "shot_ensemble.h"
+#include "simd.h"
+#include <cmath>
+
+// Standard normal CDF
+static double phi(double z) {
+    return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+void runEnsembleBenchmark() {
+    // Straight shot: cue (0, 0), object (300, 0), pocket (600, 0), radius 12, capture radius 20.
+    // An aim error d moves the contact sideways by D sin d, so the object ball leaves at
+    // asin(D sin d / 2R) - d off the pocket line and drops while L sin(that) < 20
+    const double D = 300.0, R = 12.0, L = 300.0, capture = 20.0;
+    double lo = 0.0, hi = 0.1;
+    for (int i = 0; i < 60; ++i) {
+        const double d = 0.5 * (lo + hi);
+        (std::asin(D * std::sin(d) / (2.0 * R)) - d < std::asin(capture / L) ? lo : hi) = d;
+    }
+    const double tolerance = lo * 57.29577951308232;
+    EnsembleShot straight;
+    straight.cueRadius = straight.objectRadius = static_cast<float>(R);
+    straight.objectX = static_cast<float>(D);
+    straight.aimX = static_cast<float>(D - 2.0 * R);
+    straight.pocketX = static_cast<float>(D + L);
+    ShotUncertainty u;
+    {
+        EnsembleConfig config;
+        config.aimSigmaDegrees = 0.0f;
+        ShotEnsemble exact(config);
+        exact.evaluate(straight, u);
+        check("no noise: always pockets", u.pocketProbability == 1.0f, u.pocketProbability, 1.0);
+        check("no noise: zero-width cone", u.coneLowDegrees == 0.0f && u.coneHighDegrees == 0.0f,
+            u.coneHighDegrees - u.coneLowDegrees, 0.0);
+    }
+    {
+        EnsembleConfig config;
+        config.samples = ensembleMaxSamples;
+        config.aimSigmaDegrees = 0.4f;
+        ShotEnsemble aimOnly(config);
+        aimOnly.evaluate(straight, u);
+        const double sigma = config.aimSigmaDegrees;
+        const double expected = 2.0 * phi(tolerance / sigma) - 1.0;
+        check("aim noise: P(pocket) analytic", std::abs(u.pocketProbability - expected) < 0.03, u.pocketProbability,
+            expected);
+        const double binWidth = 6.0 * sigma / ensembleAimBins;
+        check("aim window ~ +-tolerance", std::abs(u.aimHighDegrees - tolerance) <= binWidth
+            && std::abs(u.aimLowDegrees + tolerance) <= binWidth, u.aimHighDegrees, tolerance);
+        // Small angles: the object ball turns D / 2R - 1 times the aim error
+        const double cone = 1.6448536 * sigma * (D / (2.0 * R) - 1.0);
+        check("90% cone ~ +-1.645 sigma (D/2R - 1)", std::abs(u.coneHighDegrees - cone) < 0.1 * cone
+            && std::abs(u.coneLowDegrees + cone) < 0.1 * cone, u.coneHighDegrees, cone);
+    }
+
+    // Live case: a 30 degree cut, both balls from 20 px boxes at confidence 0.8 in a 2560-wide frame
+    const EnsembleConfig config;
+    const float scale = 1920.0f / 2560.0f;
+    EnsembleShot cut;
+    cut.cueX = 400.0f;
+    cut.cueY = 700.0f;
+    cut.objectX = 900.0f;
+    cut.objectY = 500.0f;
+    cut.cueRadius = cut.objectRadius = 7.5f;
+    cut.cueNoise = cut.objectNoise = detectionNoise(20.0f, 21.0f, 0.8f, scale, config);
+    cut.pocketX = 1660.0f;
+    cut.pocketY = 140.0f;
+    {
+        const float lx = cut.pocketX - cut.objectX, ly = cut.pocketY - cut.objectY;
+        const float length = std::sqrt(lx * lx + ly * ly);
+        cut.aimX = cut.objectX - lx / length * 15.0f;
+        cut.aimY = cut.objectY - ly / length * 15.0f;
+    }
+    std::printf("noise per ball: centre %.2f px, radius %.2f px (overlay)\n", cut.cueNoise.position, cut.cueNoise.radius);
+
+    const SimdLevel best = activeSimdLevel();
+    ShotUncertainty reference;
+    for (int level = static_cast<int>(best); level >= 0; --level) {
+        overrideSimdLevel(static_cast<SimdLevel>(level));
+        for (int samples : { 256, 1024 }) {
+            EnsembleConfig sized = config;
+            sized.samples = samples;
+            ShotEnsemble ensemble(sized);
+            ensemble.evaluate(cut, u);
+            if (level == static_cast<int>(best) && samples == 256) {
+                reference = u;
+                std::printf("  cut shot: P(hit) %.2f, P(pocket) %.2f, aim window [%.2f, %.2f] deg,"
+                            " cone [%.1f, %.1f] deg\n", u.hitProbability, u.pocketProbability, u.aimLowDegrees,
+                    u.aimHighDegrees, u.coneLowDegrees, u.coneHighDegrees);
+            }
+            else if (samples == 256) {
+                // Lanes must agree up to rounding right at a boundary: allow one sample
+                check(simdLevelName(static_cast<SimdLevel>(level)),
+                    std::abs(u.pocketProbability - reference.pocketProbability) <= 1.0f / 256.0f,
+                    u.pocketProbability, reference.pocketProbability);
+            }
+            char label[64];
+            std::snprintf(label, sizeof(label), "%d samples, %s", samples, simdLevelName(static_cast<SimdLevel>(level)));
+            printResult(label, measure([&] { ensemble.evaluate(cut, u); }, 2000));
+        }
+    }
+    overrideSimdLevel(best);
+}
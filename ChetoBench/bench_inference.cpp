@@ -0,0 +1,281 @@
+#include "bench.h"
+#include "cascade.h"
+#include "frame_source.h"
+#include "latency_stats.h"
+#include "onnx_inference.h"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// CHETO_MODEL, else the model ChetoAI loads
+static std::string benchModelPath() {
+    const char* path = std::getenv("CHETO_MODEL");
+    return path ? path : "D:/AimBotAI/ChetoAI/ChetoAI/onnx_model/yolov11mseg.onnx";
+}
+
+void runInferenceBenchmark() {
+    const std::string modelPath = benchModelPath();
+    std::error_code ec;
+    if (!std::filesystem::exists(modelPath, ec)) {
+        std::printf("  skipped: no model at %s (set CHETO_MODEL)\n", modelPath.c_str());
+        return;
+    }
+    ONNXInference inference(modelPath);
+    if (!inference.isSessionValid()) {
+        std::printf("  skipped: could not load %s\n", modelPath.c_str());
+        return;
+    }
+    const InferenceStartup& startup = inference.startupTimings();
+    std::printf("model %dx%d, %s start: session %.1f ms, warm-up %.1f ms (first run %.1f ms)\n",
+        inference.inputSize().width, inference.inputSize().height, startup.fromCache ? "warm" : "cold",
+        startup.sessionMs, startup.warmupMs, startup.firstRunMs);
+
+    cv::Mat frame(1080, 1920, CV_8UC4);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    std::vector<Detection> detections;
+    for (int i = 0; i < 3; ++i) inference.runInference(frame, detections);
+
+    // Steady state: input, outputs and the detection list are all reused
+    const int frames = 50;
+    const long long before = heapAllocations();
+    for (int i = 0; i < frames; ++i) inference.runInference(frame, detections);
+    const double perFrame = double(heapAllocations() - before) / frames;
+    std::printf("  %-34s %.2f heap allocations per frame\n", "runInference (IoBinding)", perFrame);
+    check("runInference: no heap allocation", perFrame == 0, perFrame, 0);
+
+    printResult("runInference, 1920x1080 BGRA", measure([&] { inference.runInference(frame, detections); }, frames));
+    const InferenceTimings& t = inference.lastTimings();
+    std::printf("  last frame: preprocess %.0f us, session.Run %.0f us, decode %.0f us, masks %.0f us\n",
+        t.preprocessUs, t.runUs, t.decodeUs, t.maskUs);
+}
+
+// Per ObjectType: how many FP32 boxes a variant reproduces (same type, IoU >= 0.5)
+struct Agreement {
+    uint64_t reference = 0;  // FP32 detections
+    uint64_t matched = 0;
+    uint64_t extra = 0;      // Variant detections with no FP32 counterpart
+    double iouSum = 0.0;     // Over matched pairs
+};
+
+constexpr int objectTypeCount = static_cast<int>(ObjectType::Unknown) + 1;
+
+// Greedy one-to-one matching, best IoU first
+static void matchDetections(const std::vector<Detection>& reference, const std::vector<Detection>& test,
+                            Agreement* perType) {
+    struct Pair { float iou; int r, t; };
+    std::vector<Pair> pairs;
+    for (int r = 0; r < (int)reference.size(); ++r)
+        for (int t = 0; t < (int)test.size(); ++t) {
+            if (reference[r].type != test[t].type) continue;
+            const float iou = boxIoU(reference[r].box, test[t].box);
+            if (iou >= 0.5f) pairs.push_back({ iou, r, t });
+        }
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) { return a.iou > b.iou; });
+    std::vector<char> usedR(reference.size(), 0), usedT(test.size(), 0);
+    for (const Pair& p : pairs) {
+        if (usedR[p.r] || usedT[p.t]) continue;
+        usedR[p.r] = usedT[p.t] = 1;
+        Agreement& a = perType[static_cast<int>(reference[p.r].type)];
+        ++a.matched;
+        a.iouSum += p.iou;
+    }
+    for (size_t r = 0; r < reference.size(); ++r) ++perType[static_cast<int>(reference[r].type)].reference;
+    for (size_t t = 0; t < test.size(); ++t)
+        if (!usedT[t]) ++perType[static_cast<int>(test[t].type)].extra;
+}
+
+static std::string sizeName(cv::Size size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+// One pass of a model over the recording
+struct RecordingRun {
+    size_t frames = 0;
+    LatencyHistogram run;        // session.Run
+    LatencyHistogram frameTime;  // Whole runInference
+    Agreement agreement[objectTypeCount];
+
+    double framesPerSecond() const { return frameTime.mean() > 0.0 ? 1e6 / frameTime.mean() : 0.0; }
+};
+
+// Runs `inference` over the first 500 frames of `recording`. With `record` the detections become
+// the reference; otherwise they are matched against it. false when the recording does not open
+static bool runRecording(ONNXInference& inference, const char* recording, bool record,
+                         std::vector<std::vector<Detection>>& reference, RecordingRun& out) {
+    std::unique_ptr<FrameSource> source = openRecording(recording);
+    if (!source) return false;
+    const size_t frameLimit = 500;
+    std::vector<Detection> detections;
+    cv::Mat frame;
+    for (CaptureStatus status; out.frames < frameLimit && (status = source->grab(frame)) != CaptureStatus::EndOfStream;) {
+        if (status == CaptureStatus::NoFrame) continue;
+        const auto t0 = std::chrono::steady_clock::now();
+        inference.runInference(frame, detections);
+        out.frameTime.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        out.run.add(inference.lastTimings().runUs);
+        if (record) reference.push_back(detections);
+        else if (out.frames < reference.size()) matchDetections(reference[out.frames], detections, out.agreement);
+        ++out.frames;
+    }
+    return true;
+}
+
+static const char* benchRecording() {
+    const char* recording = std::getenv("CHETO_RECORDING");
+    if (!recording) std::printf("  skipped: set CHETO_RECORDING to an image directory or video (and CHETO_MODEL)\n");
+    return recording;
+}
+
+// FP32 vs the FP16 / INT8 variants (tools/quantize_model.py) over a recording: latency, throughput
+// and how well each variant reproduces the FP32 detections, which serve as the labels
+void runPrecisionBenchmark() {
+    const std::string modelPath = benchModelPath();
+    const char* recording = benchRecording();
+    if (!recording) return;
+    std::vector<std::vector<Detection>> reference;
+
+    for (ModelPrecision precision : { ModelPrecision::Fp32, ModelPrecision::Fp16, ModelPrecision::Int8 }) {
+        InferenceConfig config;
+        config.precision = precision;
+        ONNXInference inference(modelPath, config);
+        if (!inference.isSessionValid() || inference.precision() != precision) {
+            std::printf("%s: skipped, no model at %s\n", modelPrecisionName(precision),
+                modelVariantPath(modelPath, precision).c_str());
+            if (precision == ModelPrecision::Fp32) return;
+            continue;
+        }
+        RecordingRun result;
+        if (!runRecording(inference, recording, precision == ModelPrecision::Fp32, reference, result)) {
+            std::printf("  skipped: cannot open %s\n", recording);
+            return;
+        }
+        std::printf("%s: %zu frames, session.Run mean %.2f ms p95 %.2f ms, frame mean %.2f ms, %.1f frames/s\n",
+            modelPrecisionName(precision), result.frames, result.run.mean() / 1000.0,
+            result.run.percentile(95) / 1000.0, result.frameTime.mean() / 1000.0, result.framesPerSecond());
+        if (precision == ModelPrecision::Fp32) continue;
+        for (int type = 0; type < objectTypeCount; ++type) {
+            const Agreement& a = result.agreement[type];
+            if (a.reference == 0 && a.extra == 0) continue;
+            std::printf("  %-10s %6llu FP32 boxes  recall %.3f  mean IoU %.3f  extra %llu\n",
+                objectTypeName(static_cast<ObjectType>(type)), (unsigned long long)a.reference, a.reference ? double(a.matched) / a.reference : 0.0,
+                a.matched ? a.iouSum / a.matched : 0.0, (unsigned long long)a.extra);
+        }
+    }
+}
+
+// Latency vs recall per ObjectType at each input size: 320/480/640 square plus table-aspect
+// 640x320, from a dynamic-shape model or <model>.WxH.onnx exports. The largest size is the reference
+void runResolutionBenchmark() {
+    const std::string modelPath = benchModelPath();
+    const char* recording = benchRecording();
+    if (!recording) return;
+    InferenceConfig config;
+    config.inputSizes = { cv::Size(640, 640), cv::Size(480, 480), cv::Size(320, 320), cv::Size(640, 320) };
+    ONNXInference inference(modelPath, config);
+    if (!inference.isSessionValid()) {
+        std::printf("  skipped: could not load %s\n", modelPath.c_str());
+        return;
+    }
+    std::vector<cv::Size> sizes = inference.inputSizes();
+    std::sort(sizes.begin(), sizes.end(), [](cv::Size a, cv::Size b) { return a.area() > b.area(); });
+
+    std::vector<std::vector<Detection>> reference;
+    std::vector<RecordingRun> results(sizes.size());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        inference.setInputSize(sizes[i]);
+        if (!runRecording(inference, recording, i == 0, reference, results[i])) {
+            std::printf("  skipped: cannot open %s\n", recording);
+            return;
+        }
+    }
+
+    // Columns: the types present in the reference
+    bool present[objectTypeCount] = {};
+    for (const auto& frame : reference)
+        for (const Detection& d : frame) present[static_cast<int>(d.type)] = true;
+    std::printf("%-9s %8s %8s", "input", "run ms", "frames/s");
+    for (int type = 0; type < objectTypeCount; ++type)
+        if (present[type]) std::printf(" %9s", objectTypeName(static_cast<ObjectType>(type)));
+    std::printf("   (recall vs %s)\n", sizeName(sizes[0]).c_str());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const RecordingRun& r = results[i];
+        std::printf("%-9s %8.2f %8.1f", sizeName(sizes[i]).c_str(), r.run.mean() / 1000.0, r.framesPerSecond());
+        for (int type = 0; type < objectTypeCount; ++type) {
+            if (!present[type]) continue;
+            const Agreement& a = r.agreement[type];
+            if (i == 0) std::printf(" %9s", "ref");
+            else std::printf(" %9.3f", a.reference ? double(a.matched) / a.reference : 0.0);
+        }
+        std::printf("\n");
+    }
+}
+
+// Fast ball locator + scheduled heavy model vs the heavy model on every frame: per-frame cost and
+// how well the merged cascade output reproduces the all-heavy detections. CHETO_FAST_MODEL is the
+// small model; CHETO_FAST_CLASSES its class order when it was trained on a subset (e.g. "White,Ball,Guideline")
+void runCascadeBenchmark() {
+    const std::string modelPath = benchModelPath();
+    const char* recording = benchRecording();
+    const char* fastPath = std::getenv("CHETO_FAST_MODEL");
+    if (!recording) return;
+    if (!fastPath) {
+        std::printf("  skipped: set CHETO_FAST_MODEL to the small detector\n");
+        return;
+    }
+    ONNXInference heavy(modelPath);
+    ONNXInference fast(fastPath);
+    if (!heavy.isSessionValid() || !fast.isSessionValid()) {
+        std::printf("  skipped: could not load %s or %s\n", modelPath.c_str(), fastPath);
+        return;
+    }
+    std::vector<ObjectType> classTypes;
+    const char* fastClasses = std::getenv("CHETO_FAST_CLASSES");
+    if (fastClasses && parseObjectTypes(fastClasses, classTypes)) fast.setClassTypes(classTypes);
+
+    std::vector<std::vector<Detection>> reference;
+    RecordingRun baseline;
+    if (!runRecording(heavy, recording, true, reference, baseline)) {
+        std::printf("  skipped: cannot open %s\n", recording);
+        return;
+    }
+
+    std::vector<Detection> heavyDetections, fastDetections;
+    CascadeDetector cascade(
+        [&](const cv::Mat& frame) { fast.runInference(frame, fastDetections); return fastDetections; },
+        [&](const cv::Mat& frame) { heavy.runInference(frame, heavyDetections); return heavyDetections; });
+    RecordingRun result;
+    std::unique_ptr<FrameSource> source = openRecording(recording);
+    cv::Mat frame;
+    for (CaptureStatus status; result.frames < reference.size() && (status = source->grab(frame)) != CaptureStatus::EndOfStream;) {
+        if (status == CaptureStatus::NoFrame) continue;
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::vector<Detection> merged = cascade.run(frame);
+        result.frameTime.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        matchDetections(reference[result.frames], merged, result.agreement);
+        ++result.frames;
+    }
+
+    const CascadeStats& stats = cascade.stats();
+    std::printf("all heavy: %zu frames, mean %.2f ms p95 %.2f ms\n", baseline.frames,
+        baseline.frameTime.mean() / 1000.0, baseline.frameTime.percentile(95) / 1000.0);
+    std::printf("cascade:   %zu frames, mean %.2f ms p95 %.2f ms (%.1fx), heavy on %.1f%% of frames\n", result.frames,
+        result.frameTime.mean() / 1000.0, result.frameTime.percentile(95) / 1000.0,
+        result.frameTime.mean() > 0.0 ? baseline.frameTime.mean() / result.frameTime.mean() : 0.0,
+        stats.frames ? 100.0 * stats.heavyRuns / stats.frames : 0.0);
+    std::printf("  heavy runs:");
+    for (int t = 1; t < static_cast<int>(CascadeTrigger::Count); ++t)
+        std::printf(" %s %llu%s", cascadeTriggerName(static_cast<CascadeTrigger>(t)),
+            (unsigned long long)stats.triggers[t], t + 1 < static_cast<int>(CascadeTrigger::Count) ? "," : "\n");
+    std::printf("  fast %.2f ms, heavy %.2f ms, merge %.3f ms per run; %llu heavy boxes carried over\n",
+        stats.fastRuns ? stats.fastUs / stats.fastRuns / 1000.0 : 0.0,
+        stats.heavyRuns ? stats.heavyUs / stats.heavyRuns / 1000.0 : 0.0,
+        stats.frames ? stats.cascadeUs / stats.frames / 1000.0 : 0.0, (unsigned long long)stats.keptDetections);
+    for (int type = 0; type < objectTypeCount; ++type) {
+        const Agreement& a = result.agreement[type];
+        if (a.reference == 0 && a.extra == 0) continue;
+        std::printf("  %-10s %6llu heavy boxes  recall %.3f  mean IoU %.3f  extra %llu\n",
+            objectTypeName(static_cast<ObjectType>(type)), (unsigned long long)a.reference,
+            a.reference ? double(a.matched) / a.reference : 0.0, a.matched ? a.iouSum / a.matched : 0.0,
+            (unsigned long long)a.extra);
+    }
+}
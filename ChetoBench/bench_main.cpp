@@ -0,0 +1,53 @@
+#include "bench.h"
+#include <cstring>
+
+struct BenchEntry {
+    const char* name;
+    void (*run)();
+};
+
+static const BenchEntry benches[] = {
+    { "preprocess", runPreprocessBenchmark },
+    { "decode", runDecodeBenchmark },
+    { "simulation", runSimulationBenchmark },
+    { "sweep", runSweepBenchmark },
+    { "ranking", runRankingBenchmark },
+    { "physics", runPhysicsBenchmark },
+    { "cushions", runCushionBenchmark },
+    { "motion", runMotionBenchmark },
+    { "ensemble", runEnsembleBenchmark },
+    { "cache", runCacheBenchmark },
+    { "inference", runInferenceBenchmark },
+    { "precision", runPrecisionBenchmark },
+    { "resolution", runResolutionBenchmark },
+    { "cascade", runCascadeBenchmark },
+    { "overlay", runOverlayBenchmark },
+    { "capture", runCaptureBenchmark },
+};
+
+// Usage: ChetoBench [name...]   (no arguments runs everything)
+int main(int argc, char** argv) {
+    bool ranAny = false;
+    for (const auto& bench : benches) {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], bench.name) == 0) selected = true;
+        if (!selected) continue;
+
+        std::printf("== %s ==\n", bench.name);
+        bench.run();
+        ranAny = true;
+    }
+
+    if (!ranAny) {
+        std::printf("Unknown benchmark. Available:");
+        for (const auto& bench : benches) std::printf(" %s", bench.name);
+        std::printf("\n");
+        return 1;
+    }
+    if (checkFailures() > 0) {
+        std::printf("%d check(s) FAILED\n", checkFailures());
+        return 1;
+    }
+    return 0;
+}
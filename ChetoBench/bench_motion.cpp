@@ -0,0 +1,177 @@
+#include "bench.h"
+#include "ball_motion.h"
+#include <cmath>
+#include <random>
+
+// Reference: explicit Euler at a fixed 10 us step with the friction direction re-evaluated every
+// step, same cushion impulse model. Records positions every `sampleEvery` seconds.
+struct Reference {
+    std::vector<double> x, y;
+    double endTime = 0.0;
+    int pocket = -1;
+    int cushionHits = 0;
+};
+
+static Reference integrate(BallState s, const SimTable& table, const MotionParams& p, double sampleEvery) {
+    const double dt = 1.0e-5;
+    const double r = p.radius;
+    Reference ref;
+    double t = 0.0, nextSample = 0.0;
+    for (;;) {
+        if (t >= nextSample) {
+            ref.x.push_back(s.x);
+            ref.y.push_back(s.y);
+            nextSample += sampleEvery;
+        }
+        double ax = 0.0, ay = 0.0, awx = 0.0, awy = 0.0;
+        const double slipX = s.vx - r * s.wy, slipY = s.vy + r * s.wx;
+        const double slip = std::hypot(slipX, slipY);
+        const double speed = std::hypot(s.vx, s.vy);
+        if (slip > 3.5 * p.slidingDecel * dt) {
+            ax = -p.slidingDecel * slipX / slip;
+            ay = -p.slidingDecel * slipY / slip;
+            awx = -2.5 * p.slidingDecel / r * slipY / slip;
+            awy = 2.5 * p.slidingDecel / r * slipX / slip;
+        }
+        else if (speed > p.rollingDecel * dt) {
+            s.wx = -s.vy / r;
+            s.wy = s.vx / r;
+            ax = -p.rollingDecel * s.vx / speed;
+            ay = -p.rollingDecel * s.vy / speed;
+            awx = -ay / r;
+            awy = ax / r;
+        }
+        else {
+            s.vx = s.vy = s.wx = s.wy = 0.0;
+        }
+        if (std::abs(s.wz) <= p.spinDecel * dt) s.wz = 0.0;
+        else s.wz -= (s.wz > 0.0 ? 1.0 : -1.0) * p.spinDecel * dt;
+        if (s.vx == 0.0 && s.vy == 0.0 && s.wz == 0.0) break;
+
+        s.x += s.vx * dt;
+        s.y += s.vy * dt;
+        s.vx += ax * dt;
+        s.vy += ay * dt;
+        s.wx += awx * dt;
+        s.wy += awy * dt;
+        t += dt;
+
+        for (int k = 0; k < table.cushionCount; ++k) {
+            const SimCushion& e = table.cushions[k];
+            if (e.nx * (s.x - e.x0) + e.ny * (s.y - e.y0) < r && e.nx * s.vx + e.ny * s.vy < 0.0) {
+                s = cushionBounce(s, e.nx, e.ny, p);
+                ++ref.cushionHits;
+            }
+        }
+        for (int q = 0; q < table.pocketCount && ref.pocket < 0; ++q)
+            if (std::hypot(s.x - table.pocketX[q], s.y - table.pocketY[q]) <= p.pocketRadius) ref.pocket = q;
+        if (ref.pocket >= 0 || t > p.maxTime) break;
+    }
+    ref.x.push_back(s.x);
+    ref.y.push_back(s.y);
+    ref.endTime = t;
+    return ref;
+}
+
+// Worst distance between the closed-form path and the reference at the sample times, plus the end point
+static double maxDeviation(const Trajectory& path, const Reference& ref, double sampleEvery) {
+    double worst = 0.0;
+    for (size_t k = 0; k + 1 < ref.x.size(); ++k) {
+        const BallState s = trajectoryAt(path, k * sampleEvery);
+        worst = std::max(worst, std::hypot(s.x - ref.x[k], s.y - ref.y[k]));
+    }
+    const BallState end = trajectoryAt(path, path.endTime);
+    return std::max(worst, std::hypot(end.x - ref.x.back(), end.y - ref.y.back()));
+}
+
+void runMotionBenchmark() {
+    const float pocketX[] = { 0.0f, 500.0f, 1000.0f, 0.0f, 500.0f, 1000.0f };
+    const float pocketY[] = { 0.0f, -5.0f, 0.0f, 500.0f, 505.0f, 500.0f };
+    const SimTable table = SimTable::rectangle(0.0f, 0.0f, 1000.0f, 500.0f, pocketX, pocketY, 6);
+    const SimTable open = SimTable::rectangle(-1.0e6f, -1.0e6f, 1.0e6f, 1.0e6f);
+    const MotionParams params;
+    const double r = params.radius;
+    Trajectory path;
+
+    // Stun shot: slides, then rolls at 5/7 of the strike speed
+    {
+        planTrajectory(strikeBall(0.0, 0.0, 1.0, 0.0, 1000.0, 0.0, 0.0, r), open, params, path);
+        const double rollSpeed = path.count > 1 ? path.segments[1].start.vx : 0.0;
+        check("stun rolls at 5/7 v0", std::abs(rollSpeed - 1000.0 * 5.0 / 7.0) < 1e-6, rollSpeed, 1000.0 * 5.0 / 7.0);
+        const double slideTime = 2.0 * 1000.0 / (7.0 * params.slidingDecel);
+        check("slide lasts 2 v0 / 7 mu_s g", std::abs(path.segments[0].duration - slideTime) < 1e-9,
+            path.segments[0].duration, slideTime);
+    }
+    // Natural roll from the tip: no sliding phase at all
+    {
+        planTrajectory(strikeBall(0.0, 0.0, 0.0, 1.0, 800.0, 0.0, 0.4, r), open, params, path);
+        const double stop = 800.0 * 800.0 / (2.0 * params.rollingDecel);
+        check("natural roll: one rolling segment", path.segments[0].phase == MotionPhase::Rolling, path.count, 2);
+        check("rolls v^2 / 2 mu_r g", std::abs(trajectoryAt(path, path.endTime).y - stop) < 1e-6,
+            trajectoryAt(path, path.endTime).y, stop);
+    }
+
+    // Closed form vs the reference integrator on shots with draw, follow, side spin and cushions
+    struct Shot {
+        const char* label;
+        double x, y, dirX, dirY, speed, side, follow;
+    };
+    const Shot shots[] = {
+        { "stun across the table", 200.0, 250.0, 1.0, 0.1, 1200.0, 0.0, 0.0 },
+        { "draw", 300.0, 250.0, 1.0, 0.0, 900.0, 0.0, -0.4 },
+        { "follow at an angle", 150.0, 120.0, 1.0, 0.6, 1500.0, 0.0, 0.3 },
+        { "right english, two cushions", 500.0, 250.0, 1.0, 1.0, 1600.0, 0.4, 0.0 },
+        { "left english, draw, cushions", 700.0, 100.0, -1.0, 0.7, 2000.0, -0.35, -0.25 },
+    };
+    const double sampleEvery = 0.01;
+    for (const Shot& s : shots) {
+        const BallState start = strikeBall(s.x, s.y, s.dirX, s.dirY, s.speed, s.side, s.follow, r);
+        planTrajectory(start, table, params, path);
+        const Reference ref = integrate(start, table, params, sampleEvery);
+        const double deviation = maxDeviation(path, ref, sampleEvery);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s (%d seg, %d cush)", s.label, path.count, path.cushionHits);
+        check(label, deviation < 0.5 && path.cushionHits == ref.cushionHits && path.pocket == ref.pocket,
+            deviation, 0.0);
+    }
+
+    // Side spin throws the rebound: same approach, the english changes the exit angle
+    {
+        const BallState plain = cushionBounce(strikeBall(0.0, 0.0, 1.0, 1.0, 1000.0, 0.0, 0.4, r), 0.0, -1.0, params);
+        const BallState english = cushionBounce(strikeBall(0.0, 0.0, 1.0, 1.0, 1000.0, 0.4, 0.4, r), 0.0, -1.0, params);
+        const double plainAngle = std::atan2(-plain.vy, plain.vx) * 57.29577951308232;
+        const double englishAngle = std::atan2(-english.vy, english.vx) * 57.29577951308232;
+        std::printf("  45 deg into a cushion: rebound %.1f deg plain, %.1f deg with right english\n",
+            plainAngle, englishAngle);
+    }
+
+    // Throughput: random strikes on the pocketed table
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> px(50.0, 950.0), py(50.0, 450.0), angle(0.0, 6.283185307179586),
+        speed(300.0, 2500.0), tip(-0.5, 0.5);
+    const int shotCount = 1000;
+    std::vector<BallState> starts;
+    for (int i = 0; i < shotCount; ++i) {
+        const double a = angle(rng);
+        starts.push_back(strikeBall(px(rng), py(rng), std::cos(a), std::sin(a), speed(rng), tip(rng), tip(rng), r));
+    }
+    long long segments = 0;
+    for (const BallState& s : starts) {
+        planTrajectory(s, table, params, path);
+        segments += path.count;
+    }
+    const BenchResult plan = measure([&] {
+        for (const BallState& s : starts) planTrajectory(s, table, params, path);
+    }, 20);
+    printResult("plan 1000 random shots", plan);
+    std::printf("  %.1f segments per shot, %.1f M segments/s (cushion + pocket tests included)\n",
+        double(segments) / shotCount, segments / plan.meanUs);
+
+    const int evaluations = 100000;
+    volatile double sink = 0.0;
+    const BenchResult eval = measure([&] {
+        for (int i = 0; i < evaluations; ++i) sink = trajectoryAt(path, (i % 1000) * path.endTime / 1000.0).x;
+    }, 20);
+    printResult("trajectoryAt x100000", eval);
+    std::printf("  %.1f M state evaluations/s\n", evaluations / eval.meanUs);
+}
@@ -0,0 +1,120 @@
+#include "bench.h"
+#include "cpu_raster.h"
+#include "draw_list.h"
+#include <cmath>
+#include <cstdlib>
+
+// Pixels with any coverage, and whether every covered pixel has exactly `alpha`
+static int coveredPixels(const cv::Mat& image, int alpha, bool& uniform) {
+    int covered = 0;
+    uniform = true;
+    for (int y = 0; y < image.rows; ++y) {
+        const unsigned char* p = image.ptr<unsigned char>(y);
+        for (int x = 0; x < image.cols; ++x, p += 4) {
+            if (p[3] == 0) continue;
+            ++covered;
+            uniform = uniform && p[3] == alpha;
+        }
+    }
+    return covered;
+}
+
+// imageHash() of overlayScene() rasterized at 1920x1080. The rasterizer is bit-exact, so this only
+// changes with the scene or the rasterizer; when it does on purpose, look at the frame written by
+// CHETO_OVERLAY_GOLDEN and paste the new hash here
+constexpr uint64_t overlayGoldenHash = 0x231f92c18a610667ULL;
+
+static uint64_t imageHash(const cv::Mat& image) {
+    uint64_t h = 1469598103934665603ULL;  // FNV-1a
+    for (int y = 0; y < image.rows; ++y) {
+        const unsigned char* p = image.ptr<unsigned char>(y);
+        for (size_t i = 0; i < image.cols * image.elemSize(); ++i) h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// What main draws on a busy frame: cue -> ghost -> pocket guideline, a 24-segment rollout, the
+// uncertainty cone hatched and outlined, and a ring around each of 16 balls. All opaque, as the
+// colour-keyed overlay window needs
+static void overlayScene(DrawList& list) {
+    const DrawColor red{ 1.0f, 0.0f, 0.0f, 1.0f }, cone{ 1.0f, 0.85f, 0.0f, 1.0f }, ring{ 0.2f, 0.9f, 1.0f, 1.0f };
+    list.clear();
+    const GuidePoint guide[] = { { 600.0f, 500.0f }, { 903.0f, 418.5f }, { 1660.0f, 140.0f } };
+    list.polyline(guide, 3, red);
+    GuidePoint rollout[25];
+    for (int i = 0; i < 25; ++i) {
+        const float t = i / 24.0f;
+        rollout[i] = { 600.0f + 700.0f * t, 500.0f + 260.0f * std::sin(t * 3.0f) };
+    }
+    list.polyline(rollout, 25, red, 2.0f);
+    const GuidePoint apex{ 917.0f, 412.0f }, low{ 1640.0f, 120.0f }, high{ 1672.0f, 170.0f };
+    list.hatchedCone(apex, low, high, 20.0f, cone);
+    list.line(apex, low, cone);
+    list.line(apex, high, cone);
+    for (int i = 0; i < 16; ++i) list.circle({ 320.0f + 80.0f * i, 300.0f + 30.0f * (i % 5) }, 15.0f, ring);
+}
+
+void runOverlayBenchmark() {
+    CpuRasterizer small(256, 256);
+    DrawList list;
+    bool uniform = false;
+    {
+        // Two triangles sharing a diagonal at half alpha: no pixel may be blended twice
+        list.clear();
+        const DrawColor half{ 1.0f, 1.0f, 1.0f, 0.5f };
+        list.triangle({ 10.0f, 10.0f }, { 110.0f, 10.0f }, { 110.0f, 110.0f }, half);
+        list.triangle({ 10.0f, 10.0f }, { 110.0f, 110.0f }, { 10.0f, 110.0f }, half);
+        small.render(list);
+        const int covered = coveredPixels(small.image(), 128, uniform);
+        check("shared edge: 100x100 square", covered == 10000, covered, 10000);
+        check("shared edge: each pixel once", uniform, uniform, 1);
+    }
+    {
+        list.clear();
+        list.line({ 20.0f, 40.0f }, { 220.0f, 40.0f }, DrawColor{}, 2.0f);
+        small.render(list);
+        const int covered = coveredPixels(small.image(), 255, uniform);
+        check("2 px line, 200 px long", covered == 400, covered, 400);
+    }
+    {
+        // Ring and wedge areas: annulus 2 pi r w, sector r^2 theta / 2 (chords cut a little off)
+        list.clear();
+        list.circle({ 128.0f, 128.0f }, 60.0f, DrawColor{}, 4.0f);
+        small.render(list);
+        const double ring = 2.0 * 3.141592653589793 * 60.0 * 4.0;
+        int covered = coveredPixels(small.image(), 255, uniform);
+        check("ring area, r 60 w 4", std::abs(covered - ring) < 0.03 * ring && uniform, covered, ring);
+        list.clear();
+        list.filledCone({ 28.0f, 128.0f }, { 228.0f, 128.0f }, { 28.0f + 200.0f * std::cos(0.5f),
+            128.0f - 200.0f * std::sin(0.5f) }, DrawColor{});
+        small.render(list);
+        const double sector = 200.0 * 200.0 * 0.5 / 2.0;
+        covered = coveredPixels(small.image(), 255, uniform);
+        check("cone area, r 200, 0.5 rad", std::abs(covered - sector) < 0.02 * sector && uniform, covered, sector);
+        // Rungs every 20 px, 1 px wide, at r = 20..200: chords 2 r sin(0.25) long, so the table shows through
+        list.clear();
+        list.hatchedCone({ 28.0f, 128.0f }, { 228.0f, 128.0f }, { 28.0f + 200.0f * std::cos(0.5f),
+            128.0f - 200.0f * std::sin(0.5f) }, 20.0f, DrawColor{});
+        small.render(list);
+        const double rungs = 2.0 * std::sin(0.25) * (20.0 + 200.0) * 10.0 / 2.0;
+        covered = coveredPixels(small.image(), 255, uniform);
+        check("hatched cone: rungs only", std::abs(covered - rungs) < 0.05 * rungs && uniform, covered, rungs);
+    }
+
+    // Golden image of the busy frame, checked by hash on every run. CHETO_OVERLAY_GOLDEN=path.png
+    // also writes the frame out, to inspect before updating overlayGoldenHash
+    CpuRasterizer full(1920, 1080);
+    overlayScene(list);
+    full.render(list);
+    coveredPixels(full.image(), 255, uniform);
+    check("busy frame opaque wherever drawn", uniform, uniform, 1);
+    const uint64_t hash = imageHash(full.image());
+    std::printf("scene: %zu triangles, image hash %016llx (golden %016llx)\n", list.triangleCount(),
+        (unsigned long long)hash, (unsigned long long)overlayGoldenHash);
+    check("busy frame matches golden image", hash == overlayGoldenHash, hash == overlayGoldenHash, 1);
+    if (const char* golden = std::getenv("CHETO_OVERLAY_GOLDEN"))
+        std::printf("  frame written to %s: %s\n", golden, cv::imwrite(golden, full.image()) ? "ok" : "FAILED");
+
+    printResult("build list (busy frame)", measure([&] { overlayScene(list); }, 2000));
+    printResult("rasterize 1920x1080", measure([&] { full.render(list); }, 200));
+}
@@ -0,0 +1,122 @@
+#include "bench.h"
+#include "physics.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+
+// Counts every heap allocation in the process, so the physics frame can be checked for zero
+static std::atomic<long long> allocationCount{ 0 };
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+long long heapAllocations() {
+    return allocationCount.load();
+}
+
+// Overlay-space frame: 1920x1080 table area, six pockets, cue ball and 15 object balls
+struct PhysicsFrame {
+    Table table;
+    Ball cueBall{}, targetBall{};
+    std::vector<Ball> others;
+};
+
+static PhysicsFrame makeFrame() {
+    PhysicsFrame frame;
+    frame.table.bounds = cv::Rect(260, 140, 1400, 700);
+    const float pocketX[] = { 260.0f, 960.0f, 1660.0f, 260.0f, 960.0f, 1660.0f };
+    const float pocketY[] = { 140.0f, 135.0f, 140.0f, 840.0f, 845.0f, 840.0f };
+    for (int p = 0; p < 6; ++p) frame.table.pockets.push_back(cv::Point2f(pocketX[p], pocketY[p]));
+
+    const float radius = 14.0f;
+    frame.cueBall = { cv::Point2f(600.0f, 500.0f), radius, BallType::Cue };
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> x(300.0f, 1620.0f), y(180.0f, 800.0f);
+    std::vector<cv::Point2f> placed{ frame.cueBall.center };
+    while (placed.size() < 16) {
+        const cv::Point2f p(x(rng), y(rng));
+        bool clear = true;
+        for (const auto& q : placed) clear = clear && std::hypot(p.x - q.x, p.y - q.y) > 2.5f * radius;
+        if (!clear) continue;
+        placed.push_back(p);
+        if (placed.size() == 2) frame.targetBall = { p, radius, BallType::Target };
+        else frame.others.push_back({ p, radius, BallType::Other });
+    }
+    return frame;
+}
+
+void runPhysicsBenchmark() {
+    const PhysicsFrame frame = makeFrame();
+    Simulator simulator;
+    SimResult result;
+    SimState layout;
+    GuideBuffer guide, path, rollout;
+    const int frames = 2000;
+
+    // One render-stage frame on the allocation-free API: convert once, fill caller-owned buffers
+    auto bufferFrame = [&] {
+        const GuideBall cue = toGuideBall(frame.cueBall), target = toGuideBall(frame.targetBall);
+        const GuideTable table = toGuideTable(frame.table);
+        calculateGuideline(cue, target, table, guide);
+        Physics::predictShotPath(cue, target, table, path);
+        toSimLayout(frame.cueBall, frame.targetBall, frame.others, layout);
+        simulateShot(layout, cue.radius, table, Physics::computeGhostBall(cue, target), simulatedShotSpeed,
+            simulator, result, rollout);
+    };
+    // The same frame through the std::vector wrappers
+    auto vectorFrame = [&] {
+        std::vector<LineSegment> g = calculateGuideline(frame.cueBall, frame.targetBall, frame.table);
+        std::vector<LineSegment> p = Physics::predictShotPath(frame.cueBall, frame.targetBall, frame.table);
+        std::vector<LineSegment> r = simulateShot(frame.cueBall, frame.targetBall, frame.others, frame.table,
+            simulatedShotSpeed, simulator, result);
+        (void)g;
+        (void)p;
+        (void)r;
+    };
+
+    // Guideline alone: no simulator, shows the per-call cost of the wrappers
+    auto bufferGuideline = [&] {
+        calculateGuideline(toGuideBall(frame.cueBall), toGuideBall(frame.targetBall), toGuideTable(frame.table), guide);
+        Physics::predictShotPath(toGuideBall(frame.cueBall), toGuideBall(frame.targetBall), toGuideTable(frame.table), path);
+    };
+    auto vectorGuideline = [&] {
+        std::vector<LineSegment> g = calculateGuideline(frame.cueBall, frame.targetBall, frame.table);
+        std::vector<LineSegment> p = Physics::predictShotPath(frame.cueBall, frame.targetBall, frame.table);
+        (void)g;
+        (void)p;
+    };
+
+    struct Case {
+        const char* label;
+        std::function<void()> fn;
+        bool allocationFree;         // The buffer path must not touch the heap once warm
+    };
+    const Case cases[] = {
+        { "guideline + shot path, buffers", bufferGuideline, true },
+        { "guideline + shot path, vectors", vectorGuideline, false },
+        { "physics frame, buffers", bufferFrame, true },
+        { "physics frame, vectors", vectorFrame, false },
+    };
+    for (const Case& c : cases) {
+        printResult(c.label, measure(c.fn, frames, 10));
+        const long long before = allocationCount.load();
+        for (int i = 0; i < frames; ++i) c.fn();
+        const double perFrame = double(allocationCount.load() - before) / frames;
+        std::printf("  %-34s %.2f heap allocations per frame\n", "", perFrame);
+        if (c.allocationFree) {
+            const std::string label = std::string(c.label) + ": no heap allocation per frame";
+            check(label.c_str(), perFrame == 0, perFrame, 0);
+        }
+    }
+    std::printf("  rollout: %d segments%s\n", rollout.count, rollout.overflow ? " (buffer full)" : "");
+}
@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "preprocess.h"
+#include "simd.h"
+#include <cmath>
+#include <opencv2/opencv.hpp>
+
+// The pre-fusion path from ONNXInference::runInference, kept here as the baseline
+static void legacyPreprocess(const cv::Mat& frame, std::vector<float>& tensor, int width, int height) {
+    cv::Mat resized;
+    cv::resize(frame, resized, cv::Size(width, height));
+    cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
+    resized.convertTo(resized, CV_32F, 1.0 / 255.0);
+
+    tensor.assign(static_cast<size_t>(width) * height * 3, 0.0f);
+    for (int c = 0; c < 3; ++c)
+        for (int h = 0; h < height; ++h)
+            for (int w = 0; w < width; ++w)
+                tensor[c * width * height + h * width + w] = resized.at<cv::Vec3f>(h, w)[c];
+}
+
+static float maxAbsDiff(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    return worst;
+}
+
+void runPreprocessBenchmark() {
+    const int inputSize = 640;
+    const int iterations = 100;
+    const cv::Size frameSizes[] = { cv::Size(1920, 1080), cv::Size(2560, 1440) };
+
+    for (const cv::Size& size : frameSizes) {
+        cv::Mat bgra(size, CV_8UC4);
+        cv::randu(bgra, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::Mat bgr;
+        cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
+
+        std::printf("%dx%d -> %dx%d\n", size.width, size.height, inputSize, inputSize);
+
+        std::vector<float> legacy;
+        printResult("legacy (BGR)", measure([&] { legacyPreprocess(bgr, legacy, inputSize, inputSize); }, iterations));
+        printResult("legacy (BGRA + cvtColor)", measure([&] {
+            cv::Mat converted;
+            cv::cvtColor(bgra, converted, cv::COLOR_BGRA2BGR);
+            legacyPreprocess(converted, legacy, inputSize, inputSize);
+        }, iterations));
+
+        std::vector<float> fused(static_cast<size_t>(inputSize) * inputSize * 3);
+        FramePreprocessor preprocessor;
+        const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+        for (SimdLevel level : levels) {
+            overrideSimdLevel(level);
+            if (activeSimdLevel() != level) continue; // Not supported on this CPU
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "fused %s (BGR)", simdLevelName(level));
+            printResult(label, measure([&] { preprocessor.run(bgr, fused.data(), inputSize, inputSize); }, iterations));
+            float diffBgr = maxAbsDiff(legacy, fused);
+
+            std::snprintf(label, sizeof(label), "fused %s (BGRA)", simdLevelName(level));
+            printResult(label, measure([&] { preprocessor.run(bgra, fused.data(), inputSize, inputSize); }, iterations));
+            float diffBgra = maxAbsDiff(legacy, fused);
+
+            std::printf("  %-34s max |fused - legacy| BGR %.5f  BGRA %.5f\n", "", diffBgr, diffBgra);
+        }
+        overrideSimdLevel(SimdLevel::AVX2);
+    }
+}
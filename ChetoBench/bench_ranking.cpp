@@ -0,0 +1,66 @@
+#include "bench.h"
+#include "shot_ranking.h"
+#include "simd.h"
+#include <cmath>
+#include <random>
+
+// 15 object balls scattered over a 1000x500 table, cue ball near the head string
+static ShotQuery makeQuery() {
+    ShotQuery query;
+    query.cueX = 250.0f;
+    query.cueY = 250.0f;
+    query.radius = 12.0f;
+    const float pocketX[] = { 0.0f, 500.0f, 1000.0f, 0.0f, 500.0f, 1000.0f };
+    const float pocketY[] = { 0.0f, -5.0f, 0.0f, 500.0f, 505.0f, 500.0f };
+    for (int p = 0; p < 6; ++p) query.addPocket(pocketX[p], pocketY[p]);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> x(40.0f, 960.0f), y(40.0f, 460.0f);
+    while (query.ballCount < 15) {
+        const float px = x(rng), py = y(rng);
+        bool clear = std::hypot(px - query.cueX, py - query.cueY) > 30.0f;
+        for (int i = 0; i < query.ballCount && clear; ++i)
+            clear = std::hypot(px - query.ballX[i], py - query.ballY[i]) > 30.0f;
+        if (clear) query.addBall(px, py, query.ballCount + 1);
+    }
+    return query;
+}
+
+void runRankingBenchmark() {
+    const ShotQuery query = makeQuery();
+    ShotRankingConfig config;
+    ShotRanking ranking;
+
+    std::printf("15 balls x 6 pockets, top %d\n", config.topK);
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    int firstCount = -1, firstBall = -1;
+    bool consistent = true;
+    for (SimdLevel level : levels) {
+        overrideSimdLevel(level);
+        if (activeSimdLevel() != level) continue;
+        char label[64];
+        std::snprintf(label, sizeof(label), "rank shots %s", simdLevelName(level));
+        printResult(label, measure([&] { rankShots(query, config, ranking); }, 20000, 100));
+
+        // Every level must pick the same shots
+        const int best = ranking.count > 0 ? ranking.shots[0].ballId : -1;
+        if (firstCount < 0) {
+            firstCount = ranking.count;
+            firstBall = best;
+        }
+        else if (ranking.count != firstCount || best != firstBall) consistent = false;
+    }
+    overrideSimdLevel(SimdLevel::AVX2);
+    check("rank shots: same top shot at every SIMD level", consistent, consistent, 1);
+
+    // Exhaustive top-K: every pair goes through both obstruction queries
+    config.topK = shotMaxRanked;
+    printResult("rank shots, top 8", measure([&] { rankShots(query, config, ranking); }, 20000, 100));
+
+    std::printf("  %d pairs, %d blocked, %d ranked\n", ranking.evaluated, ranking.blocked, ranking.count);
+    for (int i = 0; i < ranking.count && i < 3; ++i) {
+        const RankedShot& s = ranking.shots[i];
+        std::printf("  #%d ball %2d -> pocket %d  cut %5.1f deg  legs %6.1f + %6.1f  score %.3f\n", i + 1,
+            s.ballId, s.pocket, s.cutDegrees, s.cueDistance, s.objectDistance, s.score);
+    }
+}
@@ -0,0 +1,135 @@
+#include "bench.h"
+#include "simulation.h"
+#include <cmath>
+
+// Deterministic checks against closed-form answers, then break-shot timing.
+// A failed check is printed, makes the run's summary line say FAIL and fails the ChetoBench run.
+
+static SimTable openTable() {
+    return SimTable::rectangle(-1e5f, -1e5f, 1e5f, 1e5f);
+}
+
+// Ball rolls to rest: distance v^2 / (2 decel), time v / decel
+static void checkStopDistance() {
+    Simulator sim;
+    const double v = 600.0, decel = sim.settings().rollingDecel;
+    SimState state;
+    state.add(0.0f, 0.0f, static_cast<float>(v), 0.0f);
+    SimResult result;
+    sim.run(state, openTable(), result);
+    checkNear("stop distance", state.x[0], v * v / (2.0 * decel), 1e-6);
+    checkNear("stop time", result.endTime, v / decel, 1e-9);
+}
+
+// Elastic head-on: the cue ball stops dead and the object ball leaves with the cue's speed at contact
+static void checkHeadOn() {
+    SimParams params;
+    params.ballRestitution = 1.0f;
+    Simulator sim(params);
+    const double v = 600.0, gap = 100.0, decel = params.rollingDecel;
+    const double contactX = gap - 2.0 * params.ballRadius;
+    const double contactSpeed = std::sqrt(v * v - 2.0 * decel * contactX);
+    SimState state;
+    state.add(0.0f, 0.0f, static_cast<float>(v), 0.0f);
+    state.add(static_cast<float>(gap), 0.0f);
+    SimResult result;
+    sim.run(state, openTable(), result);
+    checkNear("head-on: cue stops at contact", state.x[0], contactX, 1e-6);
+    checkNear("head-on: object travel", state.x[1], gap + contactSpeed * contactSpeed / (2.0 * decel), 1e-6);
+    checkNear("head-on: first hit", result.firstHit, 1, 0);
+}
+
+// Equal-mass elastic cut shot: the balls leave at 90 degrees
+static void checkCutAngle() {
+    SimParams params;
+    params.ballRestitution = 1.0f;
+    params.rollingDecel = 0.0f;
+    params.maxTime = 1.0;
+    Simulator sim(params);
+    SimState state;
+    state.add(0.0f, 0.0f, 500.0f, 0.0f);
+    state.add(200.0f, 12.0f); // Half-ball hit
+    SimResult result;
+    sim.run(state, openTable(), result);
+    const double dot = state.vx[0] * state.vx[1] + state.vy[0] * state.vy[1];
+    checkNear("cut shot: velocities perpendicular", dot, 0.0, 1e-6);
+    checkNear("cut shot: speed conserved", state.vx[0] * state.vx[0] + state.vy[0] * state.vy[0]
+        + state.vx[1] * state.vx[1] + state.vy[1] * state.vy[1], 500.0 * 500.0, 1e-3);
+}
+
+// Cushion with restitution e: angle of incidence in, normal component scaled by e out
+static void checkCushion() {
+    SimParams params;
+    params.cushionRestitution = 0.5f;
+    params.rollingDecel = 0.0f;
+    params.maxTime = 1.0;
+    Simulator sim(params);
+    const SimTable table = SimTable::rectangle(0.0f, 0.0f, 1000.0f, 500.0f);
+    SimState state;
+    state.add(500.0f, 250.0f, 300.0f, 300.0f);
+    SimResult result;
+    sim.run(state, table, result);
+    const SimBallResult& ball = result.balls[0];
+    checkNear("cushion: contact time", ball.pathCount > 1 ? ball.path[1].t : -1.0, (500.0 - 12.0 - 250.0) / 300.0, 1e-5);
+    checkNear("cushion: tangential speed kept", state.vx[0], 300.0, 1e-6);
+    checkNear("cushion: normal speed x e", state.vy[0], -150.0, 1e-6);
+}
+
+static void rackBalls(SimState& state, float footX, float centerY, float radius) {
+    const float rowStep = radius * std::sqrt(3.0f) + 0.01f;
+    const float spacing = 2.0f * radius + 0.01f;
+    for (int row = 0; row < 5; ++row)
+        for (int k = 0; k <= row; ++k)
+            state.add(footX + row * rowStep, centerY + (k - row * 0.5f) * spacing);
+}
+
+void runSimulationBenchmark() {
+    const int failuresBefore = checkFailures();
+    checkStopDistance();
+    checkHeadOn();
+    checkCutAngle();
+    checkCushion();
+
+    // 16-ball break on a 1000x500 table with six pockets
+    const float pocketX[] = { 0.0f, 500.0f, 1000.0f, 0.0f, 500.0f, 1000.0f };
+    const float pocketY[] = { 0.0f, -5.0f, 0.0f, 500.0f, 505.0f, 500.0f };
+    const SimTable table = SimTable::rectangle(0.0f, 0.0f, 1000.0f, 500.0f, pocketX, pocketY, 6);
+    Simulator sim;
+    SimState rack;
+    rack.add(250.0f, 250.0f, 2500.0f, 13.0f);
+    rackBalls(rack, 700.0f, 250.0f, sim.settings().ballRadius);
+
+    SimResult result;
+    SimState state;
+    printResult("break shot rollout (16 balls)", measure([&] {
+        state = rack;
+        sim.run(state, table, result);
+    }, 2000));
+
+    int pocketed = 0;
+    for (int i = 0; i < result.ballCount; ++i) pocketed += result.balls[i].pocketed;
+    std::printf("  %d events, %.2f s simulated, %d pocketed%s\n", result.events, result.endTime, pocketed,
+        result.truncated ? ", truncated" : "");
+
+    // Deterministic: the same input must give bit-identical output
+    SimResult again;
+    SimState replay = rack;
+    sim.run(replay, table, again);
+    bool identical = again.events == result.events;
+    for (int i = 0; i < state.count && identical; ++i)
+        identical = replay.x[i] == state.x[i] && replay.y[i] == state.y[i];
+    checkNear("break: repeat run identical", identical ? 1.0 : 0.0, 1.0, 0.0);
+
+    // No two balls may end up overlapping
+    double worst = 0.0;
+    for (int i = 0; i < state.count; ++i) {
+        for (int j = i + 1; j < state.count; ++j) {
+            if (state.status[i] == SimBallStatus::Pocketed || state.status[j] == SimBallStatus::Pocketed) continue;
+            const double d = std::hypot(state.x[i] - state.x[j], state.y[i] - state.y[j]);
+            worst = std::max(worst, 2.0 * sim.settings().ballRadius - d);
+        }
+    }
+    checkNear("break: max overlap", worst > 0.0 ? worst : 0.0, 0.0, 1e-3);
+
+    std::printf("  simulation checks: %s\n", checkFailures() == failuresBefore ? "all passed" : "FAIL");
+}
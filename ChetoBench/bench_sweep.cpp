@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "shot_sweep.h"
+#include "simd.h"
+#include <cmath>
+#include <random>
+
+// Mid-game layout: cue ball plus 15 object balls scattered on a 1000x500 table
+static SimState makeLayout(float radius) {
+    SimState layout;
+    layout.add(300.0f, 260.0f);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> x(40.0f, 960.0f), y(40.0f, 460.0f);
+    while (layout.count < 16) {
+        const float px = x(rng), py = y(rng);
+        bool clear = true;
+        for (int i = 0; i < layout.count && clear; ++i)
+            clear = std::hypot(layout.x[i] - px, layout.y[i] - py) > 2.5 * radius;
+        if (clear) layout.add(px, py);
+    }
+    return layout;
+}
+
+void runSweepBenchmark() {
+    const float pocketX[] = { 0.0f, 500.0f, 1000.0f, 0.0f, 500.0f, 1000.0f };
+    const float pocketY[] = { 0.0f, -5.0f, 0.0f, 500.0f, 505.0f, 500.0f };
+    const SimTable table = SimTable::rectangle(0.0f, 0.0f, 1000.0f, 500.0f, pocketX, pocketY, 6);
+    const SimParams params;
+    const SimState layout = makeLayout(params.ballRadius);
+
+    // Stage 1 alone: first contact for every direction, per SIMD level
+    const int directions = 7200;
+    std::vector<float> dirX(directions), dirY(directions), distance(directions);
+    std::vector<int> code(directions);
+    for (int i = 0; i < directions; ++i) {
+        dirX[i] = std::cos(i * 0.05f * 3.14159265f / 180.0f);
+        dirY[i] = std::sin(i * 0.05f * 3.14159265f / 180.0f);
+    }
+    const ContactScene scene(layout, table, params);
+    std::printf("first contact, %d directions x (15 balls + 4 cushions + 6 pockets)\n", directions);
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    for (SimdLevel level : levels) {
+        overrideSimdLevel(level);
+        if (activeSimdLevel() != level) continue;
+        char label[64];
+        std::snprintf(label, sizeof(label), "first contact %s", simdLevelName(level));
+        printResult(label, measure([&] {
+            findFirstContacts(scene, dirX.data(), dirY.data(), directions, distance.data(), code.data());
+        }, 200));
+    }
+    overrideSimdLevel(SimdLevel::AVX2);
+
+    // Full sweep, single worker vs every core
+    std::vector<SweepOutcome> outcomes;
+    for (int threads : { 0, -1 }) {
+        ShotSweeper sweeper(params, threads);
+        for (int speeds : { 1, 3 }) {
+            SweepConfig config;
+            config.speedCount = speeds;
+            char label[64];
+            std::snprintf(label, sizeof(label), "sweep 0.05 deg x %d speed%s, %d worker%s", speeds, speeds > 1 ? "s" : "",
+                sweeper.workerCount(), sweeper.workerCount() > 1 ? "s" : "");
+            printResult(label, measure([&] { sweeper.sweep(layout, table, config, outcomes); }, 10, 1));
+        }
+        int pocketing = 0, scratches = 0;
+        for (const SweepOutcome& o : outcomes) {
+            if ((o.pocketed & ~1u) && !o.scratch) ++pocketing;
+            if (o.scratch) ++scratches;
+        }
+        std::printf("  %d candidates, %d rollouts; %d pocket a ball, %d scratch\n",
+            sweeper.stats().candidates, sweeper.stats().rollouts, pocketing, scratches);
+    }
+}
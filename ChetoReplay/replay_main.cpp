@@ -0,0 +1,698 @@
+// Headless replay: runs ONNXInference + processDetections + Physics over a
+// recording (image directory or video file) and reports per-stage latency.
+// No window, no D3D, no desktop capture; runs anywhere ONNX Runtime + OpenCV do.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include "ball_motion.h"
+#include "cascade.h"
+#include "change_detector.h"
+#include "cushions.h"
+#include "frame_source.h"
+#include "latency_stats.h"
+#include "onnx_inference.h"
+#include "physics.h"
+#include "physics_cache.h"
+#include "pipeline.h"
+#include "scene.h"
+#include "shot_sweep.h"
+#include "table_roi.h"
+#include "trace.h"
+#include "tracker.h"
+
+namespace {
+
+struct ReplayOptions {
+    std::string modelPath;
+    std::string recordingPath;
+    int loops = 1;
+    bool pipelined = false;
+    bool masks = false;
+    bool tableRoi = false;
+    bool rectify = false;
+    bool gate = false;
+    bool sweep = false;
+    bool cache = true;
+    InferenceConfig inference;
+    std::string calibrationDir;  // --calibrate: dump model inputs for INT8 calibration
+    std::string fastModelPath;   // --cascade: small detector run on every frame
+    std::vector<ObjectType> fastClasses; // --cascade-classes: its class order when trained on a subset
+    double displayHz = 0.0;      // --display-hz: pipelined render stage also ticks at this rate
+    int extrapolateStride = 0;   // --extrapolate: measure the overlay extrapolation error
+    double resultLatencyMs = 0.0;
+    double compensationMs = 0.0;
+    double fps = 0.0;            // Recording frame rate; 0 = from the video, else 60
+    std::string tracePath; // Chrome trace JSON output (requires a CHETO_TRACING build)
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: ChetoReplay <model.onnx> <image-dir | video-file> [options]\n"
+        "  --loops N      replay the recording N times (default 1)\n"
+        "  --pipeline     run through FramePipeline (threaded, in-order) and report end-to-end latency\n"
+        "  --masks        also assemble Guideline/PlayArea masks\n"
+        "  --roi          infer on the table crop once the play area is locked\n"
+        "  --rectify      with --roi, perspective-rectify the crop from the corner pockets\n"
+        "  --gate         skip inference on frames where nothing (on the table) changed\n"
+        "  --sweep        sweep every cue angle (0.05 deg) through the simulator whenever the balls are at rest\n"
+        "  --no-cache     recompute guideline, rollout, ensemble and sweep every frame (no PhysicsCache)\n"
+        "  --threads N    ONNX Runtime intra-op threads (default: one per physical core)\n"
+        "  --affinity L   pin intra-op workers, e.g. \"3;4;5\" with --threads 4 (1-based logical CPUs)\n"
+        "  --warmup N     blank-input session runs at load (default 2)\n"
+        "  --no-opt-cache optimize the model on every launch instead of reusing <model>.optimized.onnx\n"
+        "  --precision P  fp32 (default), fp16 or int8: load <model>.fp16.onnx / <model>.int8.onnx\n"
+        "  --input-size L extra model input sizes, e.g. 320x320,640x320 (dynamic model, or <model>.WxH.onnx\n"
+        "                 exports); with --roi the crop uses the one closest to its aspect ratio\n"
+        "  --calibrate D  write every 10th model input (up to 200) to D as .npy for tools/quantize_model.py\n"
+        "  --cascade F    run the small model F every frame for White/Ball/Guideline and the main model only\n"
+        "                 on a schedule or scene change (pockets, play area, full ball set)\n"
+        "  --cascade-classes L  class order of the --cascade model if it has fewer classes, e.g. White,Ball,Guideline\n"
+        "  --display-hz N with --pipeline, redraw from the extrapolated balls at N Hz between detections\n"
+        "  --extrapolate K  use only every K-th frame's detections and report how far the extrapolated\n"
+        "                 balls are from the real detections on the frames in between\n"
+        "  --latency-ms L with --extrapolate, results arrive L ms after capture (default 0)\n"
+        "  --lead-ms C    BallTracker latencyCompensation: predict C ms past the render time (default 0)\n"
+        "  --fps F        recording frame rate for --extrapolate (default: from the video, else 60)\n"
+        "  --trace FILE   write a Chrome/Perfetto trace (build with CHETO_TRACING)\n");
+}
+
+// "320x320,640x320"
+bool parseSizeList(const char* text, std::vector<cv::Size>& sizes) {
+    while (*text) {
+        int width = 0, height = 0, used = 0;
+        if (std::sscanf(text, "%dx%d%n", &width, &height, &used) != 2 || width <= 0 || height <= 0) return false;
+        sizes.emplace_back(width, height);
+        text += used;
+        if (*text == ',') ++text;
+    }
+    return !sizes.empty();
+}
+
+bool parseArgs(int argc, char** argv, ReplayOptions& options) {
+    if (argc < 3) return false;
+    options.modelPath = argv[1];
+    options.recordingPath = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--loops") == 0 && i + 1 < argc) options.loops = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--pipeline") == 0) options.pipelined = true;
+        else if (std::strcmp(argv[i], "--masks") == 0) options.masks = true;
+        else if (std::strcmp(argv[i], "--roi") == 0) options.tableRoi = true;
+        else if (std::strcmp(argv[i], "--rectify") == 0) options.tableRoi = options.rectify = true;
+        else if (std::strcmp(argv[i], "--gate") == 0) options.gate = true;
+        else if (std::strcmp(argv[i], "--sweep") == 0) options.sweep = true;
+        else if (std::strcmp(argv[i], "--no-cache") == 0) options.cache = false;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.inference.intraOpThreads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--affinity") == 0 && i + 1 < argc) options.inference.threadAffinity = argv[++i];
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) options.inference.warmupRuns = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--no-opt-cache") == 0) options.inference.cacheOptimizedModel = false;
+        else if (std::strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            const char* precision = argv[++i];
+            if (std::strcmp(precision, "fp32") == 0) options.inference.precision = ModelPrecision::Fp32;
+            else if (std::strcmp(precision, "fp16") == 0) options.inference.precision = ModelPrecision::Fp16;
+            else if (std::strcmp(precision, "int8") == 0) options.inference.precision = ModelPrecision::Int8;
+            else return false;
+        }
+        else if (std::strcmp(argv[i], "--calibrate") == 0 && i + 1 < argc) options.calibrationDir = argv[++i];
+        else if (std::strcmp(argv[i], "--input-size") == 0 && i + 1 < argc) {
+            if (!parseSizeList(argv[++i], options.inference.inputSizes)) return false;
+        }
+        else if (std::strcmp(argv[i], "--cascade") == 0 && i + 1 < argc) options.fastModelPath = argv[++i];
+        else if (std::strcmp(argv[i], "--cascade-classes") == 0 && i + 1 < argc) {
+            if (!parseObjectTypes(argv[++i], options.fastClasses)) return false;
+        }
+        else if (std::strcmp(argv[i], "--display-hz") == 0 && i + 1 < argc) options.displayHz = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--extrapolate") == 0 && i + 1 < argc) {
+            options.extrapolateStride = std::atoi(argv[++i]);
+            if (options.extrapolateStride < 1) return false;
+        }
+        else if (std::strcmp(argv[i], "--latency-ms") == 0 && i + 1 < argc) options.resultLatencyMs = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--lead-ms") == 0 && i + 1 < argc) options.compensationMs = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) options.fps = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) options.tracePath = argv[++i];
+        else return false;
+    }
+    return true;
+}
+
+// Plain full-frame inference, or through the table-ROI tracker, optionally split into a fast / heavy
+// cascade, optionally behind the change gate
+struct ReplayDetector {
+    ONNXInference& inference;
+    std::unique_ptr<TableRoiTracker> tableRoi;
+    std::unique_ptr<GatedDetector> gate;
+    std::unique_ptr<ONNXInference> fastInference; // --cascade
+    std::unique_ptr<CascadeDetector> cascade;
+    FrameChanges changes;                         // Of the frame being detected, for the cascade
+
+    std::vector<Detection> detectHeavy(const cv::Mat& frame) {
+        if (tableRoi) return tableRoi->run(frame);
+        inference.setInputSize(inference.closestInputSize(frame.size()));
+        return inference.runInference(frame);
+    }
+    // Small model on the table crop once the ROI is locked, boxes mapped back to frame pixels
+    std::vector<Detection> detectFast(const cv::Mat& frame) {
+        return tableRoi ? tableRoi->runOther(*fastInference, frame) : fastInference->runInference(frame);
+    }
+    std::vector<Detection> detect(const cv::Mat& frame) {
+        return cascade ? cascade->run(frame, changes) : detectHeavy(frame);
+    }
+    std::vector<Detection> run(const cv::Mat& frame, const FrameChanges& frameChanges) {
+        changes = frameChanges;
+        return gate ? gate->run(frame, frameChanges) : detect(frame);
+    }
+    bool lastReused() const { return gate && gate->lastReused(); }
+    // Model behind the last detections (the fast one on cascade frames without a heavy run)
+    const ONNXInference& lastModel() const {
+        return cascade && !cascade->lastHeavy() ? *fastInference : inference;
+    }
+};
+
+// Model inputs as they reach session.Run (after preprocessing, ROI crop included), one
+// [1,3,H,W] float32 .npy file each: the calibration set for static INT8 quantization
+struct CalibrationDump {
+    std::string directory;
+    int stride = 10;
+    int limit = 200;
+    int written = 0;
+    uint64_t seen = 0;
+
+    void add(const ONNXInference& inference) {
+        if (directory.empty() || written >= limit || seen++ % stride != 0) return;
+        char name[32];
+        std::snprintf(name, sizeof(name), "/input_%04d.npy", written);
+        if (writeInput(directory + name, inference.lastInput(), inference.inputSize())) ++written;
+    }
+
+    // NPY format 1.0: magic, version, header length, a Python dict padded to 64 bytes, raw data
+    static bool writeInput(const std::string& path, const std::vector<float>& tensor, cv::Size size) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        char dict[128];
+        const int dictLength = std::snprintf(dict, sizeof(dict),
+            "{'descr': '<f4', 'fortran_order': False, 'shape': (1, 3, %d, %d), }", size.height, size.width);
+        std::string header(dict, dictLength);
+        header.append(63 - (10 + header.size()) % 64, ' ');
+        header += '\n';
+        const unsigned char preamble[10] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+            static_cast<unsigned char>(header.size() & 0xff), static_cast<unsigned char>(header.size() >> 8) };
+        bool ok = std::fwrite(preamble, 1, sizeof(preamble), file) == sizeof(preamble)
+            && std::fwrite(header.data(), 1, header.size(), file) == header.size()
+            && std::fwrite(tensor.data(), sizeof(float), tensor.size(), file) == tensor.size();
+        ok = std::fclose(file) == 0 && ok;
+        return ok;
+    }
+};
+
+// --extrapolate: how far off the display-rate overlay is between inference results. Replayed on the
+// recording's own clock: only every `stride`-th frame's detections reach the tracker, each `latency`
+// seconds after its capture. On every other frame the tracker's prediction for that moment (plus
+// latencyCompensation) is compared with what the detector really saw on the frame that far ahead,
+// and so is the last filtered position, held, as the overlay showed it before.
+struct ExtrapolationProbe {
+    int stride = 0;                   // 0 = off
+    double frameInterval = 1.0 / 60.0;
+    double latency = 0.0;
+    double compensation = 0.0;
+    std::vector<std::vector<Detection>> frames; // Ball / White detections of every frame
+
+    void add(const std::vector<Detection>& detections) {
+        if (stride <= 0) return;
+        frames.emplace_back();
+        for (const Detection& det : detections) {
+            if (det.type != ObjectType::Ball && det.type != ObjectType::White) continue;
+            frames.back().push_back(det);
+            frames.back().back().mask = cv::Mat();
+        }
+    }
+
+    static cv::Point2f center(const Detection& det) {
+        return { det.box.x + det.box.width * 0.5f, det.box.y + det.box.height * 0.5f };
+    }
+    static float distance(cv::Point2f a, cv::Point2f b) {
+        return std::hypot(a.x - b.x, a.y - b.y);
+    }
+
+    // Same-type detection nearest `ball` within 4 radii; nullptr when there is none
+    static const Detection* nearest(const std::vector<Detection>& detections, const TrackedBall& ball) {
+        const Detection* best = nullptr;
+        float bestDistance = 4.0f * std::max(ball.radius, 1.0f);
+        for (const Detection& det : detections) {
+            if (det.type != ball.type) continue;
+            const float distance = ExtrapolationProbe::distance(center(det), ball.center);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = &det;
+            }
+        }
+        return best;
+    }
+
+    static void printErrors(const char* label, std::vector<float>& extrapolated, std::vector<float>& held) {
+        auto mean = [](const std::vector<float>& v) {
+            double sum = 0.0;
+            for (float e : v) sum += e;
+            return v.empty() ? 0.0 : sum / v.size();
+        };
+        auto p95 = [](std::vector<float>& v) {
+            if (v.empty()) return 0.0f;
+            std::sort(v.begin(), v.end());
+            return v[std::min(v.size() - 1, static_cast<size_t>(v.size() * 0.95))];
+        };
+        std::printf("  %-14s %7zu samples: extrapolated mean %6.2f px p95 %6.2f px | held mean %6.2f px p95 %6.2f px\n",
+            label, extrapolated.size(), mean(extrapolated), p95(extrapolated), mean(held), p95(held));
+    }
+
+    void report() const {
+        if (stride <= 0 || frames.empty()) return;
+        BallTracker tracker;
+        tracker.settings().latencyCompensation = compensation;
+        const int lead = static_cast<int>(std::lround(compensation / frameInterval));
+        std::vector<TrackedBall> predicted, held;
+        std::vector<float> movingExtrapolated, movingHeld, restingExtrapolated, restingHeld;
+        size_t next = 0;      // Next frame whose detections reach the tracker
+        size_t applied = 0;   // Frame of the newest applied detections + 1
+        for (size_t f = 0; f + lead < frames.size(); ++f) {
+            const double now = f * frameInterval;
+            while (next < frames.size() && next * frameInterval + latency <= now + 1e-9) {
+                tracker.update(frames[next], next * frameInterval);
+                applied = next + 1;
+                next += stride;
+            }
+            if (applied == 0 || (applied == f + 1 && lead == 0)) continue; // Nothing yet, or this frame's own result
+            tracker.predictAt(now, predicted);
+            tracker.predictAt(-std::numeric_limits<double>::infinity(), held); // Filtered positions, unmoved
+            const std::vector<Detection>& truth = frames[f + lead];
+            for (size_t i = 0; i < predicted.size() && i < held.size(); ++i) {
+                const Detection* det = nearest(truth, predicted[i]);
+                if (!det) continue;
+                const bool moving = predicted[i].moving(tracker.settings().stillSpeed);
+                (moving ? movingExtrapolated : restingExtrapolated).push_back(distance(predicted[i].center, center(*det)));
+                (moving ? movingHeld : restingHeld).push_back(distance(held[i].center, center(*det)));
+            }
+        }
+        std::printf("Extrapolation: detections every %d frame(s) of %.1f ms, %.1f ms result latency, %.1f ms lead\n",
+            stride, frameInterval * 1000.0, latency * 1000.0, compensation * 1000.0);
+        printErrors("moving balls", movingExtrapolated, movingHeld);
+        printErrors("resting balls", restingExtrapolated, restingHeld);
+    }
+};
+
+void printHeader() {
+    std::printf("%-14s %8s %10s %10s %10s %10s %10s\n", "stage", "count", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+}
+
+void printRow(const char* stage, const LatencyHistogram& h) {
+    std::printf("%-14s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", stage, (unsigned long long)h.count(),
+        h.mean() / 1000.0, h.percentile(50) / 1000.0, h.percentile(95) / 1000.0,
+        h.percentile(99) / 1000.0, h.max() / 1000.0);
+}
+
+constexpr int replayBankBounces = 2; // Cushions followed by the object-ball shot path
+
+// Everything downstream of inference: detections -> tracker -> scene -> guideline / shot path / rollout
+struct ReplayScene {
+    BallTracker tracker;
+    std::vector<TrackedBall> balls;
+    std::vector<Ball> others;
+    int targetId = -1;
+    Simulator simulator;
+    SimResult rollout;
+    ShotRanking ranking;
+    Table table;
+    CushionTable cushions;
+    SimState layout;
+    GuideBuffer guide, path, rolloutPath;
+    MotionParams motion;
+    Trajectory cueMotion;             // Cue ball alone with slide / roll / spin, no spin input yet: stun
+    GuideBuffer cuePath;
+    uint64_t cueSegments = 0, cuePlans = 0;
+    ShotEnsemble ensemble;
+    ShotUncertainty uncertainty;
+    GuideBuffer cone;
+    LatencyHistogram ensembleTime;     // Computed runs only (not cache hits)
+    double pocketProbabilitySum = 0.0;
+    uint64_t ensembleFrames = 0;
+
+    std::unique_ptr<PhysicsCache> cache;  // Absent with --no-cache
+    std::unique_ptr<ShotSweeper> sweeper; // --sweep
+    std::vector<SweepOutcome> sweep;
+    LatencyHistogram sweepTime;
+    size_t sweepSize = 0;
+    int pocketingAngles = 0;
+};
+
+// Tracks are predicted to now: call after BallTracker::update, or on a display tick without one
+void runPhysics(ReplayScene& scene, const std::vector<Detection>& detections, int frameWidth, int frameHeight) {
+    Ball cueBall{}, targetBall{};
+    Table& table = scene.table;
+    {
+        CHETO_TRACE_SCOPE("processDetections");
+        scene.tracker.predictAt(pipelineSeconds(PipelineClock::now()), scene.balls);
+        processTrackedScene(detections, scene.balls, scene.targetId, cueBall, targetBall, table, frameWidth, frameHeight,
+            &scene.others, &scene.ranking);
+        scene.cushions.update(table, detections, frameWidth, frameHeight);
+    }
+    CHETO_TRACE_SCOPE("physics");
+    const GuideBall cueGuide = toGuideBall(cueBall), targetGuide = toGuideBall(targetBall);
+    const GuideTable tableGuide = toGuideTable(table, &scene.cushions);
+    PhysicsCache* cache = scene.cache.get();
+    if (cache) {
+        cache->guideline(cueGuide, targetGuide, tableGuide);
+        cache->shotPath(cueGuide, targetGuide, tableGuide, replayBankBounces);
+    }
+    else {
+        calculateGuideline(cueGuide, targetGuide, tableGuide, scene.guide);
+        Physics::predictShotPath(cueGuide, targetGuide, tableGuide, scene.path, replayBankBounces);
+    }
+    scene.rolloutPath.clear();
+    const RankedShot* shot = scene.ranking.findBall(scene.targetId);
+    if (cueBall.radius > 0.0f && scene.targetId >= 0) {
+        toSimLayout(cueBall, targetBall, scene.others, scene.layout);
+        const GuidePoint aim = shot ? GuidePoint{ shot->ghostX, shot->ghostY }
+                                    : Physics::computeGhostBall(cueGuide, targetGuide);
+        if (cache)
+            cache->rollout(scene.layout, cueBall.radius, tableGuide, aim, simulatedShotSpeed, scene.simulator);
+        else
+            simulateShot(scene.layout, cueBall.radius, tableGuide, aim, simulatedShotSpeed, scene.simulator,
+                scene.rollout, scene.rolloutPath);
+        if (cueBallTrajectory(cueGuide, aim, simulatedShotSpeed, 0.0f, 0.0f, tableGuide, scene.motion,
+                scene.cueMotion, scene.cuePath)) {
+            scene.cueSegments += scene.cueMotion.count;
+            ++scene.cuePlans;
+        }
+        if (shot && shot->pocket < tableGuide.pocketCount) {
+            const EnsembleShot ensembleShot = toEnsembleShot(detections, cueBall, targetBall, *shot, table,
+                frameWidth, frameHeight, scene.ensemble.settings());
+            if (cache) scene.uncertainty = cache->uncertainty(scene.ensemble, ensembleShot);
+            else scene.ensemble.evaluate(ensembleShot, scene.uncertainty);
+            uncertaintyConeGuideline(targetGuide, tableGuide.pockets[shot->pocket], scene.uncertainty, scene.cone);
+            if (!cache || !cache->lastHit()) scene.ensembleTime.add(scene.uncertainty.microseconds);
+            scene.pocketProbabilitySum += scene.uncertainty.pocketProbability;
+            ++scene.ensembleFrames;
+        }
+    }
+
+    SimTable simTable;
+    if (scene.sweeper && cueBall.radius > 0.0f && scene.targetId >= 0 && !scene.tracker.anyMoving()
+        && toSimTable(tableGuide, simTable)) {
+        const std::vector<SweepOutcome>* sweep = &scene.sweep;
+        if (cache) sweep = &cache->sweep(*scene.sweeper, scene.layout, simTable, SweepConfig());
+        else scene.sweeper->sweep(scene.layout, simTable, SweepConfig(), scene.sweep);
+        if (!cache || !cache->lastHit()) scene.sweepTime.add(scene.sweeper->stats().microseconds);
+        scene.pocketingAngles = 0;
+        for (const SweepOutcome& o : *sweep)
+            if ((o.pocketed & ~1u) && !o.scratch) ++scene.pocketingAngles;
+        scene.sweepSize = sweep->size();
+    }
+}
+
+// Cold start = the optimized graph was built this launch; run twice to see the warm start
+void printStartupSummary(const ONNXInference& inference, int warmupRuns) {
+    const InferenceStartup& startup = inference.startupTimings();
+    std::printf("Model start (%s): session %.1f ms, warm-up %d runs %.1f ms (first %.1f ms), first frame %.1f ms\n",
+        startup.fromCache ? "warm, optimized model loaded" : startup.cacheWritten ? "cold, optimized model saved"
+                                                                                   : "cold, no optimized model cache",
+        startup.sessionMs, warmupRuns, startup.warmupMs, startup.firstRunMs, startup.firstFrameMs);
+    if (startup.fromCache || startup.cacheWritten) std::printf("             %s\n", startup.cachePath.c_str());
+}
+
+void printCushionSummary(const ReplayScene& scene) {
+    static const char* sources[] = { "none", "PlayArea box", "pocket hull", "PlayArea mask" };
+    std::printf("Cushions: %d edges from %s, rebuilt %llu times\n", scene.cushions.size(),
+        sources[static_cast<int>(scene.cushions.source())], (unsigned long long)scene.cushions.rebuilds());
+    if (scene.cuePlans > 0)
+        std::printf("Cue motion: %llu paths, %.1f segments each\n", (unsigned long long)scene.cuePlans,
+            double(scene.cueSegments) / scene.cuePlans);
+}
+
+void printEnsembleSummary(const ReplayScene& scene) {
+    if (scene.ensembleFrames == 0) return;
+    std::printf("Shot ensemble: %llu runs of %d samples, mean %.1f us, p95 %.1f us; mean P(pocket) %.2f;"
+                " last cone [%.1f, %.1f] deg\n",
+        (unsigned long long)scene.ensembleTime.count(), scene.ensemble.sampleCount(), scene.ensembleTime.mean(),
+        scene.ensembleTime.percentile(95), scene.pocketProbabilitySum / scene.ensembleFrames,
+        scene.uncertainty.coneLowDegrees, scene.uncertainty.coneHighDegrees);
+}
+
+void printCacheSummary(const ReplayScene& scene) {
+    if (!scene.cache) return;
+    const PhysicsCache& cache = *scene.cache;
+    const CacheStats total = cache.totals();
+    std::printf("Physics cache: hit rate %.2f (guideline %.2f, rollout %.2f, ensemble %.2f, sweep %.2f),"
+                " %llu evictions, %.0f KB\n",
+        total.hitRate(), cache.guideStats().hitRate(), cache.rolloutStats().hitRate(),
+        cache.ensembleStats().hitRate(), cache.sweepStats().hitRate(), (unsigned long long)total.evictions,
+        cache.bytes() / 1024.0);
+}
+
+void printSweepSummary(const ReplayScene& scene) {
+    if (!scene.sweeper) return;
+    std::printf("Shot sweep: %llu sweeps of %zu angles on %d workers, mean %.2f ms, p95 %.2f ms;"
+                " last layout: %d angles pocket a ball\n",
+        (unsigned long long)scene.sweepTime.count(), scene.sweepSize, scene.sweeper->workerCount(),
+        scene.sweepTime.mean() / 1000.0, scene.sweepTime.percentile(95) / 1000.0, scene.pocketingAngles);
+}
+
+int runSequential(ReplayDetector& detector, FrameSource& source, const ReplayOptions& options) {
+    LatencyHistogram grab, preprocess, run, decode, mask, scene, total;
+    ReplayScene replayScene;
+    CalibrationDump calibration;
+    calibration.directory = options.calibrationDir;
+    ExtrapolationProbe probe;
+    probe.stride = options.extrapolateStride;
+    probe.frameInterval = options.fps > 0.0 ? 1.0 / options.fps
+                        : source.frameInterval() > 0.0 ? source.frameInterval() : 1.0 / 60.0;
+    probe.latency = options.resultLatencyMs / 1000.0;
+    probe.compensation = options.compensationMs / 1000.0;
+    replayScene.tracker.settings().latencyCompensation = probe.compensation;
+    if (options.sweep) replayScene.sweeper = std::make_unique<ShotSweeper>();
+    if (options.cache) replayScene.cache = std::make_unique<PhysicsCache>();
+    auto wallStart = PipelineClock::now();
+    uint64_t frames = 0;
+
+    CHETO_TRACE_THREAD("replay");
+    while (true) {
+        cv::Mat frame;
+        CHETO_TRACE_FRAME(frames);
+        auto t0 = PipelineClock::now();
+        CaptureStatus status;
+        {
+            CHETO_TRACE_SCOPE("capture");
+            status = source.grab(frame);
+        }
+        auto t1 = PipelineClock::now();
+        if (status == CaptureStatus::EndOfStream) break;
+        if (status == CaptureStatus::NoFrame) continue;
+
+        std::vector<Detection> detections = detector.run(frame, source.lastChanges());
+        const bool reused = detector.lastReused();
+        auto t2 = PipelineClock::now();
+        probe.add(detections);
+        replayScene.tracker.update(detections, pipelineSeconds(t1));
+        if (!reused || replayScene.tracker.anyMoving()) // Same detections and nothing moving: same result
+            runPhysics(replayScene, detections, frame.cols, frame.rows);
+        auto t3 = PipelineClock::now();
+
+        grab.add(elapsedUs(t0, t1));
+        if (!reused) {
+            if (&detector.lastModel() == &detector.inference) calibration.add(detector.inference);
+            const InferenceTimings& timings = detector.lastModel().lastTimings();
+            preprocess.add(timings.preprocessUs);
+            run.add(timings.runUs);
+            decode.add(timings.decodeUs);
+            mask.add(timings.maskUs);
+            scene.add(elapsedUs(t2, t3));
+        }
+        total.add(elapsedUs(t1, t3));
+        ++frames;
+    }
+
+    double wallSeconds = elapsedUs(wallStart, PipelineClock::now()) / 1e6;
+    printHeader();
+    printRow("grab/decode", grab);
+    printRow("preprocess", preprocess);
+    printRow("session.Run", run);
+    printRow("yolo decode", decode);
+    printRow("masks", mask);
+    printRow("scene+physics", scene);
+    printRow("frame total", total);
+    std::printf("\n%llu frames in %.2f s: %.1f frames/s (excluding grab: %.1f frames/s)\n",
+        (unsigned long long)frames, wallSeconds, wallSeconds > 0 ? frames / wallSeconds : 0.0,
+        total.mean() > 0 ? 1e6 / total.mean() : 0.0);
+    printCushionSummary(replayScene);
+    printEnsembleSummary(replayScene);
+    printCacheSummary(replayScene);
+    printSweepSummary(replayScene);
+    probe.report();
+    if (!calibration.directory.empty())
+        std::printf("Calibration: %d model inputs written to %s\n", calibration.written, calibration.directory.c_str());
+    return frames > 0 ? 0 : 1;
+}
+
+int runPipelined(ReplayDetector& detector, FrameSource& source, const ReplayOptions& options) {
+    LatencyHistogram endToEnd, inferenceStage;
+    ReplayScene replayScene;
+    if (options.sweep) replayScene.sweeper = std::make_unique<ShotSweeper>();
+    if (options.cache) replayScene.cache = std::make_unique<PhysicsCache>();
+    PipelineConfig config;
+    config.dropStale = false; // Replay every frame
+    config.displayHz = options.displayHz;
+    replayScene.tracker.settings().latencyCompensation = options.compensationMs / 1000.0;
+    std::vector<Detection> lastDetections; // Newest packet, redrawn on display ticks
+    int frameWidth = 0, frameHeight = 0;
+
+    FramePipeline pipeline(
+        [&source](cv::Mat& image, FrameChanges& changes, FrameLease& lease) {
+            CaptureStatus status = source.grab(image);
+            changes = source.lastChanges();
+            lease = source.lastLease();
+            return status;
+        },
+        [&detector](const FramePacket& frame, DetectionPacket& result) {
+            result.detections = detector.run(frame.image, frame.changes);
+            result.reused = detector.lastReused();
+        },
+        [&](const DetectionPacket& packet) {
+            replayScene.tracker.update(packet.detections, pipelineSeconds(packet.captureTime));
+            lastDetections = packet.detections;
+            frameWidth = packet.frameWidth;
+            frameHeight = packet.frameHeight;
+            if (!packet.reused || replayScene.tracker.anyMoving())
+                runPhysics(replayScene, packet.detections, packet.frameWidth, packet.frameHeight);
+            inferenceStage.add(elapsedUs(packet.captureTime, packet.inferenceDoneTime));
+            endToEnd.add(elapsedUs(packet.captureTime, PipelineClock::now()));
+        },
+        config);
+
+    pipeline.setDisplayTick([&](PipelineClock::time_point) {
+        if (replayScene.tracker.anyMoving()) runPhysics(replayScene, lastDetections, frameWidth, frameHeight);
+    });
+
+    auto wallStart = PipelineClock::now();
+    pipeline.start();
+    while (!pipeline.finished()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pipeline.stop();
+    double wallSeconds = elapsedUs(wallStart, PipelineClock::now()) / 1e6;
+
+    PipelineStats stats = pipeline.stats();
+    printHeader();
+    printRow("capture->infer", inferenceStage);
+    printRow("end-to-end", endToEnd);
+    std::printf("\n%llu frames in %.2f s: %.1f frames/s\n",
+        (unsigned long long)stats.rendered, wallSeconds, wallSeconds > 0 ? stats.rendered / wallSeconds : 0.0);
+    if (config.displayHz > 0.0)
+        std::printf("Display ticks: %llu redraws at %.0f Hz between detections\n",
+            (unsigned long long)stats.displayTicks, config.displayHz);
+    printCushionSummary(replayScene);
+    printEnsembleSummary(replayScene);
+    printCacheSummary(replayScene);
+    printSweepSummary(replayScene);
+    return stats.rendered > 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    // Calibration inputs and the extrapolation probe are collected in sequential mode
+    if (!options.calibrationDir.empty() || options.extrapolateStride > 0) options.pipelined = false;
+    std::unique_ptr<FrameSource> source = openRecording(options.recordingPath, options.loops);
+    if (!source) {
+        std::fprintf(stderr, "Could not open recording: %s\n", options.recordingPath.c_str());
+        return 1;
+    }
+
+    ONNXInference detector(options.modelPath, options.inference);
+    if (!detector.isSessionValid()) {
+        std::fprintf(stderr, "Failed to load ONNX model: %s\n", options.modelPath.c_str());
+        return 1;
+    }
+    if (options.masks) detector.setMaskClasses({ ObjectType::Guideline, ObjectType::PlayArea });
+
+    ReplayDetector replayDetector{ detector, nullptr, nullptr, nullptr, nullptr, {} };
+    if (options.tableRoi) {
+        TableRoiConfig roiConfig;
+        roiConfig.rectify = options.rectify;
+        replayDetector.tableRoi = std::make_unique<TableRoiTracker>(detector, roiConfig);
+    }
+    if (!options.fastModelPath.empty()) {
+        InferenceConfig fastConfig = options.inference;
+        fastConfig.inputSizes.clear();
+        replayDetector.fastInference = std::make_unique<ONNXInference>(options.fastModelPath, fastConfig);
+        if (!replayDetector.fastInference->isSessionValid()) {
+            std::fprintf(stderr, "Failed to load cascade model: %s\n", options.fastModelPath.c_str());
+            return 1;
+        }
+        replayDetector.fastInference->setClassTypes(options.fastClasses);
+        replayDetector.cascade = std::make_unique<CascadeDetector>(
+            [&replayDetector](const cv::Mat& frame) { return replayDetector.detectFast(frame); },
+            [&replayDetector](const cv::Mat& frame) { return replayDetector.detectHeavy(frame); });
+    }
+    if (options.gate) {
+        TableRoiTracker* tableRoi = replayDetector.tableRoi.get();
+        replayDetector.gate = std::make_unique<GatedDetector>(
+            [&replayDetector](const cv::Mat& frame) { return replayDetector.detect(frame); },
+            GateConfig(),
+            [tableRoi]() { return tableRoi && tableRoi->locked() ? tableRoi->roi() : cv::Rect(); });
+    }
+
+    std::string inputSizes;
+    for (const cv::Size& size : detector.inputSizes())
+        inputSizes += (inputSizes.empty() ? "" : ", ") + std::to_string(size.width) + "x" + std::to_string(size.height);
+    std::printf("Replaying %s (%s, %s model input %s%s)\n\n", source->describe().c_str(),
+        options.pipelined ? "pipelined" : "sequential", modelPrecisionName(detector.precision()),
+        inputSizes.c_str(), options.tableRoi ? ", table ROI" : "");
+    if (replayDetector.cascade)
+        std::printf("Cascade: fast model %s, input %dx%d\n\n", options.fastModelPath.c_str(),
+            replayDetector.fastInference->inputSize().width, replayDetector.fastInference->inputSize().height);
+    int result = options.pipelined ? runPipelined(replayDetector, *source, options)
+                                   : runSequential(replayDetector, *source, options);
+    printStartupSummary(detector, options.inference.warmupRuns);
+
+    if (replayDetector.tableRoi) {
+        const TableRoiStats& roi = replayDetector.tableRoi->stats();
+        std::printf("Table ROI: %llu full-frame, %llu crop (%llu with the table at the frame border), %llu locks,"
+            " %llu lost\n", (unsigned long long)roi.fullFrames, (unsigned long long)roi.roiFrames,
+            (unsigned long long)roi.atFrameBorder, (unsigned long long)roi.locks, (unsigned long long)roi.lostLocks);
+    }
+    if (replayDetector.cascade) {
+        const CascadeStats& cascade = replayDetector.cascade->stats();
+        std::printf("Cascade: heavy model on %llu of %llu frames (%.1f%%):", (unsigned long long)cascade.heavyRuns,
+            (unsigned long long)cascade.frames, cascade.frames ? 100.0 * cascade.heavyRuns / cascade.frames : 0.0);
+        for (int t = 1; t < static_cast<int>(CascadeTrigger::Count); ++t)
+            std::printf(" %s %llu%s", cascadeTriggerName(static_cast<CascadeTrigger>(t)),
+                (unsigned long long)cascade.triggers[t], t + 1 < static_cast<int>(CascadeTrigger::Count) ? "," : "\n");
+        std::printf("         %.2f ms/frame mean (fast %.2f ms, heavy %.2f ms per run), %llu heavy boxes carried over\n",
+            cascade.meanFrameUs() / 1000.0, cascade.fastRuns ? cascade.fastUs / cascade.fastRuns / 1000.0 : 0.0,
+            cascade.heavyRuns ? cascade.heavyUs / cascade.heavyRuns / 1000.0 : 0.0,
+            (unsigned long long)cascade.keptDetections);
+    }
+    if (replayDetector.gate) {
+        const GateStats& gate = replayDetector.gate->stats();
+        std::printf("Change gate: inference skipped on %llu of %llu frames (%.1f%%), gate cost %.3f ms/frame,\n"
+                    "             ~%.1f ms CPU saved at %.2f ms per inference\n",
+            (unsigned long long)gate.skipped, (unsigned long long)gate.frames,
+            gate.frames ? 100.0 * gate.skipped / gate.frames : 0.0,
+            gate.frames ? gate.gateUs / gate.frames / 1000.0 : 0.0,
+            gate.savedUs() / 1000.0, gate.meanInferenceUs() / 1000.0);
+    }
+
+    if (!options.tracePath.empty()) {
+        if (traceWriteChromeJson(options.tracePath))
+            std::printf("Trace written to %s\n", options.tracePath.c_str());
+        else
+            std::fprintf(stderr, "No trace written (%s)\n", traceEnabled() ? "cannot open file" : "built without CHETO_TRACING");
+    }
+    return result;
+}
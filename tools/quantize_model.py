@@ -0,0 +1,123 @@
+"""Builds the FP16 / INT8 variants of a YOLO ONNX model for ONNXInference.
+
+The result is written next to the model as <model>.fp16.onnx or <model>.int8.onnx, which is
+where InferenceConfig::precision looks for it. Input and outputs stay float32 in every variant.
+
+  python tools/quantize_model.py yolov11mseg.onnx fp16
+  python tools/quantize_model.py yolov11mseg.onnx int8 --calibration calib/
+  python tools/quantize_model.py yolov11mseg.onnx int8-dynamic
+
+Static INT8 needs calibration inputs. These are model inputs as ONNXInference feeds them,
+written by `ChetoReplay <model> <recording> --calibrate calib/`. Record them from real matches
+with the table ROI mode you actually run. Dynamic INT8 needs no calibration, but it only
+quantizes weights, and ONNX Runtime runs its integer convolutions slowly on most CPUs.
+
+Requires: onnx, onnxruntime, numpy, and onnxconverter-common (fp16 only).
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+
+import numpy as np
+import onnx
+
+
+def variant_path(model_path, suffix):
+    stem, _ = os.path.splitext(model_path)
+    return stem + "." + suffix + ".onnx"
+
+
+def head_nodes(model):
+    """Nodes of the last /model.N/ module: the detect / segment head.
+
+    Box regression, the DFL and the class sigmoid there lose the most accuracy when
+    quantized, and they are a small part of the run time.
+    """
+    pattern = re.compile(r"^/model\.(\d+)/")
+    modules = [int(m.group(1)) for node in model.graph.node for m in [pattern.match(node.name)] if m]
+    if not modules:
+        return []
+    prefix = "/model.%d/" % max(modules)
+    return [node.name for node in model.graph.node if node.name.startswith(prefix)]
+
+
+def convert_fp16(model_path, output_path):
+    from onnxconverter_common import float16
+
+    model = onnx.load(model_path)
+    model = float16.convert_float_to_float16(model, keep_io_types=True)
+    onnx.save(model, output_path)
+
+
+def quantize_int8(model_path, output_path, calibration_dir, method, keep_head_float):
+    from onnxruntime.quantization import (CalibrationDataReader, CalibrationMethod, QuantFormat, QuantType,
+                                          quantize_static)
+    from onnxruntime.quantization.shape_inference import quant_pre_process
+
+    files = sorted(glob.glob(os.path.join(calibration_dir, "*.npy")))
+    if not files:
+        sys.exit("no .npy calibration inputs in %s (see ChetoReplay --calibrate)" % calibration_dir)
+
+    prepared = variant_path(model_path, "int8-prep")
+    quant_pre_process(model_path, prepared)
+    model = onnx.load(prepared)
+    input_name = model.graph.input[0].name
+    exclude = head_nodes(model) if keep_head_float else []
+
+    class NpyReader(CalibrationDataReader):
+        def __init__(self):
+            self.index = 0
+
+        def get_next(self):
+            if self.index >= len(files):
+                return None
+            data = np.load(files[self.index]).astype(np.float32)
+            self.index += 1
+            return {input_name: data}
+
+        def rewind(self):
+            self.index = 0
+
+    methods = {"minmax": CalibrationMethod.MinMax, "entropy": CalibrationMethod.Entropy,
+               "percentile": CalibrationMethod.Percentile}
+    quantize_static(prepared, output_path, NpyReader(), quant_format=QuantFormat.QDQ, per_channel=True,
+                    activation_type=QuantType.QUInt8, weight_type=QuantType.QInt8,
+                    nodes_to_exclude=exclude, calibrate_method=methods[method])
+    os.remove(prepared)
+    print("calibrated on %d inputs, %d head nodes kept in float" % (len(files), len(exclude)))
+
+
+def quantize_int8_dynamic(model_path, output_path):
+    from onnxruntime.quantization import QuantType, quantize_dynamic
+
+    quantize_dynamic(model_path, output_path, weight_type=QuantType.QInt8)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("model", help="FP32 .onnx model")
+    parser.add_argument("mode", choices=["fp16", "int8", "int8-dynamic"])
+    parser.add_argument("--calibration", help="directory of .npy model inputs (int8)")
+    parser.add_argument("--method", choices=["minmax", "entropy", "percentile"], default="minmax",
+                        help="activation range calibration (int8, default minmax)")
+    parser.add_argument("--quantize-head", action="store_true",
+                        help="also quantize the detect / segment head (int8)")
+    args = parser.parse_args()
+
+    output_path = variant_path(args.model, "fp16" if args.mode == "fp16" else "int8")
+    if args.mode == "fp16":
+        convert_fp16(args.model, output_path)
+    elif args.mode == "int8":
+        if not args.calibration:
+            sys.exit("int8 needs --calibration (or use int8-dynamic)")
+        quantize_int8(args.model, output_path, args.calibration, args.method, not args.quantize_head)
+    else:
+        quantize_int8_dynamic(args.model, output_path)
+    print("wrote", output_path)
+
+
+if __name__ == "__main__":
+    main()